@@ -13,7 +13,29 @@ function(CppHttpLib)
     GIT_TAG a609330e4c6374f741d3b369269f7848255e1954 # v0.14.1
     GIT_SHALLOW TRUE
   )
+
+  # Response compression: httplib enables gzip/deflate (zlib) and brotli when the
+  # libraries are found and then decompresses response bodies while receiving them.
+  # Variables set here are inherited by the httplib subproject (policy CMP0077).
+  set(HTTPLIB_USE_ZLIB_IF_AVAILABLE ${LP_HTTP_COMPRESSION})
+  set(HTTPLIB_USE_BROTLI_IF_AVAILABLE ${LP_HTTP_COMPRESSION})
   
   FetchContent_MakeAvailable(httplib)
+
+  # httplib records what it found in directory-scoped variables of its own project
+  get_directory_property(_httplib_brotli DIRECTORY ${httplib_SOURCE_DIR} DEFINITION HTTPLIB_IS_USING_BROTLI)
+  get_directory_property(_httplib_zlib DIRECTORY ${httplib_SOURCE_DIR} DEFINITION HTTPLIB_IS_USING_ZLIB)
+  set(_httplib_encodings "")
+  if(_httplib_brotli)
+    list(APPEND _httplib_encodings "br")
+  endif()
+  if(_httplib_zlib)
+    list(APPEND _httplib_encodings "gzip" "deflate")
+  endif()
+  if(_httplib_encodings)
+    message(STATUS "HTTP response compression: ${_httplib_encodings}")
+  else()
+    message(STATUS "HTTP response compression: disabled")
+  endif()
   
 endfunction()
@@ -0,0 +1,19 @@
+function(Simdjson)
+  # Check if simdjson is already available to avoid redundant fetches
+  if(TARGET simdjson::simdjson)
+    return()
+  endif()
+
+  include(FetchContent)
+
+  FetchContent_Declare(
+    simdjson
+    SYSTEM
+    GIT_REPOSITORY https://github.com/simdjson/simdjson
+    GIT_TAG v3.10.1
+    GIT_SHALLOW TRUE
+  )
+
+  FetchContent_MakeAvailable(simdjson)
+
+endfunction()
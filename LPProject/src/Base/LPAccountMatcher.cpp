@@ -0,0 +1,256 @@
+/**
+ * @file LPAccountMatcher.cpp
+ * @brief Implementation of the Logipad/Keycloak account matcher
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPAccountMatcher.hpp>
+#include <LPEmail.hpp>
+#include <LPHash.hpp>
+#include <LPLazyUsers.hpp>
+#include <LPWorkerThreads.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <unordered_map>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            using Account = auth::KeycloakClient::Account;
+
+            // Below this many rows per thread the thread start-up cost dominates
+            const std::size_t kMinRowsPerThread = 4096;
+
+            // Partitions per thread; more partitions balance skewed key distributions
+            const std::size_t kPartitionsPerThread = 8;
+
+            // Trim white space and lower-case ASCII letters (SIMD, see foldAsciiLower())
+            std::string normalizeKey(std::string_view value)
+            {
+                std::string key;
+                EmailNormalizer().normalize(value, key);
+                return key;
+            }
+
+            // Run fn(begin, end) over contiguous ranges on up to threads threads
+            template <typename Fn>
+            void parallelRanges(std::size_t count, unsigned threads, Fn &&fn)
+            {
+                std::size_t chunks = std::min<std::size_t>(threads, std::max<std::size_t>(1, count / kMinRowsPerThread));
+                std::size_t size = (count + chunks - 1) / std::max<std::size_t>(1, chunks);
+                core::runTasks(chunks, [&](std::size_t c)
+                               { fn(c * size, std::min(count, (c + 1) * size)); });
+            }
+
+            /**
+             * @struct Side
+             * @brief Join keys of one input
+             */
+            struct Side
+            {
+                std::vector<std::string> keys;    ///< Normalized key per row, empty if none
+                std::vector<std::uint8_t> open;   ///< Row not matched yet
+                std::vector<std::uint64_t> hashes;
+            };
+
+            /**
+             * @brief Hash the open rows and group them by partition
+             * @details Counting sort into one contiguous index array; rows keep their
+             *          ascending order within each partition.
+             */
+            void partition(Side &side, std::size_t partitions, unsigned threads, std::vector<std::uint32_t> &rows, std::vector<std::size_t> &offsets)
+            {
+                std::size_t count = side.keys.size();
+                side.hashes.assign(count, 0);
+                parallelRanges(count, threads, [&](std::size_t begin, std::size_t end)
+                               {
+                                   for (std::size_t i = begin; i < end; ++i)
+                                   {
+                                       if (side.open[i] && !side.keys[i].empty())
+                                       {
+                                           side.hashes[i] = io::xxh64(side.keys[i]);
+                                       }
+                                   } });
+
+                offsets.assign(partitions + 1, 0);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    if (side.open[i] && !side.keys[i].empty())
+                    {
+                        ++offsets[(side.hashes[i] & (partitions - 1)) + 1];
+                    }
+                }
+                for (std::size_t p = 0; p < partitions; ++p)
+                {
+                    offsets[p + 1] += offsets[p];
+                }
+                rows.resize(offsets[partitions]);
+                std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    if (side.open[i] && !side.keys[i].empty())
+                    {
+                        rows[fill[side.hashes[i] & (partitions - 1)]++] = static_cast<std::uint32_t>(i);
+                    }
+                }
+            }
+
+            /**
+             * @brief Join the open rows of both sides on their keys
+             * @details Workers claim partitions from a shared counter. Per partition the
+             *          accounts are inserted into a hash table (the first account of a key
+             *          wins) and the users probe it in ascending order; a matched account
+             *          is taken, so later users with the same key stay unmatched. A row
+             *          belongs to exactly one partition, so workers never write the same
+             *          element of open.
+             */
+            void join(Side &users, Side &accounts, AccountMatcher::MatchKey key, unsigned threads, std::vector<AccountMatcher::Match> &matches)
+            {
+                std::size_t partitions = 1;
+                while (partitions < threads * kPartitionsPerThread)
+                {
+                    partitions <<= 1;
+                }
+                std::vector<std::uint32_t> userRows, accountRows;
+                std::vector<std::size_t> userOffsets, accountOffsets;
+                partition(users, partitions, threads, userRows, userOffsets);
+                partition(accounts, partitions, threads, accountRows, accountOffsets);
+
+                std::vector<std::vector<AccountMatcher::Match>> found(partitions);
+                std::atomic<std::size_t> next{0};
+                auto worker = [&](std::size_t)
+                {
+                    std::unordered_map<std::string_view, std::uint32_t> table;
+                    for (std::size_t p = next++; p < partitions; p = next++)
+                    {
+                        table.clear();
+                        table.reserve(accountOffsets[p + 1] - accountOffsets[p]);
+                        for (std::size_t r = accountOffsets[p]; r < accountOffsets[p + 1]; ++r)
+                        {
+                            table.try_emplace(accounts.keys[accountRows[r]], accountRows[r]);
+                        }
+                        for (std::size_t r = userOffsets[p]; r < userOffsets[p + 1]; ++r)
+                        {
+                            std::uint32_t user = userRows[r];
+                            auto it = table.find(users.keys[user]);
+                            if (it == table.end() || !accounts.open[it->second])
+                            {
+                                continue;
+                            }
+                            accounts.open[it->second] = 0;
+                            users.open[user] = 0;
+                            found[p].push_back(AccountMatcher::Match{user, it->second, key});
+                        }
+                    }
+                };
+
+                std::size_t rows = userRows.size() + accountRows.size();
+                std::size_t workers = std::min<std::size_t>(threads, std::max<std::size_t>(1, rows / kMinRowsPerThread));
+                core::runTasks(workers, worker);
+                for (auto &part : found)
+                {
+                    matches.insert(matches.end(), part.begin(), part.end());
+                }
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        AccountMatcher::AccountMatcher(unsigned threads) : m_threads(threads)
+        {
+            if (m_threads == 0)
+            {
+                m_threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
+
+        // Fields read from Logipad users
+        UserFieldMask AccountMatcher::fields()
+        {
+            return UserFieldMask{UserField::Email, UserField::Name};
+        }
+
+        // Normalize an email address
+        std::string AccountMatcher::normalizeEmail(std::string_view email)
+        {
+            return normalizeKey(email);
+        }
+
+        // Match decoded users
+        void AccountMatcher::match(const std::vector<LogipadClient::User> &users, const std::vector<Account> &accounts, Result &result) const
+        {
+            run(users, users.size(), accounts, result);
+        }
+
+        // Match lazily decoded users
+        void AccountMatcher::match(const LazyUsers &users, const std::vector<Account> &accounts, Result &result) const
+        {
+            run(users, users.size(), accounts, result);
+        }
+
+        /**
+         * @brief Run both join phases
+         * @details Keys are normalized in parallel, then rows still open after the email
+         *          join take part in the username join.
+         */
+        template <typename Source>
+        void AccountMatcher::run(const Source &users, std::size_t count, const std::vector<Account> &accounts, Result &result) const
+        {
+            result = Result();
+            Side userEmails, userNames, accountEmails, accountNames;
+            userEmails.keys.resize(count);
+            userNames.keys.resize(count);
+            parallelRanges(count, m_threads, [&](std::size_t begin, std::size_t end)
+                           {
+                               for (std::size_t i = begin; i < end; ++i)
+                               {
+                                   auto &&user = users[i];
+                                   userEmails.keys[i] = normalizeKey(user.get(UserField::Email).value_or(std::string_view()));
+                                   userNames.keys[i] = normalizeKey(user.get(UserField::Name).value_or(std::string_view()));
+                               } });
+            accountEmails.keys.resize(accounts.size());
+            accountNames.keys.resize(accounts.size());
+            parallelRanges(accounts.size(), m_threads, [&](std::size_t begin, std::size_t end)
+                           {
+                               for (std::size_t i = begin; i < end; ++i)
+                               {
+                                   accountEmails.keys[i] = normalizeKey(accounts[i].email);
+                                   accountNames.keys[i] = normalizeKey(accounts[i].username);
+                               } });
+
+            userEmails.open.assign(count, 1);
+            accountEmails.open.assign(accounts.size(), 1);
+            join(userEmails, accountEmails, MatchKey::Email, m_threads, result.matched);
+
+            userNames.open = userEmails.open;
+            accountNames.open = accountEmails.open;
+            join(userNames, accountNames, MatchKey::Username, m_threads, result.matched);
+
+            std::sort(result.matched.begin(), result.matched.end(), [](const Match &a, const Match &b)
+                      { return a.user < b.user; });
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (userNames.open[i])
+                {
+                    result.usersOnly.push_back(i);
+                }
+            }
+            for (std::size_t i = 0; i < accounts.size(); ++i)
+            {
+                if (accountNames.open[i])
+                {
+                    result.accountsOnly.push_back(i);
+                }
+            }
+        }
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,468 @@
+/**
+ * @file LPActivityHistory.cpp
+ * @brief Implementation of the activity history store
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPActivityHistory.hpp>
+#include <LPBinaryIO.hpp>
+#include <LPUserTable.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // File header
+            const char kMagic[] = "LPACT001";
+            const std::size_t kMagicSize = sizeof(kMagic) - 1;
+
+            // Tracked fields by index; the last one is is_active
+            const UserField kTrackedFields[] = {
+                UserField::LastLoginAt,
+                UserField::LastActivityAt,
+                UserField::LastDocumentServiceActivity,
+                UserField::LastEformServiceActivity,
+                UserField::LastBriefingServiceActivity,
+                UserField::IsActive};
+            const std::uint8_t kActiveIndex = 5;
+
+            // Field byte flag of a cleared timestamp
+            const std::uint8_t kCleared = 0x80;
+
+            std::uint64_t zigzag(std::int64_t value)
+            {
+                return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+            }
+
+            std::int64_t unzigzag(std::uint64_t value)
+            {
+                return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+            }
+
+            // Base of a timestamp delta: the previous value, or 0 if it was missing
+            std::int64_t base(std::int64_t previous)
+            {
+                return previous == UserTable::kNoTime ? 0 : previous;
+            }
+
+            // Encode a change group relative to the values before it
+            void encodeChanges(std::string &out, const std::int64_t *values, const std::vector<ActivityHistory::Change> &changes)
+            {
+                io::putVarint(out, changes.size());
+                for (const auto &change : changes)
+                {
+                    out.push_back(static_cast<char>(change.field | (change.cleared ? kCleared : 0)));
+                    if (change.cleared)
+                    {
+                        continue;
+                    }
+                    if (change.field == kActiveIndex)
+                    {
+                        io::putVarint(out, static_cast<std::uint64_t>(change.value));
+                    }
+                    else
+                    {
+                        io::putVarint(out, zigzag(change.value - base(values[change.field])));
+                    }
+                }
+            }
+
+            // Decode a change group relative to the values before it
+            bool decodeChanges(io::Reader &in, const std::int64_t *values, std::vector<ActivityHistory::Change> &changes)
+            {
+                changes.clear();
+                std::uint64_t count = in.getVarint();
+                for (std::uint64_t i = 0; i < count && in.ok; ++i)
+                {
+                    ActivityHistory::Change change;
+                    auto byte = static_cast<std::uint8_t>(in.getInt(1));
+                    change.field = byte & ~kCleared;
+                    change.cleared = (byte & kCleared) != 0;
+                    if (change.field > kActiveIndex || (change.cleared && change.field == kActiveIndex))
+                    {
+                        in.ok = false;
+                        break;
+                    }
+                    if (change.cleared)
+                    {
+                        change.value = UserTable::kNoTime;
+                    }
+                    else if (change.field == kActiveIndex)
+                    {
+                        change.value = in.getVarint() != 0;
+                    }
+                    else
+                    {
+                        change.value = base(values[change.field]) + unzigzag(in.getVarint());
+                    }
+                    changes.push_back(change);
+                }
+                return in.ok;
+            }
+
+            // Values of a user not seen before
+            void resetValues(std::int64_t *values)
+            {
+                std::fill(values, values + kActiveIndex, UserTable::kNoTime);
+                values[kActiveIndex] = 0;
+            }
+        } // namespace
+
+        // Fields read by record()
+        UserFieldMask ActivityHistory::fields()
+        {
+            UserFieldMask mask{UserField::Guid};
+            for (UserField field : kTrackedFields)
+            {
+                mask.add(field);
+            }
+            return mask;
+        }
+
+        // Register a new user
+        std::uint32_t ActivityHistory::addUser(const std::string &guid)
+        {
+            auto id = static_cast<std::uint32_t>(m_users.size());
+            m_users.emplace_back();
+            m_users.back().guid = guid;
+            resetValues(m_users.back().values);
+            m_index.emplace(guid, id);
+            return id;
+        }
+
+        /**
+         * @brief Apply a change group
+         * @details Appends the group to the user's series (observation delta, then the
+         *          changes relative to the current values) and updates the values and
+         *          the transition index. The first group of a user is its initial state,
+         *          not a transition.
+         */
+        void ActivityHistory::apply(std::uint32_t user, std::int64_t observed, const std::vector<Change> &changes)
+        {
+            UserState &state = m_users[user];
+            bool first = state.series.empty();
+            io::putVarint(state.series, zigzag(observed - state.lastObserved));
+            encodeChanges(state.series, state.values, changes);
+            state.lastObserved = observed;
+            for (const auto &change : changes)
+            {
+                state.values[change.field] = change.value;
+                if (change.field == kActiveIndex && !first)
+                {
+                    m_transitions[change.value != 0].emplace_back(observed, user);
+                }
+            }
+        }
+
+        /**
+         * @brief Open and load a history file
+         * @details Batches are replayed through apply(). A truncated or corrupt tail is
+         *          cut off so that later appends start at a batch boundary.
+         */
+        bool ActivityHistory::open(const std::string &path)
+        {
+            m_path.clear();
+            m_users.clear();
+            m_index.clear();
+            m_transitions[0].clear();
+            m_transitions[1].clear();
+            m_lastObserved = INT64_MIN;
+
+            std::error_code ec;
+            if (!std::filesystem::exists(path, ec))
+            {
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                out.write(kMagic, static_cast<std::streamsize>(kMagicSize));
+                if (!out)
+                {
+                    m_lastError = "Cannot create history file " + path;
+                    return false;
+                }
+                m_path = path;
+                return true;
+            }
+
+            std::ifstream in(path, std::ios::binary);
+            std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (!in.good() && !in.eof())
+            {
+                m_lastError = "Cannot read history file " + path;
+                return false;
+            }
+            if (data.compare(0, kMagicSize, kMagic) != 0)
+            {
+                m_lastError = "Not a history file: " + path;
+                return false;
+            }
+
+            std::size_t good = kMagicSize;
+            std::vector<Change> changes;
+            while (good < data.size())
+            {
+                io::Reader header{data, good};
+                std::uint32_t length = header.getU32();
+                if (!header.ok || data.size() - header.pos < length)
+                {
+                    break;
+                }
+                std::string batch = data.substr(header.pos, length);
+                io::Reader reader{batch};
+                auto observed = static_cast<std::int64_t>(reader.getU64());
+                std::uint64_t count = reader.getVarint();
+                for (std::uint64_t i = 0; i < count && reader.ok; ++i)
+                {
+                    std::uint64_t id = reader.getVarint();
+                    if (id == m_users.size())
+                    {
+                        std::string guid = reader.getString();
+                        if (!reader.ok || m_index.count(guid) != 0)
+                        {
+                            reader.ok = false;
+                            break;
+                        }
+                        addUser(guid);
+                    }
+                    else if (id > m_users.size())
+                    {
+                        reader.ok = false;
+                        break;
+                    }
+                    if (decodeChanges(reader, m_users[id].values, changes))
+                    {
+                        apply(static_cast<std::uint32_t>(id), observed, changes);
+                    }
+                }
+                if (!reader.ok || reader.pos != batch.size())
+                {
+                    break;
+                }
+                m_lastObserved = observed;
+                good = header.pos + length;
+            }
+
+            if (good < data.size())
+            {
+                // Part of the broken batch may have been applied; reload from the intact prefix
+                std::filesystem::resize_file(path, good, ec);
+                if (ec)
+                {
+                    m_lastError = "Cannot truncate history file " + path + ": " + ec.message();
+                    return false;
+                }
+                return open(path);
+            }
+            m_path = path;
+            return true;
+        }
+
+        /**
+         * @brief Record a refresh
+         * @details Users are compared with their current values; only users with
+         *          changes are encoded. The batch is appended to the file before the
+         *          in-memory state is updated, so a failed write changes nothing.
+         */
+        bool ActivityHistory::record(const UserTable &table, std::int64_t observed)
+        {
+            m_lastChangeCount = 0;
+            const UserTable::TextColumn *guids = table.text(UserField::Guid);
+            const std::vector<std::int64_t> *times[kActiveIndex];
+            for (std::size_t f = 0; f < kActiveIndex; ++f)
+            {
+                times[f] = table.times(kTrackedFields[f]);
+            }
+            const std::vector<std::uint8_t> *active = table.flags(UserField::IsActive);
+            if (guids == nullptr || active == nullptr || std::find(times, times + kActiveIndex, nullptr) != times + kActiveIndex)
+            {
+                m_lastError = "Table lacks guid, is_active or an activity timestamp";
+                return false;
+            }
+            if (observed < m_lastObserved)
+            {
+                m_lastError = "Observation time precedes the last recorded refresh";
+                return false;
+            }
+
+            // A GUID listed more than once is recorded from its last row only, so every
+            // user appears at most once per batch
+            std::vector<std::size_t> lastRow(guids->dictionary.size(), 0);
+            for (std::size_t row = 0; row < table.size(); ++row)
+            {
+                lastRow[guids->codes[row]] = row;
+            }
+
+            // Collect the changes per user; new users get provisional ids
+            std::vector<std::pair<std::uint32_t, std::vector<Change>>> updates;
+            std::vector<std::string_view> addedGuids;
+            std::int64_t fresh[kTracked];
+            resetValues(fresh);
+            std::string batch;
+            std::size_t userCount = 0;
+            std::string entries;
+            for (std::size_t row = 0; row < table.size(); ++row)
+            {
+                std::uint32_t code = guids->codes[row];
+                if (code == 0 || lastRow[code] != row)
+                {
+                    continue;
+                }
+                const std::string &guid = guids->dictionary[code];
+                auto it = m_index.find(guid);
+                std::uint32_t id;
+                const std::int64_t *values;
+                bool isNew = it == m_index.end();
+                if (isNew)
+                {
+                    id = static_cast<std::uint32_t>(m_users.size() + addedGuids.size());
+                    addedGuids.push_back(guid);
+                    values = fresh;
+                }
+                else
+                {
+                    id = it->second;
+                    values = m_users[id].values;
+                }
+
+                std::vector<Change> changes;
+                for (std::uint8_t f = 0; f < kActiveIndex; ++f)
+                {
+                    std::int64_t value = (*times[f])[row];
+                    if (value != values[f])
+                    {
+                        changes.push_back(Change{f, value == UserTable::kNoTime, value});
+                    }
+                }
+                std::int64_t flag = (*active)[row];
+                if (flag != values[kActiveIndex])
+                {
+                    changes.push_back(Change{kActiveIndex, false, flag});
+                }
+                if (changes.empty() && !isNew)
+                {
+                    continue;
+                }
+
+                io::putVarint(entries, id);
+                if (isNew)
+                {
+                    io::putString(entries, guid);
+                }
+                encodeChanges(entries, values, changes);
+                ++userCount;
+                m_lastChangeCount += changes.size();
+                updates.emplace_back(id, std::move(changes));
+            }
+
+            if (!m_path.empty() && userCount > 0)
+            {
+                std::string body;
+                io::putU64(body, static_cast<std::uint64_t>(observed));
+                io::putVarint(body, userCount);
+                body += entries;
+                io::putU32(batch, static_cast<std::uint32_t>(body.size()));
+                batch += body;
+
+                std::ofstream out(m_path, std::ios::binary | std::ios::app);
+                out.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                out.flush();
+                if (!out)
+                {
+                    m_lastError = "Cannot append to history file " + m_path;
+                    m_lastChangeCount = 0;
+                    return false;
+                }
+            }
+
+            for (std::string_view guid : addedGuids)
+            {
+                addUser(std::string(guid));
+            }
+            for (const auto &[id, changes] : updates)
+            {
+                apply(id, observed, changes);
+            }
+            m_lastObserved = observed;
+            return true;
+        }
+
+        /**
+         * @brief Get the activity of a user
+         * @details Decodes the user's series from the start, replaying the values the
+         *          deltas refer to.
+         */
+        bool ActivityHistory::history(const std::string &guid, std::int64_t from, std::int64_t to, std::vector<Event> &events) const
+        {
+            events.clear();
+            auto it = m_index.find(guid);
+            if (it == m_index.end())
+            {
+                return false;
+            }
+
+            const std::string &series = m_users[it->second].series;
+            io::Reader reader{series};
+            std::int64_t values[kTracked];
+            resetValues(values);
+            std::int64_t observed = 0;
+            std::vector<Change> changes;
+            while (reader.ok && reader.pos < series.size())
+            {
+                observed += unzigzag(reader.getVarint());
+                if (!decodeChanges(reader, values, changes))
+                {
+                    break;
+                }
+                for (const auto &change : changes)
+                {
+                    values[change.field] = change.value;
+                    bool timestamp = change.field != kActiveIndex && !change.cleared;
+                    std::int64_t at = timestamp ? change.value : observed;
+                    if (at < from || at > to)
+                    {
+                        continue;
+                    }
+                    Event event;
+                    event.observed = observed;
+                    event.field = kTrackedFields[change.field];
+                    if (!change.cleared)
+                    {
+                        event.value = change.value;
+                    }
+                    events.push_back(event);
+                }
+            }
+            return true;
+        }
+
+        // Find is_active transitions
+        void ActivityHistory::transitions(bool active, std::int64_t from, std::int64_t to, std::vector<std::string> &guids) const
+        {
+            guids.clear();
+            const auto &list = m_transitions[active];
+            auto it = std::lower_bound(list.begin(), list.end(), std::make_pair(from, std::uint32_t(0)));
+            for (; it != list.end() && it->first <= to; ++it)
+            {
+                guids.push_back(m_users[it->second].guid);
+            }
+        }
+
+        // Size of the encoded series
+        std::size_t ActivityHistory::bytes() const
+        {
+            std::size_t total = 0;
+            for (const auto &user : m_users)
+            {
+                total += user.series.size();
+            }
+            return total;
+        }
+
+    } // namespace client
+} // namespace logipad
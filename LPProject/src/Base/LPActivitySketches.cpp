@@ -0,0 +1,262 @@
+/**
+ * @file LPActivitySketches.cpp
+ * @brief Implementation of the active-user sketch store
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPActivitySketches.hpp>
+#include <LPBinaryIO.hpp>
+#include <LPHash.hpp>
+#include <LPUserTable.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // File header of saved sketches
+            const char kMagic[] = "LPHLL001";
+            const std::size_t kMagicSize = sizeof(kMagic) - 1;
+
+            // Per-activity timestamp fields, in Activity order after Any
+            const UserField kServiceFields[] = {
+                UserField::LastDocumentServiceActivity,
+                UserField::LastEformServiceActivity,
+                UserField::LastBriefingServiceActivity};
+
+            // Timestamps that count as any activity
+            const UserField kAnyFields[] = {
+                UserField::LastLoginAt,
+                UserField::LastActivityAt,
+                UserField::LastDocumentServiceActivity,
+                UserField::LastEformServiceActivity,
+                UserField::LastBriefingServiceActivity};
+        } // namespace
+
+        // UTC day of a timestamp
+        std::int64_t ActivitySketches::dayOf(std::int64_t seconds)
+        {
+            return seconds >= 0 ? seconds / 86400 : -((-seconds + 86399) / 86400);
+        }
+
+        // Fields read by record()
+        UserFieldMask ActivitySketches::fields()
+        {
+            UserFieldMask mask{UserField::Guid};
+            for (UserField field : kAnyFields)
+            {
+                mask.add(field);
+            }
+            return mask;
+        }
+
+        /**
+         * @brief Record a snapshot
+         * @details Each GUID is hashed once. Sketches are looked up through a per-call
+         *          cache by day, since a snapshot touches few distinct days per activity.
+         */
+        bool ActivitySketches::record(const std::string &tenant, const UserTable &table)
+        {
+            const UserTable::TextColumn *guids = table.text(UserField::Guid);
+            const std::vector<std::int64_t> *any[std::size(kAnyFields)];
+            for (std::size_t f = 0; f < std::size(kAnyFields); ++f)
+            {
+                any[f] = table.times(kAnyFields[f]);
+                if (any[f] == nullptr)
+                {
+                    m_lastError = std::string("Table lacks ") + userFieldName(kAnyFields[f]);
+                    return false;
+                }
+            }
+            if (guids == nullptr)
+            {
+                m_lastError = "Table lacks guid";
+                return false;
+            }
+
+            std::vector<std::uint64_t> hashes(guids->dictionary.size());
+            for (std::size_t code = 1; code < hashes.size(); ++code)
+            {
+                hashes[code] = io::xxh64(guids->dictionary[code]);
+            }
+
+            std::unordered_map<std::int64_t, io::HyperLogLog *> days[4];
+            auto sketch = [&](Activity activity, std::int64_t day) -> io::HyperLogLog &
+            {
+                auto &cache = days[static_cast<std::size_t>(activity)];
+                auto it = cache.find(day);
+                if (it == cache.end())
+                {
+                    it = cache.emplace(day, &m_sketches[Key(tenant, activity, day)]).first;
+                }
+                return *it->second;
+            };
+
+            for (std::size_t row = 0; row < table.size(); ++row)
+            {
+                std::uint32_t code = guids->codes[row];
+                if (code == 0)
+                {
+                    continue;
+                }
+                std::uint64_t hash = hashes[code];
+
+                std::int64_t seen[std::size(kAnyFields)];
+                std::size_t seenCount = 0;
+                for (std::size_t f = 0; f < std::size(kAnyFields); ++f)
+                {
+                    std::int64_t time = (*any[f])[row];
+                    if (time == UserTable::kNoTime)
+                    {
+                        continue;
+                    }
+                    std::int64_t day = dayOf(time);
+                    if (std::find(seen, seen + seenCount, day) == seen + seenCount)
+                    {
+                        seen[seenCount++] = day;
+                        sketch(Activity::Any, day).addHash(hash);
+                    }
+                }
+                for (std::size_t s = 0; s < std::size(kServiceFields); ++s)
+                {
+                    std::int64_t time = (*table.times(kServiceFields[s]))[row];
+                    if (time != UserTable::kNoTime)
+                    {
+                        sketch(static_cast<Activity>(s + 1), dayOf(time)).addHash(hash);
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Estimate distinct active users
+         * @details For one tenant the range is a contiguous run of the ordered map;
+         *          for all tenants every tenant's run is merged.
+         */
+        double ActivitySketches::estimate(const std::string &tenant, Activity activity, std::int64_t firstDay, std::int64_t lastDay) const
+        {
+            io::HyperLogLog merged;
+            auto mergeTenant = [&](const std::string &name)
+            {
+                auto it = m_sketches.lower_bound(Key(name, activity, firstDay));
+                for (; it != m_sketches.end() && std::get<0>(it->first) == name && std::get<1>(it->first) == activity &&
+                       std::get<2>(it->first) <= lastDay;
+                     ++it)
+                {
+                    merged.merge(it->second);
+                }
+            };
+
+            if (!tenant.empty())
+            {
+                mergeTenant(tenant);
+            }
+            else
+            {
+                for (auto it = m_sketches.begin(); it != m_sketches.end();)
+                {
+                    std::string name = std::get<0>(it->first);
+                    mergeTenant(name);
+                    it = m_sketches.upper_bound(Key(name, Activity::Briefing, INT64_MAX));
+                }
+            }
+            return std::round(merged.estimate());
+        }
+
+        // Drop old sketches
+        std::size_t ActivitySketches::prune(std::int64_t firstDay)
+        {
+            return std::erase_if(m_sketches, [&](const auto &entry)
+                                 { return std::get<2>(entry.first) < firstDay; });
+        }
+
+        /**
+         * @brief Save the sketches
+         * @details Layout: magic, u32 sketch count, then per sketch the tenant
+         *          (u32-length-prefixed), activity byte, u64 day and the serialized sketch.
+         */
+        bool ActivitySketches::save(const std::string &path) const
+        {
+            std::string data(kMagic, kMagicSize);
+            io::putU32(data, static_cast<std::uint32_t>(m_sketches.size()));
+            for (const auto &[key, sketch] : m_sketches)
+            {
+                io::putString(data, std::get<0>(key));
+                data.push_back(static_cast<char>(std::get<1>(key)));
+                io::putU64(data, static_cast<std::uint64_t>(std::get<2>(key)));
+                sketch.serialize(data);
+            }
+
+            std::string temp = path + ".tmp";
+            {
+                std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+                out.write(data.data(), static_cast<std::streamsize>(data.size()));
+                if (!out)
+                {
+                    m_lastError = "Cannot write sketch file " + temp;
+                    return false;
+                }
+            }
+            std::error_code ec;
+            std::filesystem::rename(temp, path, ec);
+            if (ec)
+            {
+                m_lastError = "Cannot write sketch file " + path + ": " + ec.message();
+                std::filesystem::remove(temp, ec);
+                return false;
+            }
+            return true;
+        }
+
+        // Load saved sketches
+        bool ActivitySketches::load(const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+            {
+                m_lastError = "Cannot open sketch file " + path;
+                return false;
+            }
+            std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (data.compare(0, kMagicSize, kMagic) != 0)
+            {
+                m_lastError = "Not a sketch file: " + path;
+                return false;
+            }
+
+            io::Reader reader{data, kMagicSize};
+            std::map<Key, io::HyperLogLog> sketches;
+            std::uint32_t count = reader.getU32();
+            for (std::uint32_t i = 0; i < count && reader.ok; ++i)
+            {
+                std::string tenant = reader.getString();
+                auto activity = reader.getInt(1);
+                auto day = static_cast<std::int64_t>(reader.getU64());
+                if (activity > static_cast<std::uint64_t>(Activity::Briefing))
+                {
+                    reader.ok = false;
+                    break;
+                }
+                sketches[Key(std::move(tenant), static_cast<Activity>(activity), day)].deserialize(reader);
+            }
+            if (!reader.ok)
+            {
+                m_lastError = "Corrupt sketch file: " + path;
+                return false;
+            }
+            m_sketches = std::move(sketches);
+            return true;
+        }
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,447 @@
+/**
+ * @file LPBulkProvisioner.cpp
+ * @brief Implementation of journaled bulk provisioning
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPBulkProvisioner.hpp>
+#include <LPRosterValidator.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <unordered_map>
+
+namespace logipad
+{
+    namespace auth
+    {
+
+        namespace
+        {
+            using State = ProvisioningJournal::State;
+
+            // Check whether an entry needs no further request
+            bool isFinished(State state)
+            {
+                return state == State::Created || state == State::Existed || state == State::Failed;
+            }
+
+            // Check whether a failed request says something about the entry itself rather
+            // than about the server or the session (which would fail every entry alike)
+            bool isEntryError(int status)
+            {
+                return status >= 400 && status < 500 && status != 401 && status != 403 && status != 408 && status != 429;
+            }
+
+            // Current time in seconds since the Unix epoch
+            std::int64_t now()
+            {
+                return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            }
+
+            // Join the messages of validation issues
+            std::string joinIssues(const std::vector<RosterValidator::Issue> &issues)
+            {
+                std::string message;
+                for (const auto &issue : issues)
+                {
+                    message += (message.empty() ? "" : "; ") + issue.message;
+                }
+                return message;
+            }
+
+            // Split a CSV line; double-quoted fields may contain commas and doubled quotes
+            std::vector<std::string> splitCsv(const std::string &line)
+            {
+                std::vector<std::string> fields(1);
+                bool quoted = false;
+                for (std::size_t i = 0; i < line.size(); ++i)
+                {
+                    char c = line[i];
+                    if (quoted)
+                    {
+                        if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+                        {
+                            fields.back() += '"';
+                            ++i;
+                        }
+                        else if (c == '"')
+                        {
+                            quoted = false;
+                        }
+                        else
+                        {
+                            fields.back() += c;
+                        }
+                    }
+                    else if (c == '"')
+                    {
+                        quoted = true;
+                    }
+                    else if (c == ',')
+                    {
+                        fields.emplace_back();
+                    }
+                    else if (c != '\r')
+                    {
+                        fields.back() += c;
+                    }
+                }
+                return fields;
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        BulkProvisioner::BulkProvisioner(KeycloakClient &client, const Options &options) : m_client(client),
+                                                                                             m_options(options)
+        {
+        }
+
+        /**
+         * @brief Create the users of a roster
+         * @details Each group is filled with the next unfinished entries: entries failing
+         *          local validation get their outcome right away, the others an intent.
+         *          The group is committed, then its requests are sent; their outcomes are
+         *          committed with the next group.
+         */
+        bool BulkProvisioner::run(const std::vector<KeycloakClient::UserInfo> &roster, const std::string &realm, Summary &summary)
+        {
+            summary = Summary();
+            m_lastError.clear();
+            if (!m_journal.open(m_options.journalPath, !m_options.resume) ||
+                !m_journal.begin(ProvisioningJournal::fingerprint(roster), roster.size(), realm))
+            {
+                m_lastError = m_journal.getLastError();
+                return false;
+            }
+            if (!m_options.deadLetterPath.empty() && !m_deadLetters.open(m_options.deadLetterPath))
+            {
+                m_lastError = m_deadLetters.getLastError();
+                return false;
+            }
+
+            // Problems found locally, by roster index
+            std::vector<RosterValidator::Issue> issues;
+            RosterValidator().validate(roster, issues);
+            std::vector<std::string> problems(roster.size());
+            for (const auto &issue : issues)
+            {
+                problems[issue.row] += (problems[issue.row].empty() ? "" : "; ") + issue.message;
+            }
+
+            const auto &entries = m_journal.entries();
+            summary.finished = static_cast<std::size_t>(std::count_if(entries.begin(), entries.end(), [](const auto &entry)
+                                                                      { return isFinished(entry.state); }));
+
+            std::size_t groupSize = std::max<std::size_t>(1, m_options.groupSize);
+            std::vector<std::size_t> group;
+            std::size_t next = 0;
+            for (;;)
+            {
+                group.clear();
+                for (; next < roster.size() && group.size() < groupSize; ++next)
+                {
+                    if (isFinished(entries[next].state))
+                    {
+                        continue;
+                    }
+                    if (!problems[next].empty())
+                    {
+                        Attempt rejected;
+                        rejected.error = problems[next];
+                        if (!deadLetter(roster[next], realm, rejected, false))
+                        {
+                            return false;
+                        }
+                        m_journal.outcome(next, State::Failed, 0, problems[next]);
+                        ++summary.failed;
+                        continue;
+                    }
+                    m_journal.intent(next);
+                    group.push_back(next);
+                }
+                if (!m_journal.commit())
+                {
+                    m_lastError = m_journal.getLastError();
+                    return false;
+                }
+                if (group.empty())
+                {
+                    return true;
+                }
+
+                for (std::size_t index : group)
+                {
+                    if (m_options.call.stopped())
+                    {
+                        // Entries of the group not sent yet keep their intent and are sent on resume
+                        m_lastError = "Provisioning stopped at entry " + std::to_string(index) + ": " + m_options.call.stopReason();
+                        if (!m_journal.commit())
+                        {
+                            m_lastError += "; " + m_journal.getLastError();
+                        }
+                        return false;
+                    }
+                    Attempt attempt = create(roster[index], realm);
+                    if (attempt.created)
+                    {
+                        m_journal.outcome(index, State::Created, attempt.status, "");
+                        ++summary.created;
+                    }
+                    else if (attempt.status == 409)
+                    {
+                        m_journal.outcome(index, State::Existed, attempt.status, "");
+                        ++summary.existed;
+                    }
+                    else if (isEntryError(attempt.status))
+                    {
+                        if (!deadLetter(roster[index], realm, attempt, true))
+                        {
+                            return false;
+                        }
+                        m_journal.outcome(index, State::Failed, attempt.status, attempt.error);
+                        ++summary.failed;
+                    }
+                    else
+                    {
+                        // Unreachable server or unusable session: leave the rest for a resume
+                        m_lastError = "Provisioning stopped at entry " + std::to_string(index) + " (" + roster[index].username +
+                                      "): " + attempt.error;
+                        if (!m_journal.commit())
+                        {
+                            m_lastError += "; " + m_journal.getLastError();
+                        }
+                        return false;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Create the users of the dead-letter file again
+         * @details The file always holds the failed letters of the finished batches
+         *          followed by the letters not processed yet. Letters are matched with the
+         *          roster by username, so corrections made in the roster are picked up.
+         */
+        bool BulkProvisioner::redrive(const std::vector<KeycloakClient::UserInfo> &roster, Summary &summary)
+        {
+            summary = Summary();
+            m_lastError.clear();
+            if (!m_deadLetters.open(m_options.deadLetterPath))
+            {
+                m_lastError = m_deadLetters.getLastError();
+                return false;
+            }
+
+            // The letters carry no passwords; take the users from the roster again
+            std::unordered_map<std::string, std::size_t> rows;
+            for (std::size_t row = 0; row < roster.size(); ++row)
+            {
+                rows.emplace(roster[row].username, row);
+            }
+
+            std::vector<DeadLetterQueue::Letter> pending = m_deadLetters.letters();
+            std::vector<DeadLetterQueue::Letter> kept;
+            RosterValidator validator;
+            std::vector<RosterValidator::Issue> issues;
+            std::size_t batchSize = std::max<std::size_t>(1, m_options.redriveBatchSize);
+            for (std::size_t begin = 0; begin < pending.size(); begin += batchSize)
+            {
+                std::size_t end = std::min(pending.size(), begin + batchSize);
+                bool stopped = false;
+                for (std::size_t i = begin; i < end && !stopped; ++i)
+                {
+                    DeadLetterQueue::Letter &letter = pending[i];
+                    Attempt attempt;
+                    auto row = rows.find(letter.user.username);
+                    bool sent = row != rows.end() && validator.validate(roster[row->second], issues);
+                    if (sent && !m_options.call.stopped())
+                    {
+                        attempt = create(roster[row->second], letter.realm);
+                    }
+                    else if (row == rows.end())
+                    {
+                        attempt.error = "User is not in the roster";
+                    }
+                    else if (!sent)
+                    {
+                        attempt.error = joinIssues(issues);
+                    }
+
+                    if (!attempt.created && m_options.call.stopped())
+                    {
+                        // Keep this letter and the rest as they are
+                        m_lastError = "Re-drive stopped at " + letter.user.username + ": " + m_options.call.stopReason();
+                        end = i;
+                        stopped = true;
+                        break;
+                    }
+
+                    if (attempt.created)
+                    {
+                        ++summary.created;
+                        continue;
+                    }
+                    if (attempt.status == 409)
+                    {
+                        ++summary.existed;
+                        continue;
+                    }
+                    if (row != rows.end())
+                    {
+                        letter.user = roster[row->second];
+                    }
+                    letter.time = now();
+                    letter.errorClass = DeadLetterQueue::classify(attempt.status, sent);
+                    letter.status = attempt.status;
+                    letter.error = attempt.error;
+                    letter.attempts += attempt.requests;
+                    kept.push_back(letter);
+                    ++summary.failed;
+                    if (sent && !isEntryError(attempt.status))
+                    {
+                        // Unreachable server or unusable session: keep the rest for a later re-drive
+                        m_lastError = "Re-drive stopped at " + letter.user.username + ": " + attempt.error;
+                        end = i + 1;
+                        stopped = true;
+                    }
+                }
+
+                std::vector<DeadLetterQueue::Letter> remaining = kept;
+                remaining.insert(remaining.end(), pending.begin() + static_cast<std::ptrdiff_t>(end), pending.end());
+                if (!m_deadLetters.replace(remaining))
+                {
+                    m_lastError = m_deadLetters.getLastError();
+                    return false;
+                }
+                if (stopped)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Create one user with retries
+         * @details A 401 response is retried once right away (the client dropped its
+         *          token and authenticates again); transient failures are retried after the
+         *          backoff of the retry policy. No retry is started whose backoff would end
+         *          after the deadline of the entry, and cancellation cuts the backoff short.
+         */
+        BulkProvisioner::Attempt BulkProvisioner::create(const KeycloakClient::UserInfo &user, const std::string &realm)
+        {
+            net::CallContext call{m_options.call.deadline.earliest(net::Deadline::after(m_options.entryTimeout)), m_options.call.cancel};
+            Attempt attempt;
+            bool reauthenticated = false;
+            for (int transient = 1;; ++transient)
+            {
+                attempt.created = m_client.createUser(user, realm, call);
+                attempt.status = m_client.getLastStatus();
+                attempt.error = m_client.getLastError();
+                ++attempt.requests;
+                if (!attempt.created && attempt.status == 401 && !reauthenticated)
+                {
+                    reauthenticated = true;
+                    --transient;
+                    continue;
+                }
+                if (attempt.created || !net::RetryPolicy::isRetryable(attempt.status) || transient >= m_options.retry.maxAttempts ||
+                    call.stopped())
+                {
+                    return attempt;
+                }
+                std::chrono::milliseconds delay = m_options.retry.delay(transient);
+                if (delay >= call.deadline.remaining() || !call.cancel.waitFor(delay))
+                {
+                    return attempt;
+                }
+            }
+        }
+
+        // Add a failed entry to the dead-letter file, if one is set
+        bool BulkProvisioner::deadLetter(const KeycloakClient::UserInfo &user, const std::string &realm, const Attempt &attempt, bool sent)
+        {
+            if (m_options.deadLetterPath.empty())
+            {
+                return true;
+            }
+            DeadLetterQueue::Letter letter;
+            letter.time = now();
+            letter.realm = realm;
+            letter.errorClass = DeadLetterQueue::classify(attempt.status, sent);
+            letter.status = attempt.status;
+            letter.error = attempt.error;
+            letter.attempts = attempt.requests;
+            letter.user = user;
+            if (!m_deadLetters.add(letter))
+            {
+                m_lastError = m_deadLetters.getLastError();
+                if (!m_journal.commit())
+                {
+                    m_lastError += "; " + m_journal.getLastError();
+                }
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Read a roster
+         * @details Blank lines are skipped; missing trailing fields are left empty and
+         *          reported by validation.
+         */
+        bool BulkProvisioner::loadRoster(const std::string &path, std::vector<KeycloakClient::UserInfo> &roster, std::string &error)
+        {
+            roster.clear();
+            std::ifstream in(path);
+            std::string line;
+            if (!in || !std::getline(in, line))
+            {
+                error = "Cannot read roster " + path;
+                return false;
+            }
+
+            const char *const names[] = {"username", "email", "firstname", "lastname", "password"};
+            std::size_t columns[std::size(names)];
+            std::vector<std::string> header = splitCsv(line);
+            for (std::size_t n = 0; n < std::size(names); ++n)
+            {
+                auto it = std::find_if(header.begin(), header.end(), [&](std::string name)
+                                       {
+                    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c)
+                                   { return static_cast<char>(std::tolower(c)); });
+                    return name == names[n]; });
+                if (it == header.end())
+                {
+                    error = std::string("Roster ") + path + " lacks the column " + names[n];
+                    return false;
+                }
+                columns[n] = static_cast<std::size_t>(it - header.begin());
+            }
+
+            while (std::getline(in, line))
+            {
+                if (line.find_first_not_of(" \t\r") == std::string::npos)
+                {
+                    continue;
+                }
+                std::vector<std::string> fields = splitCsv(line);
+                fields.resize(std::max(fields.size(), header.size()));
+                KeycloakClient::UserInfo user;
+                user.username = fields[columns[0]];
+                user.email = fields[columns[1]];
+                user.firstName = fields[columns[2]];
+                user.lastName = fields[columns[3]];
+                user.password = fields[columns[4]];
+                roster.push_back(std::move(user));
+            }
+            return true;
+        }
+
+    } // namespace auth
+} // namespace logipad
@@ -0,0 +1,338 @@
+/**
+ * @file LPCachingTransport.cpp
+ * @brief Implementation of the on-disk response cache
+ * @details Cache entry layout (all integers little-endian):
+ *          - 8 byte magic "LPRSC001"
+ *          - key (string), ETag (string), Last-Modified (string), status (u32),
+ *            header count (u32), headers (string pairs), body (string)
+ *
+ *          Strings are stored as u32 length followed by the raw bytes. The key is
+ *          stored to detect file name hash collisions.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPCachingTransport.hpp>
+#include <LPBinaryIO.hpp>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace logipad
+{
+    namespace net
+    {
+
+        namespace
+        {
+            const char kMagic[] = "LPRSC001";
+            const std::size_t kMagicSize = sizeof(kMagic) - 1;
+
+            // Case-insensitive comparison of header names
+            bool sameHeader(const std::string &a, const char *b)
+            {
+                std::size_t i = 0;
+                for (; i < a.size() && b[i] != '\0'; ++i)
+                {
+                    if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+                    {
+                        return false;
+                    }
+                }
+                return i == a.size() && b[i] == '\0';
+            }
+
+            // Headers describing the transfer coding of a body
+            bool isCodingHeader(const std::string &name)
+            {
+                return sameHeader(name, "Content-Encoding") || sameHeader(name, "Content-Length");
+            }
+
+            // Build the lookup key of a resource
+            std::string makeKey(const std::string &endpoint, const std::string &path)
+            {
+                return endpoint + "\n" + path;
+            }
+
+            // Whether a request already carries a header
+            bool hasHeader(const httplib::Headers &headers, const char *name)
+            {
+                for (const auto &header : headers)
+                {
+                    if (sameHeader(header.first, name))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Write a new file readable by the owner only; fails if the file exists
+            bool writePrivate(const std::string &path, const std::string &data)
+            {
+#ifdef _WIN32
+                std::FILE *file = std::fopen(path.c_str(), "wb");
+#else
+                int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+                std::FILE *file = fd < 0 ? nullptr : fdopen(fd, "wb");
+                if (fd >= 0 && file == nullptr)
+                {
+                    ::close(fd);
+                }
+#endif
+                if (file == nullptr)
+                {
+                    return false;
+                }
+                bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+                return std::fclose(file) == 0 && ok;
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        ResponseCache::ResponseCache(const std::string &directory) : m_directory(directory)
+        {
+        }
+
+        /**
+         * @brief Create the cache directory
+         * @details On POSIX systems the directory itself is created with mode 0700, and
+         *          an existing one is restricted to it; parent directories keep the
+         *          default mode.
+         */
+        bool ResponseCache::open()
+        {
+            std::error_code ec;
+#ifdef _WIN32
+            std::filesystem::create_directories(m_directory, ec);
+#else
+            std::filesystem::path directory(m_directory);
+            if (directory.has_parent_path())
+            {
+                std::filesystem::create_directories(directory.parent_path(), ec);
+            }
+            if (!ec && ::mkdir(m_directory.c_str(), S_IRWXU) != 0 && errno != EEXIST)
+            {
+                ec = std::error_code(errno, std::generic_category());
+            }
+            if (!ec)
+            {
+                std::filesystem::permissions(directory, std::filesystem::perms::owner_all, std::filesystem::perm_options::replace, ec);
+            }
+#endif
+            if (ec || !std::filesystem::is_directory(m_directory))
+            {
+                m_lastError = "Cannot create cache directory " + m_directory + ": " + ec.message();
+                return false;
+            }
+            return true;
+        }
+
+        // File of a key
+        std::string ResponseCache::fileFor(const std::string &key) const
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.lpc", static_cast<unsigned long long>(io::fnv1a(key)));
+            return (std::filesystem::path(m_directory) / name).string();
+        }
+
+        /**
+         * @brief Look up a cached response
+         * @details Unreadable, corrupt or colliding entries are treated as misses.
+         */
+        bool ResponseCache::lookup(const std::string &endpoint, const std::string &path, Entry &entry) const
+        {
+            std::string key = makeKey(endpoint, path);
+            std::ifstream in(fileFor(key), std::ios::binary);
+            if (!in)
+            {
+                return false;
+            }
+
+            std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (data.compare(0, kMagicSize, kMagic) != 0)
+            {
+                return false;
+            }
+
+            io::Reader record{data, kMagicSize};
+            if (record.getString() != key)
+            {
+                return false;
+            }
+            entry.etag = record.getString();
+            entry.lastModified = record.getString();
+            entry.status = static_cast<int>(record.getU32());
+            entry.headers.clear();
+            std::uint32_t headerCount = record.getU32();
+            for (std::uint32_t i = 0; i < headerCount && record.ok; ++i)
+            {
+                std::string name = record.getString();
+                std::string value = record.getString();
+                entry.headers.emplace(std::move(name), std::move(value));
+            }
+            entry.body = record.getString();
+            return record.ok;
+        }
+
+        /**
+         * @brief Store a response
+         * @details The entry goes to a temporary file named after the writing thread
+         *          first and is then renamed over the previous entry. The temporary file
+         *          is created exclusively with mode 0600, so the entry never exists with
+         *          wider permissions.
+         */
+        bool ResponseCache::store(const std::string &endpoint, const std::string &path, const httplib::Response &response)
+        {
+            std::string etag = response.get_header_value("ETag");
+            std::string lastModified = response.get_header_value("Last-Modified");
+            if (etag.empty() && lastModified.empty())
+            {
+                return false;
+            }
+
+            std::string key = makeKey(endpoint, path);
+            std::string data(kMagic, kMagicSize);
+            io::putString(data, key);
+            io::putString(data, etag);
+            io::putString(data, lastModified);
+            io::putU32(data, static_cast<std::uint32_t>(response.status));
+
+            // The body has already been decompressed by httplib, so its coding headers no longer apply
+            httplib::Headers headers;
+            for (const auto &header : response.headers)
+            {
+                if (!isCodingHeader(header.first))
+                {
+                    headers.insert(header);
+                }
+            }
+            io::putU32(data, static_cast<std::uint32_t>(headers.size()));
+            for (const auto &header : headers)
+            {
+                io::putString(data, header.first);
+                io::putString(data, header.second);
+            }
+            io::putString(data, response.body);
+
+            std::string file = fileFor(key);
+            std::ostringstream temp;
+            temp << file << ".tmp" << std::this_thread::get_id();
+            // A leftover of an interrupted store() would keep its permissions
+            std::error_code ec;
+            std::filesystem::remove(temp.str(), ec);
+            if (!writePrivate(temp.str(), data))
+            {
+                m_lastError = "Cannot write cache entry " + temp.str();
+                std::filesystem::remove(temp.str(), ec);
+                return false;
+            }
+
+            std::filesystem::rename(temp.str(), file, ec);
+            if (ec)
+            {
+                m_lastError = "Cannot write cache entry " + file + ": " + ec.message();
+                std::filesystem::remove(temp.str(), ec);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Constructor implementation
+         */
+        CachingTransport::CachingTransport(
+            std::shared_ptr<ResponseCache> cache,
+            const std::string &endpoint,
+            std::unique_ptr<Transport> inner) : m_cache(std::move(cache)),
+                                                m_endpoint(endpoint),
+                                                m_inner(std::move(inner))
+        {
+        }
+
+        /**
+         * @brief Send a request
+         * @details A GET with a cached entry is sent with the entry's validators. A 304
+         *          answer is replaced by the cached response, marked with
+         *          kCacheStatusHeader. A 200 answer with validators refreshes the entry.
+         *          A request that already carries its own validator is sent unchanged
+         *          and its 304 answer is returned as is, since it refers to the caller's
+         *          copy rather than the cached one.
+         */
+        httplib::Result CachingTransport::send(const Request &request)
+        {
+            if (request.method != "GET")
+            {
+                return m_inner->send(request);
+            }
+
+            ResponseCache::Entry entry;
+            bool cached = !hasHeader(request.headers, "If-None-Match") &&
+                          !hasHeader(request.headers, "If-Modified-Since") &&
+                          m_cache->lookup(m_endpoint, request.path, entry);
+
+            Request conditional = request;
+            if (cached && !entry.etag.empty())
+            {
+                conditional.headers.emplace("If-None-Match", entry.etag);
+            }
+            if (cached && !entry.lastModified.empty())
+            {
+                conditional.headers.emplace("If-Modified-Since", entry.lastModified);
+            }
+
+            auto result = m_inner->send(conditional);
+            if (!result)
+            {
+                return result;
+            }
+
+            if (cached && result->status == 304)
+            {
+                auto response = std::make_unique<httplib::Response>();
+                response->status = entry.status;
+                response->headers = std::move(entry.headers);
+                response->body = std::move(entry.body);
+                response->set_header(kCacheStatusHeader, "revalidated");
+                return httplib::Result(std::move(response), httplib::Error::Success);
+            }
+
+            if (result->status == 200)
+            {
+                m_cache->store(m_endpoint, request.path, result.value());
+            }
+            return result;
+        }
+
+        // Forward timeouts to the wrapped transport
+        void CachingTransport::setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout)
+        {
+            m_inner->setTimeouts(connectTimeout, readTimeout);
+        }
+
+        // Caching factory
+        TransportFactory cachingTransportFactory(std::shared_ptr<ResponseCache> cache, TransportFactory inner)
+        {
+            return [cache, inner](const std::string &host, int port) -> std::unique_ptr<Transport>
+            {
+                std::string endpoint = host + ":" + std::to_string(port);
+                return std::make_unique<CachingTransport>(cache, endpoint, inner(host, port));
+            };
+        }
+
+    } // namespace net
+} // namespace logipad
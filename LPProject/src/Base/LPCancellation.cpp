@@ -0,0 +1,183 @@
+/**
+ * @file LPCancellation.cpp
+ * @brief Implementation of deadlines and cancellation tokens
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPCancellation.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @struct CancellationToken::State
+         * @brief State shared by the copies of a token
+         */
+        struct CancellationToken::State
+        {
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::atomic<bool> cancelled{false};
+            bool running = false; ///< Callbacks are being run by cancel()
+            std::size_t nextId = 1;
+            std::map<std::size_t, std::function<void()>> callbacks;
+            std::weak_ptr<State> parent; ///< Token this one was derived from with child()
+            std::size_t parentId = 0;    ///< Id of the callback registered with the parent
+
+            ~State()
+            {
+                // The parent's callback only holds a weak reference, so dropping it without
+                // waiting is safe even while the parent runs its callbacks
+                if (auto owner = parent.lock())
+                {
+                    std::lock_guard<std::mutex> lock(owner->mutex);
+                    owner->callbacks.erase(parentId);
+                }
+            }
+
+            void cancel()
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (cancelled)
+                {
+                    return;
+                }
+                cancelled = true;
+                running = true;
+                auto pending = std::move(callbacks);
+                callbacks.clear();
+                lock.unlock();
+                changed.notify_all();
+
+                for (auto &entry : pending)
+                {
+                    entry.second();
+                }
+
+                lock.lock();
+                running = false;
+                lock.unlock();
+                changed.notify_all();
+            }
+        };
+
+        // Deadline from now
+        Deadline Deadline::after(std::chrono::milliseconds timeout)
+        {
+            Deadline deadline;
+            if (timeout.count() > 0)
+            {
+                deadline.m_at = Clock::now() + timeout;
+            }
+            return deadline;
+        }
+
+        // Time left
+        std::chrono::milliseconds Deadline::remaining() const
+        {
+            if (!m_at)
+            {
+                return std::chrono::milliseconds::max();
+            }
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(*m_at - Clock::now());
+            return std::max(left, std::chrono::milliseconds(0));
+        }
+
+        // Earlier deadline
+        Deadline Deadline::earliest(const Deadline &other) const
+        {
+            if (!m_at)
+            {
+                return other;
+            }
+            if (!other.m_at)
+            {
+                return *this;
+            }
+            return *m_at <= *other.m_at ? *this : other;
+        }
+
+        /**
+         * @brief Constructor implementation
+         */
+        CancellationToken::CancellationToken() : m_state(std::make_shared<State>())
+        {
+        }
+
+        // Cancel
+        void CancellationToken::cancel() const
+        {
+            m_state->cancel();
+        }
+
+        // Check cancellation
+        bool CancellationToken::isCancelled() const
+        {
+            return m_state->cancelled;
+        }
+
+        // Interruptible sleep
+        bool CancellationToken::waitFor(std::chrono::milliseconds duration) const
+        {
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+            return !m_state->changed.wait_for(lock, duration, [this]
+                                              { return m_state->cancelled.load(); });
+        }
+
+        /**
+         * @brief Register a callback
+         * @details Id 0 is returned for callbacks that ran right away; removing it is a no-op.
+         */
+        std::size_t CancellationToken::onCancel(std::function<void()> callback) const
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_state->mutex);
+                if (!m_state->cancelled)
+                {
+                    std::size_t id = m_state->nextId++;
+                    m_state->callbacks.emplace(id, std::move(callback));
+                    return id;
+                }
+            }
+            callback();
+            return 0;
+        }
+
+        // Remove a callback, waiting for a running cancel() to finish its callbacks
+        void CancellationToken::removeCallback(std::size_t id) const
+        {
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+            m_state->callbacks.erase(id);
+            m_state->changed.wait(lock, [this]
+                                  { return !m_state->running; });
+        }
+
+        /**
+         * @brief Create a child token
+         * @details The parent keeps a callback holding a weak reference to the child;
+         *          the child removes it when its last copy is gone.
+         */
+        CancellationToken CancellationToken::child() const
+        {
+            CancellationToken token;
+            std::weak_ptr<State> weak = token.m_state;
+            token.m_state->parent = m_state;
+            token.m_state->parentId = onCancel([weak]
+                                               {
+                                                   if (auto state = weak.lock())
+                                                   {
+                                                       state->cancel();
+                                                   } });
+            return token;
+        }
+
+    } // namespace net
+} // namespace logipad
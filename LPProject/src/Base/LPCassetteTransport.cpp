@@ -0,0 +1,344 @@
+/**
+ * @file LPCassetteTransport.cpp
+ * @brief Implementation of the record/replay transport decorator
+ * @details Cassette file layout (all integers little-endian):
+ *          - 8 byte magic "LPCAS001"
+ *          - a sequence of records, each prefixed with its u32 payload length:
+ *            key (string), error (u32), status (u32), header count (u32),
+ *            headers (string pairs), body (string), elapsed microseconds (u64)
+ *
+ *          Strings are stored as u32 length followed by the raw bytes. A truncated
+ *          trailing record (e.g. from an interrupted recording) is ignored on load.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPCassetteTransport.hpp>
+#include <LPBinaryIO.hpp>
+#include <algorithm>
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace logipad
+{
+    namespace net
+    {
+
+        namespace
+        {
+            const char kMagic[] = "LPCAS001";
+            const std::size_t kMagicSize = sizeof(kMagic) - 1;
+
+            // Truncate or create a file readable by the owner only
+            std::FILE *openPrivate(const std::string &path)
+            {
+#ifdef _WIN32
+                return std::fopen(path.c_str(), "wb");
+#else
+                int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+                if (fd < 0)
+                {
+                    return nullptr;
+                }
+                // An existing file keeps its mode on open()
+                std::FILE *file = fchmod(fd, S_IRUSR | S_IWUSR) == 0 ? fdopen(fd, "wb") : nullptr;
+                if (file == nullptr)
+                {
+                    ::close(fd);
+                }
+                return file;
+#endif
+            }
+
+            // Write data and flush it to the operating system
+            bool writeAll(std::FILE *file, const std::string &data)
+            {
+                return std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        Cassette::Cassette(const std::string &path, Mode mode, Timing timing) : m_path(path),
+                                                                                 m_mode(mode),
+                                                                                 m_timing(timing)
+        {
+        }
+
+        /**
+         * @brief Destructor implementation
+         * @details Closes the cassette file; every record has already been flushed.
+         */
+        Cassette::~Cassette()
+        {
+            if (m_out != nullptr)
+            {
+                std::fclose(m_out);
+            }
+        }
+
+        // Last error, read under the lock since record() may set it concurrently
+        std::string Cassette::getLastError() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_lastError;
+        }
+
+        // Build the lookup key of a request
+        std::string Cassette::makeKey(const std::string &endpoint, const Request &request)
+        {
+            return endpoint + "\n" + request.method + "\n" + request.path + "\n" + std::to_string(io::fnv1a(request.body));
+        }
+
+        /**
+         * @brief Open the cassette file
+         * @details Record mode truncates the file, restricts it to mode 0600 on POSIX
+         *          systems and writes the magic. Replay mode loads every complete record
+         *          into the in-memory exchange table.
+         */
+        bool Cassette::open()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_lastError.clear();
+            m_exchanges.clear();
+
+            if (m_mode == Mode::Record)
+            {
+                if (m_out != nullptr)
+                {
+                    std::fclose(m_out);
+                }
+                m_out = openPrivate(m_path);
+                if (m_out == nullptr || !writeAll(m_out, std::string(kMagic, kMagicSize)))
+                {
+                    m_lastError = "Cannot open cassette for writing: " + m_path;
+                    return false;
+                }
+                return true;
+            }
+
+            std::ifstream in(m_path, std::ios::binary);
+            if (!in)
+            {
+                m_lastError = "Cannot open cassette for reading: " + m_path;
+                return false;
+            }
+
+            std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (data.compare(0, kMagicSize, kMagic) != 0)
+            {
+                m_lastError = "Not a cassette file: " + m_path;
+                return false;
+            }
+
+            io::Reader file{data, kMagicSize};
+            while (file.pos < data.size())
+            {
+                std::uint32_t size = file.getU32();
+                if (!file.ok || data.size() - file.pos < size)
+                {
+                    break; // truncated trailing record
+                }
+                std::string payload = data.substr(file.pos, size);
+                file.pos += size;
+
+                io::Reader record{payload};
+                std::string key = record.getString();
+                Exchange exchange;
+                exchange.error = static_cast<httplib::Error>(record.getU32());
+                exchange.status = static_cast<int>(record.getU32());
+                std::uint32_t headerCount = record.getU32();
+                for (std::uint32_t i = 0; i < headerCount && record.ok; ++i)
+                {
+                    std::string name = record.getString();
+                    std::string value = record.getString();
+                    exchange.headers.emplace(std::move(name), std::move(value));
+                }
+                exchange.body = record.getString();
+                exchange.elapsed = std::chrono::microseconds(record.getU64());
+
+                if (!record.ok)
+                {
+                    m_lastError = "Corrupt record in cassette: " + m_path;
+                    return false;
+                }
+                m_exchanges[key].push_back(std::move(exchange));
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Append an exchange to the cassette file
+         * @details Serializes the record into a buffer first so it reaches the file with
+         *          a single write. A failed write may leave a partial record, so the file is
+         *          closed and later exchanges are no longer recorded.
+         */
+        bool Cassette::record(
+            const std::string &endpoint,
+            const Request &request,
+            const httplib::Result &result,
+            std::chrono::microseconds elapsed)
+        {
+            std::string payload;
+            io::putString(payload, makeKey(endpoint, request));
+            io::putU32(payload, static_cast<std::uint32_t>(result.error()));
+            if (result)
+            {
+                io::putU32(payload, static_cast<std::uint32_t>(result->status));
+                io::putU32(payload, static_cast<std::uint32_t>(result->headers.size()));
+                for (const auto &header : result->headers)
+                {
+                    io::putString(payload, header.first);
+                    io::putString(payload, header.second);
+                }
+                io::putString(payload, result->body);
+            }
+            else
+            {
+                io::putU32(payload, static_cast<std::uint32_t>(-1));
+                io::putU32(payload, 0);
+                io::putString(payload, {});
+            }
+            io::putU64(payload, static_cast<std::uint64_t>(elapsed.count()));
+
+            std::string record;
+            record.reserve(payload.size() + 4);
+            io::putU32(record, static_cast<std::uint32_t>(payload.size()));
+            record += payload;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_out == nullptr)
+            {
+                return false;
+            }
+            if (!writeAll(m_out, record))
+            {
+                m_lastError = "Cannot write to cassette, recording stopped: " + m_path;
+                std::fclose(m_out);
+                m_out = nullptr;
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Replay the next recorded exchange matching a request
+         * @details The exchange is copied out under the lock; the optional delay for
+         *          original timing happens outside of it so concurrent transports replay
+         *          independently. A request whose context stops answers
+         *          httplib::Error::Canceled like HttpTransport.
+         */
+        httplib::Result Cassette::replay(const std::string &endpoint, const Request &request)
+        {
+            Exchange exchange;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_exchanges.find(makeKey(endpoint, request));
+                if (it == m_exchanges.end() || it->second.empty())
+                {
+                    return httplib::Result(nullptr, httplib::Error::Connection);
+                }
+                exchange = it->second.front();
+                if (it->second.size() > 1)
+                {
+                    it->second.pop_front();
+                }
+            }
+
+            if (m_timing == Timing::Original)
+            {
+                // Wait as long as the original request took, unless the call is cancelled or
+                // its deadline comes first
+                auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(exchange.elapsed);
+                auto left = request.context.deadline.remaining();
+                if (!request.context.cancel.waitFor(std::min(elapsed, left)) || elapsed > left)
+                {
+                    return httplib::Result(nullptr, httplib::Error::Canceled);
+                }
+            }
+            else if (request.context.stopped())
+            {
+                return httplib::Result(nullptr, httplib::Error::Canceled);
+            }
+
+            if (exchange.error != httplib::Error::Success)
+            {
+                return httplib::Result(nullptr, exchange.error);
+            }
+
+            auto response = std::make_unique<httplib::Response>();
+            response->status = exchange.status;
+            response->headers = std::move(exchange.headers);
+            response->body = std::move(exchange.body);
+            return httplib::Result(std::move(response), httplib::Error::Success);
+        }
+
+        /**
+         * @brief Constructor implementation
+         */
+        CassetteTransport::CassetteTransport(
+            std::shared_ptr<Cassette> cassette,
+            const std::string &endpoint,
+            std::unique_ptr<Transport> inner) : m_cassette(std::move(cassette)),
+                                                m_endpoint(endpoint),
+                                                m_inner(std::move(inner))
+        {
+        }
+
+        /**
+         * @brief Send a request
+         * @details Replay mode answers from the cassette. Record mode times the wrapped
+         *          transport and records the exchange before returning its result. A
+         *          failed recording does not fail the request; it is reported through the
+         *          cassette's getLastError().
+         */
+        httplib::Result CassetteTransport::send(const Request &request)
+        {
+            if (m_cassette->getMode() == Cassette::Mode::Replay || !m_inner)
+            {
+                return m_cassette->replay(m_endpoint, request);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto result = m_inner->send(request);
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+            m_cassette->record(m_endpoint, request, result, elapsed);
+            return result;
+        }
+
+        // Forward timeouts to the wrapped transport
+        void CassetteTransport::setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout)
+        {
+            if (m_inner)
+            {
+                m_inner->setTimeouts(connectTimeout, readTimeout);
+            }
+        }
+
+        // Cassette factory
+        TransportFactory cassetteTransportFactory(std::shared_ptr<Cassette> cassette, TransportFactory inner)
+        {
+            return [cassette, inner](const std::string &host, int port) -> std::unique_ptr<Transport>
+            {
+                std::string endpoint = host + ":" + std::to_string(port);
+                std::unique_ptr<Transport> wrapped;
+                if (cassette->getMode() == Cassette::Mode::Record)
+                {
+                    wrapped = inner(host, port);
+                }
+                return std::make_unique<CassetteTransport>(cassette, endpoint, std::move(wrapped));
+            };
+        }
+
+    } // namespace net
+} // namespace logipad
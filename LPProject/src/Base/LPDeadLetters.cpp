@@ -0,0 +1,283 @@
+/**
+ * @file LPDeadLetters.cpp
+ * @brief Implementation of the dead-letter file
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPDeadLetters.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace logipad
+{
+    namespace auth
+    {
+
+        namespace
+        {
+            const DeadLetterQueue::ErrorClass kClasses[] = {
+                DeadLetterQueue::ErrorClass::Validation,
+                DeadLetterQueue::ErrorClass::Rejected,
+                DeadLetterQueue::ErrorClass::Throttled,
+                DeadLetterQueue::ErrorClass::Server,
+                DeadLetterQueue::ErrorClass::Network,
+                DeadLetterQueue::ErrorClass::Auth};
+
+            // Serialize a letter as one line
+            std::string toLine(const DeadLetterQueue::Letter &letter)
+            {
+                nlohmann::json user;
+                user["username"] = letter.user.username;
+                user["email"] = letter.user.email;
+                user["firstName"] = letter.user.firstName;
+                user["lastName"] = letter.user.lastName;
+                user["enabled"] = letter.user.enabled;
+                user["emailVerified"] = letter.user.emailVerified;
+
+                nlohmann::json json;
+                json["time"] = letter.time;
+                json["realm"] = letter.realm;
+                json["class"] = DeadLetterQueue::errorClassName(letter.errorClass);
+                json["status"] = letter.status;
+                json["error"] = letter.error;
+                json["attempts"] = letter.attempts;
+                json["user"] = user;
+                return json.dump() + "\n";
+            }
+
+            // Parse one line
+            bool fromLine(const std::string &line, DeadLetterQueue::Letter &letter)
+            {
+                try
+                {
+                    auto json = nlohmann::json::parse(line);
+                    const auto &user = json.at("user");
+                    letter.time = json.value("time", std::int64_t(0));
+                    letter.realm = json.at("realm").get<std::string>();
+                    letter.status = json.value("status", 0);
+                    letter.error = json.value("error", "");
+                    letter.attempts = json.value("attempts", 0);
+                    letter.user.username = user.at("username").get<std::string>();
+                    letter.user.email = user.value("email", "");
+                    letter.user.firstName = user.value("firstName", "");
+                    letter.user.lastName = user.value("lastName", "");
+                    letter.user.enabled = user.value("enabled", true);
+                    letter.user.emailVerified = user.value("emailVerified", true);
+                    std::string name = json.value("class", "");
+                    letter.errorClass = DeadLetterQueue::ErrorClass::Rejected;
+                    for (auto errorClass : kClasses)
+                    {
+                        if (name == DeadLetterQueue::errorClassName(errorClass))
+                        {
+                            letter.errorClass = errorClass;
+                        }
+                    }
+                    return true;
+                }
+                catch (const std::exception &)
+                {
+                    return false;
+                }
+            }
+
+            // Open a file readable by its owner only; an existing file keeps its permissions
+            std::FILE *openPrivate(const std::string &path, bool append)
+            {
+#ifdef _WIN32
+                return std::fopen(path.c_str(), append ? "ab" : "wb");
+#else
+                int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), S_IRUSR | S_IWUSR);
+                if (fd < 0)
+                {
+                    return nullptr;
+                }
+                std::FILE *file = fdopen(fd, append ? "ab" : "wb");
+                if (file == nullptr)
+                {
+                    ::close(fd);
+                }
+                return file;
+#endif
+            }
+
+            // Write lines, optionally sync them to disk, and close the file
+            bool writeAndClose(std::FILE *file, const std::string &data, bool sync)
+            {
+                bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+#ifdef _WIN32
+                ok = ok && (!sync || _commit(_fileno(file)) == 0);
+#else
+                ok = ok && (!sync || fsync(fileno(file)) == 0);
+#endif
+                return std::fclose(file) == 0 && ok;
+            }
+        } // namespace
+
+        // Classify a failure
+        DeadLetterQueue::ErrorClass DeadLetterQueue::classify(int status, bool sent)
+        {
+            if (!sent)
+            {
+                return ErrorClass::Validation;
+            }
+            if (status == 0)
+            {
+                return ErrorClass::Network;
+            }
+            if (status == 401 || status == 403)
+            {
+                return ErrorClass::Auth;
+            }
+            if (status == 408 || status == 429)
+            {
+                return ErrorClass::Throttled;
+            }
+            return status >= 500 ? ErrorClass::Server : ErrorClass::Rejected;
+        }
+
+        // Name of an error class
+        const char *DeadLetterQueue::errorClassName(ErrorClass errorClass)
+        {
+            switch (errorClass)
+            {
+            case ErrorClass::Validation:
+                return "validation";
+            case ErrorClass::Rejected:
+                return "rejected";
+            case ErrorClass::Throttled:
+                return "throttled";
+            case ErrorClass::Server:
+                return "server";
+            case ErrorClass::Network:
+                return "network";
+            case ErrorClass::Auth:
+                return "auth";
+            }
+            return "rejected";
+        }
+
+        /**
+         * @brief Open a dead-letter file
+         * @details A last line without newline is the remainder of an interrupted append
+         *          and is ignored if it does not parse.
+         */
+        bool DeadLetterQueue::open(const std::string &path)
+        {
+            m_path = path;
+            m_letters.clear();
+            m_index.clear();
+            m_lastError.clear();
+
+            std::error_code ec;
+            if (!std::filesystem::exists(path, ec))
+            {
+                return true;
+            }
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+            {
+                m_lastError = "Cannot read dead-letter file " + path;
+                return false;
+            }
+            std::string line;
+            std::size_t number = 0;
+            while (std::getline(in, line))
+            {
+                ++number;
+                if (line.empty())
+                {
+                    continue;
+                }
+                Letter letter;
+                if (!fromLine(line, letter))
+                {
+                    if (in.eof())
+                    {
+                        break;
+                    }
+                    m_lastError = "Malformed dead letter in " + path + " line " + std::to_string(number);
+                    return false;
+                }
+                remember(letter);
+            }
+            return true;
+        }
+
+        // Keep a letter, merging with an earlier one for the same user
+        void DeadLetterQueue::remember(const Letter &letter)
+        {
+            auto [it, inserted] = m_index.try_emplace(letter.realm + '\n' + letter.user.username, m_letters.size());
+            if (inserted)
+            {
+                m_letters.push_back(letter);
+            }
+            else
+            {
+                m_letters[it->second] = letter;
+            }
+        }
+
+        // Append a letter
+        bool DeadLetterQueue::add(const Letter &letter)
+        {
+            std::FILE *out = openPrivate(m_path, true);
+            if (out == nullptr || !writeAndClose(out, toLine(letter), false))
+            {
+                m_lastError = "Cannot append to dead-letter file " + m_path;
+                return false;
+            }
+            remember(letter);
+            return true;
+        }
+
+        /**
+         * @brief Rewrite the file
+         * @details The temporary file is synced before the rename, so a crash cannot
+         *          leave a renamed but empty checkpoint.
+         */
+        bool DeadLetterQueue::replace(const std::vector<Letter> &letters)
+        {
+            std::string temp = m_path + ".tmp";
+            std::string data;
+            for (const auto &letter : letters)
+            {
+                data += toLine(letter);
+            }
+            // A leftover of an interrupted replace() would keep its permissions
+            std::error_code ignored;
+            std::filesystem::remove(temp, ignored);
+            std::FILE *out = openPrivate(temp, false);
+            if (out == nullptr || !writeAndClose(out, data, true))
+            {
+                m_lastError = "Cannot write dead-letter file " + temp;
+                return false;
+            }
+            std::error_code ec;
+            std::filesystem::rename(temp, m_path, ec);
+            if (ec)
+            {
+                m_lastError = "Cannot replace dead-letter file " + m_path + ": " + ec.message();
+                return false;
+            }
+
+            m_letters.clear();
+            m_index.clear();
+            for (const auto &letter : letters)
+            {
+                remember(letter);
+            }
+            return true;
+        }
+
+    } // namespace auth
+} // namespace logipad
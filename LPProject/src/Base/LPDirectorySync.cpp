@@ -0,0 +1,234 @@
+/**
+ * @file LPDirectorySync.cpp
+ * @brief Implementation of the incrementally synchronized user directory
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPDirectorySync.hpp>
+#include <LPJsonBackend.hpp>
+#include <LPJsonScan.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Format a digest for the snapshot; JSON numbers cannot hold all 64 bits reliably
+            std::string toHex(std::uint64_t value)
+            {
+                char text[17];
+                std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+                return text;
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        DirectorySync::DirectorySync(LogipadClient &client, const std::string &apiHost, int apiPort)
+            : m_client(client), m_apiHost(apiHost), m_apiPort(apiPort)
+        {
+        }
+
+        /**
+         * @brief Bring the directory up to date
+         * @details The modified_since filter is inclusive, so users modified exactly at
+         *          the watermark are fetched again; merging them is idempotent.
+         */
+        bool DirectorySync::refresh(const net::CallContext &call)
+        {
+            if (m_watermark.empty() || m_deltaUnsupported)
+            {
+                return fullSync(call);
+            }
+
+            LogipadClient::Users delta;
+            if (!m_client.queryUsers(delta, UserQuery().modifiedSince(m_watermark), m_apiHost, m_apiPort, call))
+            {
+                if (m_client.getLastStatus() == 400)
+                {
+                    m_deltaUnsupported = true;
+                    return fullSync(call);
+                }
+                m_lastError = call.stopped() ? "Delta sync stopped: " + call.stopReason()
+                                             : "Delta sync failed with HTTP status " + std::to_string(m_client.getLastStatus());
+                return false;
+            }
+
+            if (!delta.users.empty())
+            {
+                m_digest = 0;
+            }
+            merge(delta.users);
+            return true;
+        }
+
+        /**
+         * @brief Replace the directory with a full download
+         * @details The watermark is recomputed from the downloaded users.
+         */
+        bool DirectorySync::fullSync(const net::CallContext &call)
+        {
+            LogipadClient::Users all;
+            std::uint64_t digest = m_digest;
+            if (!m_client.refreshUsers(all, digest, m_apiHost, m_apiPort, UserFieldMask::all(), call))
+            {
+                m_lastError = call.stopped() ? "Full sync stopped: " + call.stopReason()
+                                             : "Full sync failed with HTTP status " + std::to_string(m_client.getLastStatus());
+                return false;
+            }
+            if (m_digest != 0 && digest == m_digest)
+            {
+                m_lastChangeCount = 0;
+                m_lastChanges.clear();
+                return true;
+            }
+
+            m_digest = digest;
+            m_users.clear();
+            m_index.clear();
+            m_watermark.clear();
+            merge(all.users);
+            return true;
+        }
+
+        // Look up a user by GUID
+        const LogipadClient::User *DirectorySync::find(const std::string &guid) const
+        {
+            auto it = m_index.find(guid);
+            return it == m_index.end() ? nullptr : &m_users[it->second];
+        }
+
+        /**
+         * @brief Merge changed users into the directory
+         * @details Known GUIDs are replaced in place, unknown ones appended.
+         */
+        void DirectorySync::merge(std::vector<LogipadClient::User> &delta)
+        {
+            m_users.reserve(m_users.size() + delta.size());
+            m_lastChanges.clear();
+            for (auto &user : delta)
+            {
+                advanceWatermark(user);
+                auto [it, inserted] = m_index.try_emplace(user.guid, m_users.size());
+                m_lastChanges.push_back(it->second);
+                if (inserted)
+                {
+                    m_users.push_back(std::move(user));
+                }
+                else
+                {
+                    m_users[it->second] = std::move(user);
+                }
+            }
+            m_lastChangeCount = delta.size();
+        }
+
+        /**
+         * @brief Raise the watermark to a user's modified_at
+         * @details Timestamps are ISO 8601 strings in a fixed format, so the lexicographic
+         *          order is the chronological order.
+         */
+        void DirectorySync::advanceWatermark(const LogipadClient::User &user)
+        {
+            if (user.modified_at.has_value() && *user.modified_at > m_watermark)
+            {
+                m_watermark = *user.modified_at;
+            }
+        }
+
+        /**
+         * @brief Write a snapshot
+         * @details The snapshot is a JSON object with "tenant", "watermark", "digest" (hex)
+         *          and a "users" array in the API format, so it is read back by the regular
+         *          parsers.
+         */
+        bool DirectorySync::save(const std::string &path) const
+        {
+            nlohmann::json snapshot;
+            snapshot["tenant"] = m_apiHost;
+            snapshot["watermark"] = m_watermark;
+            snapshot["digest"] = toHex(m_digest);
+            snapshot["users"] = nlohmann::json::array();
+            for (const auto &user : m_users)
+            {
+                snapshot["users"].push_back(user.toJson());
+            }
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out << snapshot.dump();
+            if (!out)
+            {
+                m_lastError = "Cannot write snapshot " + path;
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Restore a snapshot
+         * @details The header members are read with the structural scanner; the users
+         *          are parsed with the JSON backend selected at build time.
+         */
+        bool DirectorySync::load(const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in)
+            {
+                m_lastError = "Cannot open snapshot " + path;
+                return false;
+            }
+            std::ostringstream buffer;
+            buffer << in.rdbuf();
+            std::string body = buffer.str();
+
+            std::string tenant;
+            std::string watermark;
+            std::string digest;
+            std::size_t root = json::skipWhitespace(body, 0);
+            if (root >= body.size() || body[root] != '{' ||
+                json::forEachMember(body, root, [&](std::string_view key, json::Range value)
+                                    {
+                                        std::string *target = key == "tenant" ? &tenant : key == "watermark" ? &watermark : key == "digest" ? &digest : nullptr;
+                                        if (target == nullptr)
+                                        {
+                                            return true;
+                                        }
+                                        std::string_view raw = std::string_view(body).substr(value.begin, value.end - value.begin);
+                                        return raw.size() >= 2 && raw.front() == '"' && json::unescapeString(raw.substr(1, raw.size() - 2), *target); }) == json::kScanError)
+            {
+                m_lastError = "Malformed snapshot " + path;
+                return false;
+            }
+            if (tenant != m_apiHost)
+            {
+                m_lastError = "Snapshot " + path + " belongs to tenant " + tenant;
+                return false;
+            }
+
+            std::vector<LogipadClient::User> users;
+            if (!json::Backend::parseUsers(body, users, m_lastError))
+            {
+                return false;
+            }
+
+            m_users.clear();
+            m_index.clear();
+            m_watermark.clear();
+            merge(users);
+            m_watermark = watermark;
+            m_digest = std::strtoull(digest.c_str(), nullptr, 16);
+            m_lastChangeCount = 0;
+            m_lastChanges.clear();
+            return true;
+        }
+
+    } // namespace client
+} // namespace logipad
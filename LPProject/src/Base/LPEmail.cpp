@@ -0,0 +1,266 @@
+/**
+ * @file LPEmail.cpp
+ * @brief Implementation of email normalization and duplicate detection
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPEmail.hpp>
+#include <LPHash.hpp>
+#include <LPLazyUsers.hpp>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LP_EMAIL_SSE2 1
+#endif
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Hash seeds separating the key kinds
+            const std::uint64_t kEmailSeed = 1;
+            const std::uint64_t kUsernameSeed = 2;
+
+            // Remove surrounding ASCII white space and control characters
+            std::string_view trim(std::string_view value)
+            {
+                while (!value.empty() && static_cast<unsigned char>(value.front()) <= ' ')
+                {
+                    value.remove_prefix(1);
+                }
+                while (!value.empty() && static_cast<unsigned char>(value.back()) <= ' ')
+                {
+                    value.remove_suffix(1);
+                }
+                return value;
+            }
+        } // namespace
+
+        /**
+         * @brief Fold ASCII letters to lower case
+         * @details With SSE2, 16 bytes are classified per step: as signed bytes, 'A'..'Z'
+         *          are the only values in (0x40, 0x5B), and UTF-8 continuation and lead
+         *          bytes are negative, so they are never touched. The tail is scalar.
+         */
+        void foldAsciiLower(char *data, std::size_t size)
+        {
+            std::size_t i = 0;
+#ifdef LP_EMAIL_SSE2
+            const __m128i below = _mm_set1_epi8('A' - 1);
+            const __m128i above = _mm_set1_epi8('Z' + 1);
+            const __m128i bit = _mm_set1_epi8(0x20);
+            for (; i + 16 <= size; i += 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+                __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, below), _mm_cmplt_epi8(chunk, above));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), _mm_or_si128(chunk, _mm_and_si128(upper, bit)));
+            }
+#endif
+            for (; i < size; ++i)
+            {
+                if (data[i] >= 'A' && data[i] <= 'Z')
+                {
+                    data[i] = static_cast<char>(data[i] | 0x20);
+                }
+            }
+        }
+
+        /**
+         * @brief Constructor implementation
+         */
+        EmailNormalizer::EmailNormalizer(const Options &options) : m_options(options)
+        {
+        }
+
+        /**
+         * @brief Default constructor implementation
+         */
+        EmailNormalizer::EmailNormalizer() : m_options()
+        {
+        }
+
+        /**
+         * @brief Normalize an address
+         * @details Provider rules work on the folded address: the local part loses its
+         *          "+tag" suffix and, for Gmail, its dots.
+         */
+        void EmailNormalizer::normalize(std::string_view email, std::string &out) const
+        {
+            email = trim(email);
+            out.assign(email.data(), email.size());
+            foldAsciiLower(out.data(), out.size());
+            if (!m_options.stripPlusTags && !m_options.providerRules)
+            {
+                return;
+            }
+
+            std::size_t at = out.rfind('@');
+            if (at == std::string::npos)
+            {
+                return;
+            }
+            std::string_view domain = std::string_view(out).substr(at + 1);
+            bool gmail = m_options.providerRules && (domain == "gmail.com" || domain == "googlemail.com");
+            std::size_t plus = out.find('+');
+            if ((m_options.stripPlusTags || gmail) && plus < at)
+            {
+                out.erase(plus, at - plus);
+                at = plus;
+            }
+            if (gmail)
+            {
+                auto end = std::remove(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(at), '.');
+                out.erase(end, out.begin() + static_cast<std::ptrdiff_t>(at));
+                at = out.rfind('@');
+                out.replace(at + 1, std::string::npos, "gmail.com");
+            }
+        }
+
+        // Normalize an address into a new string
+        std::string EmailNormalizer::normalize(std::string_view email) const
+        {
+            std::string out;
+            normalize(email, out);
+            return out;
+        }
+
+        /**
+         * @brief Constructor implementation
+         */
+        DuplicateDetector::DuplicateDetector(const EmailNormalizer::Options &options) : m_normalizer(options)
+        {
+        }
+
+        // Register decoded users
+        void DuplicateDetector::addDirectory(const std::string &tenant, const std::vector<LogipadClient::User> &users)
+        {
+            add(tenant, users, users.size());
+        }
+
+        // Register lazily decoded users
+        void DuplicateDetector::addDirectory(const std::string &tenant, const LazyUsers &users)
+        {
+            add(tenant, users, users.size());
+        }
+
+        /**
+         * @brief Register a directory
+         * @details Keys already held by another directory keep their first holder.
+         */
+        template <typename Source>
+        void DuplicateDetector::add(const std::string &tenant, const Source &users, std::size_t count)
+        {
+            auto owner = static_cast<std::uint32_t>(m_owners.size());
+            m_owners.push_back(tenant);
+            m_keys.reserve(m_keys.size() + 2 * count);
+            std::string key;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto &&user = users[i];
+                m_normalizer.normalize(user.get(UserField::Email).value_or(std::string_view()), key);
+                if (!key.empty())
+                {
+                    m_keys.try_emplace(io::xxh64(key, kEmailSeed), Holder{owner, static_cast<std::uint32_t>(i)});
+                }
+                std::string_view name = trim(user.get(UserField::Name).value_or(std::string_view()));
+                key.assign(name.data(), name.size());
+                foldAsciiLower(key.data(), key.size());
+                if (!key.empty())
+                {
+                    m_keys.try_emplace(io::xxh64(key, kUsernameSeed), Holder{owner, static_cast<std::uint32_t>(i)});
+                }
+            }
+        }
+
+        /**
+         * @brief Check a batch
+         * @details Known keys are looked up first; keys new to the detector are tracked
+         *          in a batch-local table, so the second and later entries with the same
+         *          key are reported against the first one.
+         */
+        void DuplicateDetector::check(const std::vector<auth::KeycloakClient::UserInfo> &batch, std::vector<Duplicate> &duplicates) const
+        {
+            duplicates.clear();
+            std::unordered_map<std::uint64_t, std::uint32_t, Identity> seen;
+            seen.reserve(2 * batch.size());
+            std::string key;
+
+            auto probe = [&](std::size_t index, Key kind, std::uint64_t seed)
+            {
+                if (key.empty())
+                {
+                    return;
+                }
+                std::uint64_t hash = io::xxh64(key, seed);
+                auto known = m_keys.find(hash);
+                if (known != m_keys.end())
+                {
+                    duplicates.push_back(Duplicate{index, kind, key, m_owners[known->second.owner], known->second.row});
+                    return;
+                }
+                auto [it, inserted] = seen.try_emplace(hash, static_cast<std::uint32_t>(index));
+                if (!inserted)
+                {
+                    duplicates.push_back(Duplicate{index, kind, key, std::string(), it->second});
+                }
+            };
+
+            for (std::size_t i = 0; i < batch.size(); ++i)
+            {
+                m_normalizer.normalize(batch[i].email, key);
+                probe(i, Key::Email, kEmailSeed);
+                std::string_view name = trim(batch[i].username);
+                key.assign(name.data(), name.size());
+                foldAsciiLower(key.data(), key.size());
+                probe(i, Key::Username, kUsernameSeed);
+            }
+        }
+
+        /**
+         * @brief Register the passing entries of a batch
+         * @details Keys already held keep their first holder, in case the detector
+         *          changed since the batch was checked.
+         */
+        void DuplicateDetector::commit(const std::string &tenant, const std::vector<auth::KeycloakClient::UserInfo> &batch, const std::vector<Duplicate> &duplicates)
+        {
+            std::vector<std::uint8_t> rejected(batch.size(), 0);
+            for (const auto &duplicate : duplicates)
+            {
+                if (duplicate.index < batch.size())
+                {
+                    rejected[duplicate.index] = 1;
+                }
+            }
+
+            auto owner = static_cast<std::uint32_t>(m_owners.size());
+            m_owners.push_back(tenant);
+            m_keys.reserve(m_keys.size() + 2 * batch.size());
+            std::string key;
+            for (std::size_t i = 0; i < batch.size(); ++i)
+            {
+                if (rejected[i])
+                {
+                    continue;
+                }
+                m_normalizer.normalize(batch[i].email, key);
+                if (!key.empty())
+                {
+                    m_keys.try_emplace(io::xxh64(key, kEmailSeed), Holder{owner, static_cast<std::uint32_t>(i)});
+                }
+                std::string_view name = trim(batch[i].username);
+                key.assign(name.data(), name.size());
+                foldAsciiLower(key.data(), key.size());
+                if (!key.empty())
+                {
+                    m_keys.try_emplace(io::xxh64(key, kUsernameSeed), Holder{owner, static_cast<std::uint32_t>(i)});
+                }
+            }
+        }
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,133 @@
+/**
+ * @file LPHash.cpp
+ * @brief Implementation of the XXH64 hash
+ * @details Follows the XXH64 specification: four parallel accumulators over 32-byte
+ *          stripes, merged and then fed the remaining 8-, 4- and 1-byte tails,
+ *          followed by the final avalanche.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPHash.hpp>
+
+namespace logipad
+{
+    namespace io
+    {
+
+        namespace
+        {
+            const std::uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+            const std::uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+            const std::uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+            const std::uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+            const std::uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+            inline std::uint64_t rotl(std::uint64_t value, int bits)
+            {
+                return (value << bits) | (value >> (64 - bits));
+            }
+
+            // Byte-wise little-endian loads; compilers fold them into single loads
+            inline std::uint64_t read64(const unsigned char *p)
+            {
+                std::uint64_t value = 0;
+                for (int i = 0; i < 8; ++i)
+                {
+                    value |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+                }
+                return value;
+            }
+
+            inline std::uint32_t read32(const unsigned char *p)
+            {
+                std::uint32_t value = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    value |= static_cast<std::uint32_t>(p[i]) << (8 * i);
+                }
+                return value;
+            }
+
+            inline std::uint64_t round(std::uint64_t acc, std::uint64_t input)
+            {
+                acc += input * kPrime2;
+                acc = rotl(acc, 31);
+                return acc * kPrime1;
+            }
+
+            inline std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t value)
+            {
+                acc ^= round(0, value);
+                return acc * kPrime1 + kPrime4;
+            }
+        } // namespace
+
+        /**
+         * @brief Compute the XXH64 digest of a buffer
+         */
+        std::uint64_t xxh64(std::string_view data, std::uint64_t seed)
+        {
+            const auto *p = reinterpret_cast<const unsigned char *>(data.data());
+            const unsigned char *end = p + data.size();
+            std::uint64_t hash;
+
+            if (data.size() >= 32)
+            {
+                std::uint64_t v1 = seed + kPrime1 + kPrime2;
+                std::uint64_t v2 = seed + kPrime2;
+                std::uint64_t v3 = seed;
+                std::uint64_t v4 = seed - kPrime1;
+
+                const unsigned char *limit = end - 32;
+                do
+                {
+                    v1 = round(v1, read64(p));
+                    v2 = round(v2, read64(p + 8));
+                    v3 = round(v3, read64(p + 16));
+                    v4 = round(v4, read64(p + 24));
+                    p += 32;
+                } while (p <= limit);
+
+                hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+                hash = mergeRound(hash, v1);
+                hash = mergeRound(hash, v2);
+                hash = mergeRound(hash, v3);
+                hash = mergeRound(hash, v4);
+            }
+            else
+            {
+                hash = seed + kPrime5;
+            }
+
+            hash += static_cast<std::uint64_t>(data.size());
+
+            while (end - p >= 8)
+            {
+                hash ^= round(0, read64(p));
+                hash = rotl(hash, 27) * kPrime1 + kPrime4;
+                p += 8;
+            }
+            if (end - p >= 4)
+            {
+                hash ^= static_cast<std::uint64_t>(read32(p)) * kPrime1;
+                hash = rotl(hash, 23) * kPrime2 + kPrime3;
+                p += 4;
+            }
+            while (p < end)
+            {
+                hash ^= static_cast<std::uint64_t>(*p) * kPrime5;
+                hash = rotl(hash, 11) * kPrime1;
+                ++p;
+            }
+
+            hash ^= hash >> 33;
+            hash *= kPrime2;
+            hash ^= hash >> 29;
+            hash *= kPrime3;
+            hash ^= hash >> 32;
+            return hash;
+        }
+
+    } // namespace io
+} // namespace logipad
@@ -0,0 +1,224 @@
+/**
+ * @file LPHedgingTransport.cpp
+ * @brief Implementation of hedged GET requests
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPHedgingTransport.hpp>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <thread>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        namespace
+        {
+            // Milliseconds since a point in time
+            std::chrono::milliseconds since(std::chrono::steady_clock::time_point start)
+            {
+                return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            }
+
+            // An attempt wins with a response that is not a server error
+            bool answered(const httplib::Result &result)
+            {
+                return result && result->status < 500;
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        LatencyTracker::LatencyTracker(const Options &options) : m_options(options)
+        {
+            m_options.window = std::max<std::size_t>(1, m_options.window);
+        }
+
+        // Add a latency to the window of the endpoint
+        void LatencyTracker::record(const std::string &endpoint, std::chrono::milliseconds latency)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Window &window = m_windows[endpoint];
+            if (window.samples.size() < m_options.window)
+            {
+                window.samples.push_back(latency);
+                return;
+            }
+            window.samples[window.next] = latency;
+            window.next = (window.next + 1) % window.samples.size();
+        }
+
+        /**
+         * @brief Get the hedge delay
+         * @details Nearest-rank percentile of a copy of the window; the window is small
+         *          enough that selecting on every request costs far less than the request.
+         */
+        std::chrono::milliseconds LatencyTracker::hedgeDelay(const std::string &endpoint) const
+        {
+            std::vector<std::chrono::milliseconds> samples;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_windows.find(endpoint);
+                if (it != m_windows.end())
+                {
+                    samples = it->second.samples;
+                }
+            }
+            if (samples.empty() || samples.size() < m_options.minSamples)
+            {
+                return std::max(m_options.initialDelay, m_options.minDelay);
+            }
+
+            double rank = std::ceil(std::clamp(m_options.percentile, 0.0, 100.0) / 100.0 * static_cast<double>(samples.size()));
+            std::size_t index = std::min(samples.size() - 1, static_cast<std::size_t>(std::max(1.0, rank)) - 1);
+            std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+            return std::max(samples[index], m_options.minDelay);
+        }
+
+        // Update the hedging counters
+        void LatencyTracker::countHedge(bool won)
+        {
+            ++m_hedged;
+            if (won)
+            {
+                ++m_wins;
+            }
+        }
+
+        /**
+         * @brief Constructor implementation
+         * @details Creates the transport of first attempts right away.
+         */
+        HedgingTransport::HedgingTransport(
+            std::shared_ptr<LatencyTracker> tracker,
+            const std::string &host,
+            int port,
+            TransportFactory inner) : m_tracker(std::move(tracker)),
+                                      m_host(host),
+                                      m_port(port),
+                                      m_endpoint(host + ":" + std::to_string(port)),
+                                      m_inner(std::move(inner)),
+                                      m_primary(m_inner(host, port))
+        {
+        }
+
+        /**
+         * @brief Send a request
+         * @details Each attempt gets a child of the request's token, so cancelling the
+         *          request stops both and the winner can stop the loser alone. A 5xx
+         *          answer does not win: the other attempt keeps running, and only a
+         *          winner's latency is recorded. The helper thread is joined before
+         *          returning; by then the loser has been cancelled and returns at once.
+         */
+        httplib::Result HedgingTransport::send(const Request &request)
+        {
+            if (request.method != "GET" || request.context.stopped())
+            {
+                return m_primary->send(request);
+            }
+
+            std::chrono::milliseconds delay = m_tracker->hedgeDelay(m_endpoint);
+            if (delay >= request.context.deadline.remaining())
+            {
+                // The deadline ends the request before a second attempt could go out
+                return m_primary->send(request);
+            }
+
+            Request first = request;
+            first.context.cancel = request.context.cancel.child();
+            Request second = request;
+            second.context.cancel = request.context.cancel.child();
+
+            std::mutex mutex;
+            std::condition_variable firstDone;
+            bool firstFinished = false;
+            bool secondSent = false;
+            httplib::Result secondResult;
+            auto start = std::chrono::steady_clock::now();
+
+            std::thread helper([&]
+                               {
+                                   {
+                                       std::unique_lock<std::mutex> lock(mutex);
+                                       if (firstDone.wait_for(lock, delay, [&]
+                                                              { return firstFinished; }) ||
+                                           second.context.stopped())
+                                       {
+                                           return;
+                                       }
+                                       secondSent = true;
+                                   }
+                                   if (!m_secondary)
+                                   {
+                                       m_secondary = m_inner(m_host, m_port);
+                                       if (m_timeoutsSet)
+                                       {
+                                           m_secondary->setTimeouts(m_connectTimeout, m_readTimeout);
+                                       }
+                                   }
+                                   secondResult = m_secondary->send(second);
+                                   if (answered(secondResult))
+                                   {
+                                       first.context.cancel.cancel();
+                                   } });
+
+            auto result = m_primary->send(first);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                firstFinished = true;
+            }
+            firstDone.notify_all();
+            bool firstWon = answered(result);
+            if (firstWon)
+            {
+                second.context.cancel.cancel();
+            }
+            helper.join();
+
+            bool secondWon = !firstWon && answered(secondResult);
+            if (secondSent)
+            {
+                m_tracker->countHedge(secondWon);
+            }
+            if (firstWon || secondWon)
+            {
+                m_tracker->record(m_endpoint, since(start));
+            }
+            if (secondWon || (!result && secondSent && (secondResult || !request.context.stopped())))
+            {
+                // Second attempt answered first, or only it got a response, or both failed:
+                // report the last failure
+                return secondResult;
+            }
+            return result;
+        }
+
+        // Forward timeouts to both transports
+        void HedgingTransport::setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout)
+        {
+            m_timeoutsSet = true;
+            m_connectTimeout = connectTimeout;
+            m_readTimeout = readTimeout;
+            m_primary->setTimeouts(connectTimeout, readTimeout);
+            if (m_secondary)
+            {
+                m_secondary->setTimeouts(connectTimeout, readTimeout);
+            }
+        }
+
+        // Hedging factory
+        TransportFactory hedgingTransportFactory(std::shared_ptr<LatencyTracker> tracker, TransportFactory inner)
+        {
+            return [tracker, inner](const std::string &host, int port) -> std::unique_ptr<Transport>
+            {
+                return std::make_unique<HedgingTransport>(tracker, host, port, inner);
+            };
+        }
+
+    } // namespace net
+} // namespace logipad
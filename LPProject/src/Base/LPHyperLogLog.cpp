@@ -0,0 +1,159 @@
+/**
+ * @file LPHyperLogLog.cpp
+ * @brief Implementation of the HyperLogLog sketch
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPHyperLogLog.hpp>
+#include <LPHash.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace logipad
+{
+    namespace io
+    {
+
+        namespace
+        {
+            // Maximum rank: leading zeros of the remaining 64 - kPrecision hash bits plus one
+            const std::uint8_t kMaxRank = 64 - HyperLogLog::kPrecision + 1;
+        } // namespace
+
+        // Add an item
+        void HyperLogLog::add(std::string_view item)
+        {
+            addHash(xxh64(item));
+        }
+
+        /**
+         * @brief Add an item by hash
+         * @details The top kPrecision bits select the register, which keeps the largest
+         *          position of the first set bit among the remaining bits.
+         */
+        void HyperLogLog::addHash(std::uint64_t hash)
+        {
+            std::size_t index = static_cast<std::size_t>(hash >> (64 - kPrecision));
+            std::uint64_t rest = (hash << kPrecision) | (std::uint64_t(1) << (kPrecision - 1));
+            auto rank = static_cast<std::uint8_t>(std::countl_zero(rest) + 1);
+            m_registers[index] = std::max(m_registers[index], rank);
+        }
+
+        // Merge another sketch
+        void HyperLogLog::merge(const HyperLogLog &other)
+        {
+            for (std::size_t i = 0; i < kRegisters; ++i)
+            {
+                m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+            }
+        }
+
+        /**
+         * @brief Estimate the cardinality
+         * @details Raw estimate alpha * m^2 / sum(2^-M[j]); below 2.5 m with empty
+         *          registers left, linear counting m * ln(m / zeros) is more accurate.
+         *          64-bit hashes make a large-range correction unnecessary.
+         */
+        double HyperLogLog::estimate() const
+        {
+            const double m = static_cast<double>(kRegisters);
+            double sum = 0.0;
+            std::size_t zeros = 0;
+            for (std::uint8_t rank : m_registers)
+            {
+                sum += std::ldexp(1.0, -static_cast<int>(rank));
+                zeros += rank == 0;
+            }
+            double alpha = 0.7213 / (1.0 + 1.079 / m);
+            double raw = alpha * m * m / sum;
+            if (raw <= 2.5 * m && zeros > 0)
+            {
+                return m * std::log(m / static_cast<double>(zeros));
+            }
+            return raw;
+        }
+
+        // Check for an empty sketch
+        bool HyperLogLog::empty() const
+        {
+            return std::all_of(m_registers.begin(), m_registers.end(), [](std::uint8_t rank)
+                               { return rank == 0; });
+        }
+
+        /**
+         * @brief Serialize the sketch
+         * @details Layout: varint count of non-zero registers; if below kRegisters / 2,
+         *          that many (varint index delta, rank byte) pairs, otherwise all
+         *          kRegisters rank bytes.
+         */
+        void HyperLogLog::serialize(std::string &out) const
+        {
+            auto used = static_cast<std::size_t>(std::count_if(m_registers.begin(), m_registers.end(), [](std::uint8_t rank)
+                                                               { return rank != 0; }));
+            putVarint(out, used);
+            if (used >= kRegisters / 2)
+            {
+                out.append(reinterpret_cast<const char *>(m_registers.data()), kRegisters);
+                return;
+            }
+            std::size_t previous = 0;
+            for (std::size_t i = 0; i < kRegisters; ++i)
+            {
+                if (m_registers[i] != 0)
+                {
+                    putVarint(out, i - previous);
+                    out.push_back(static_cast<char>(m_registers[i]));
+                    previous = i;
+                }
+            }
+        }
+
+        // Deserialize the sketch
+        bool HyperLogLog::deserialize(Reader &in)
+        {
+            m_registers.fill(0);
+            std::uint64_t used = in.getVarint();
+            if (used > kRegisters)
+            {
+                in.ok = false;
+            }
+            if (!in.ok)
+            {
+                return false;
+            }
+            if (used >= kRegisters / 2)
+            {
+                for (std::size_t i = 0; i < kRegisters && in.ok; ++i)
+                {
+                    m_registers[i] = static_cast<std::uint8_t>(in.getInt(1));
+                }
+            }
+            else
+            {
+                std::uint64_t index = 0;
+                for (std::uint64_t i = 0; i < used && in.ok; ++i)
+                {
+                    index += in.getVarint();
+                    auto rank = static_cast<std::uint8_t>(in.getInt(1));
+                    if (index >= kRegisters)
+                    {
+                        in.ok = false;
+                        break;
+                    }
+                    m_registers[index] = rank;
+                }
+            }
+            for (std::uint8_t rank : m_registers)
+            {
+                if (rank > kMaxRank)
+                {
+                    in.ok = false;
+                }
+            }
+            return in.ok;
+        }
+
+    } // namespace io
+} // namespace logipad
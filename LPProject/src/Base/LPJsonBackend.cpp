@@ -0,0 +1,406 @@
+/**
+ * @file LPJsonBackend.cpp
+ * @brief Implementation of the JSON parsing backends
+ * @details Both backends map JSON members to LogipadClient::User through the
+ *          UserField enumeration and honour an optional field projection.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPJsonBackend.hpp>
+#include <nlohmann/json.hpp>
+
+#ifdef LP_USE_SIMDJSON
+#include <simdjson.h>
+#endif
+
+namespace logipad
+{
+    namespace json
+    {
+
+        namespace
+        {
+            using User = client::LogipadClient::User;
+
+            using client::UserField;
+            using client::UserFieldMask;
+
+            // Map one user object; throws nlohmann::json::exception on type mismatches
+            User userFromJson(const nlohmann::json &userJson)
+            {
+                User user;
+
+                // Required field
+                if (userJson.contains("guid"))
+                {
+                    user.guid = userJson["guid"].get<std::string>();
+                }
+
+                // Optional fields
+                for (std::size_t i = 0; i < client::kUserFieldCount; ++i)
+                {
+                    auto field = static_cast<UserField>(i);
+                    auto member = User::optionalMember(field);
+                    if (!member)
+                    {
+                        continue;
+                    }
+                    auto it = userJson.find(client::userFieldName(field));
+                    if (it != userJson.end() && !it->is_null())
+                    {
+                        user.*member = it->get<std::string>();
+                    }
+                }
+
+                // Boolean fields with defaults
+                user.is_active = userJson.contains("is_active") ? userJson["is_active"].get<bool>() : true;
+                user.is_reportable = userJson.contains("is_reportable") ? userJson["is_reportable"].get<bool>() : false;
+
+                return user;
+            }
+
+            /**
+             * @brief Map one user object selecting only the masked members
+             * @param text JSON buffer
+             * @param pos Offset of the opening '{' of the user object
+             * @param user Receives the user
+             * @param fields Field mask
+             * @param error Receives the error message on failure
+             * @return Offset one past the object, or kScanError on failure
+             * @details Used for projections by the nlohmann backend: members outside the mask
+             *          are skipped structurally and never decoded. (nlohmann's parser callbacks
+             *          would also drop them, but scale quadratically with the array length.)
+             */
+            std::size_t scanUser(std::string_view text, std::size_t pos, User &user, const UserFieldMask &fields, std::string &error)
+            {
+                user.is_active = true;
+                user.is_reportable = false;
+                if (pos >= text.size() || text[pos] != '{')
+                {
+                    error = "Failed to parse JSON response: expected user object at offset " + std::to_string(pos);
+                    return kScanError;
+                }
+
+                std::size_t end = forEachMember(text, pos, [&](std::string_view key, Range value)
+                                                {
+                                                    UserField field;
+                                                    if (!client::userFieldFromName(key, field) || !fields.contains(field))
+                                                    {
+                                                        return true;
+                                                    }
+
+                                                    std::string_view raw = text.substr(value.begin, value.end - value.begin);
+                                                    if (client::isBooleanField(field))
+                                                    {
+                                                        if (raw == "true" || raw == "false")
+                                                        {
+                                                            (field == UserField::IsActive ? user.is_active : user.is_reportable) = raw == "true";
+                                                            return true;
+                                                        }
+                                                    }
+                                                    else if (raw.front() == '"')
+                                                    {
+                                                        std::string decoded;
+                                                        if (unescapeString(raw.substr(1, raw.size() - 2), decoded))
+                                                        {
+                                                            if (field == UserField::Guid)
+                                                                user.guid = std::move(decoded);
+                                                            else
+                                                                user.*User::optionalMember(field) = std::move(decoded);
+                                                            return true;
+                                                        }
+                                                    }
+                                                    else if (raw == "null" && field != UserField::Guid)
+                                                    {
+                                                        return true;
+                                                    }
+
+                                                    error = "Failed to parse JSON response: field '" + std::string(key) + "' has an unexpected type at offset " + std::to_string(value.begin);
+                                                    return false; });
+                if (end == kScanError && error.empty())
+                {
+                    error = "Failed to parse JSON response: malformed user object at offset " + std::to_string(pos);
+                }
+                return end;
+            }
+        } // namespace
+
+        /**
+         * @brief Parse a user list with nlohmann::json
+         * @details Handles both direct array responses and nested object responses.
+         *          Projections bypass the DOM and decode only the selected members.
+         *          Either way, an array element that is not an object is an error, only
+         *          whitespace may follow the body and users is left unchanged on failure.
+         */
+        bool NlohmannBackend::parseUsers(const std::string &body, std::vector<User> &users, std::string &error, const UserFieldMask &fields)
+        {
+            if (!fields.isAll())
+            {
+                std::string_view text(body);
+                std::size_t first = users.size();
+                if (!forEachUser(text, [&](std::size_t pos)
+                                 {
+                                     users.emplace_back();
+                                     return scanUser(text, pos, users.back(), fields, error); }, error))
+                {
+                    users.resize(first);
+                    return false;
+                }
+                return true;
+            }
+
+            std::size_t first = users.size();
+            try
+            {
+                auto json = nlohmann::json::parse(body);
+
+                const nlohmann::json *array = nullptr;
+                if (json.is_array())
+                {
+                    array = &json;
+                }
+                else if (json.is_object() && json.contains("users") && json["users"].is_array())
+                {
+                    array = &json["users"];
+                }
+
+                if (array)
+                {
+                    users.reserve(users.size() + array->size());
+                    for (std::size_t i = 0; i < array->size(); ++i)
+                    {
+                        const auto &userJson = (*array)[i];
+                        if (!userJson.is_object())
+                        {
+                            error = "Failed to parse JSON response: expected user object at index " + std::to_string(i);
+                            users.resize(first);
+                            return false;
+                        }
+                        users.push_back(userFromJson(userJson));
+                    }
+                }
+                return true;
+            }
+            catch (const nlohmann::json::exception &e)
+            {
+                error = "Failed to parse JSON response: " + std::string(e.what());
+                users.resize(first);
+                return false;
+            }
+        }
+
+        // Parse a single user with nlohmann::json
+        bool NlohmannBackend::parseUser(const std::string &body, Range element, User &user, std::string &error, const UserFieldMask &fields)
+        {
+            if (!fields.isAll())
+            {
+                std::string_view text(body.data(), element.end);
+                return scanUser(text, element.begin, user, fields, error) == element.end;
+            }
+
+            try
+            {
+                auto userJson = nlohmann::json::parse(body.begin() + element.begin, body.begin() + element.end);
+                if (!userJson.is_object())
+                {
+                    error = "Failed to parse JSON response: expected user object at offset " + std::to_string(element.begin);
+                    return false;
+                }
+                user = userFromJson(userJson);
+                return true;
+            }
+            catch (const nlohmann::json::exception &e)
+            {
+                error = "Failed to parse JSON response: " + std::string(e.what());
+                return false;
+            }
+        }
+
+        // Parse token response with nlohmann::json
+        bool NlohmannBackend::parseAccessToken(const std::string &body, std::string &accessToken, std::string &error)
+        {
+            try
+            {
+                auto json = nlohmann::json::parse(body);
+                if (json.contains("access_token"))
+                {
+                    accessToken = json["access_token"].get<std::string>();
+                    return true;
+                }
+                error = "Access token not found in response";
+                return false;
+            }
+            catch (const nlohmann::json::exception &e)
+            {
+                error = "Failed to parse JSON response: " + std::string(e.what());
+                return false;
+            }
+        }
+
+#ifdef LP_USE_SIMDJSON
+        namespace
+        {
+            // One parser per thread keeps its internal buffers between calls
+            simdjson::ondemand::parser &threadParser()
+            {
+                thread_local simdjson::ondemand::parser parser;
+                return parser;
+            }
+
+            /**
+             * @brief Iterate a range of a buffer, in place if enough readable bytes follow it
+             * @details simdjson may read SIMDJSON_PADDING bytes past the end of the input.
+             *          Everything up to the string capacity is readable, so a range inside
+             *          a larger buffer usually needs no copy.
+             */
+            simdjson::ondemand::document iterate(const std::string &body, Range range, simdjson::padded_string &copy)
+            {
+                std::string_view text(body.data() + range.begin, range.end - range.begin);
+                simdjson::padded_string_view view(text, body.capacity() - range.begin);
+                if (view.padding() >= simdjson::SIMDJSON_PADDING)
+                {
+                    return threadParser().iterate(view).value();
+                }
+                copy = simdjson::padded_string(text);
+                return threadParser().iterate(copy).value();
+            }
+
+            simdjson::ondemand::document iterate(const std::string &body, simdjson::padded_string &copy)
+            {
+                return iterate(body, Range{0, body.size()}, copy);
+            }
+
+            /**
+             * @brief Map one user object; throws simdjson::simdjson_error on type mismatches
+             * @details Members outside the field mask are skipped by the on-demand iterator
+             *          without being decoded.
+             */
+            User userFromObject(simdjson::ondemand::object object, const UserFieldMask &fields)
+            {
+                User user;
+                user.is_active = true;
+                user.is_reportable = false;
+
+                for (auto member : object)
+                {
+                    UserField field;
+                    if (!client::userFieldFromName(member.unescaped_key().value(), field) || !fields.contains(field))
+                    {
+                        continue;
+                    }
+                    simdjson::ondemand::value value = member.value();
+
+                    switch (field)
+                    {
+                    case UserField::Guid:
+                        user.guid = std::string(std::string_view(value.get_string()));
+                        break;
+                    case UserField::IsActive:
+                        user.is_active = value.get_bool();
+                        break;
+                    case UserField::IsReportable:
+                        user.is_reportable = value.get_bool();
+                        break;
+                    default:
+                        if (!value.is_null())
+                        {
+                            user.*User::optionalMember(field) = std::string(std::string_view(value.get_string()));
+                        }
+                        break;
+                    }
+                }
+
+                return user;
+            }
+        } // namespace
+
+        /**
+         * @brief Parse a user list with the simdjson on-demand API
+         * @details Mirrors NlohmannBackend::parseUsers, including the accepted shapes.
+         */
+        bool SimdjsonBackend::parseUsers(const std::string &body, std::vector<User> &users, std::string &error, const UserFieldMask &fields)
+        {
+            std::size_t first = users.size();
+            try
+            {
+                simdjson::padded_string copy;
+                auto doc = iterate(body, copy);
+
+                simdjson::ondemand::array array;
+                auto type = doc.type().value();
+                if (type == simdjson::ondemand::json_type::array)
+                {
+                    array = doc.get_array();
+                }
+                else if (type == simdjson::ondemand::json_type::object)
+                {
+                    auto field = doc.get_object().find_field_unordered("users");
+                    if (field.error() == simdjson::NO_SUCH_FIELD || field.type().value() != simdjson::ondemand::json_type::array)
+                    {
+                        return true;
+                    }
+                    array = field.get_array();
+                }
+                else
+                {
+                    return true;
+                }
+
+                for (auto element : array)
+                {
+                    users.push_back(userFromObject(element.get_object(), fields));
+                }
+                return true;
+            }
+            catch (const simdjson::simdjson_error &e)
+            {
+                error = "Failed to parse JSON response: " + std::string(e.what());
+                users.resize(first);
+                return false;
+            }
+        }
+
+        // Parse a single user with simdjson
+        bool SimdjsonBackend::parseUser(const std::string &body, Range element, User &user, std::string &error, const UserFieldMask &fields)
+        {
+            try
+            {
+                simdjson::padded_string copy;
+                auto doc = iterate(body, element, copy);
+                user = userFromObject(doc.get_object(), fields);
+                return true;
+            }
+            catch (const simdjson::simdjson_error &e)
+            {
+                error = "Failed to parse JSON response: " + std::string(e.what());
+                return false;
+            }
+        }
+
+        // Parse token response with simdjson
+        bool SimdjsonBackend::parseAccessToken(const std::string &body, std::string &accessToken, std::string &error)
+        {
+            try
+            {
+                simdjson::padded_string copy;
+                auto doc = iterate(body, copy);
+                auto token = doc.get_object().find_field_unordered("access_token");
+                if (token.error() == simdjson::NO_SUCH_FIELD)
+                {
+                    error = "Access token not found in response";
+                    return false;
+                }
+                accessToken = std::string(std::string_view(token.get_string()));
+                return true;
+            }
+            catch (const simdjson::simdjson_error &e)
+            {
+                error = "Failed to parse JSON response: " + std::string(e.what());
+                return false;
+            }
+        }
+#endif
+
+    } // namespace json
+} // namespace logipad
@@ -0,0 +1,426 @@
+/**
+ * @file LPJsonScan.cpp
+ * @brief Implementation of the structural JSON scanner
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPJsonScan.hpp>
+#include <cstdint>
+#include <cstring>
+
+namespace logipad
+{
+    namespace json
+    {
+
+        namespace
+        {
+            bool isWhitespace(char c)
+            {
+                return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+            }
+        } // namespace
+
+        // Skip whitespace
+        std::size_t skipWhitespace(std::string_view text, std::size_t pos)
+        {
+            while (pos < text.size() && isWhitespace(text[pos]))
+            {
+                ++pos;
+            }
+            return pos;
+        }
+
+        /**
+         * @brief Skip a JSON string
+         * @details Jumps from quote to quote with memchr; a quote preceded by an odd
+         *          number of backslashes is escaped and does not end the string.
+         */
+        std::size_t skipString(std::string_view text, std::size_t pos)
+        {
+            std::size_t i = pos + 1;
+            while (i < text.size())
+            {
+                const void *found = std::memchr(text.data() + i, '"', text.size() - i);
+                if (!found)
+                {
+                    return kScanError;
+                }
+                std::size_t quote = static_cast<std::size_t>(static_cast<const char *>(found) - text.data());
+
+                std::size_t backslashes = 0;
+                while (quote - backslashes > pos + 1 && text[quote - backslashes - 1] == '\\')
+                {
+                    ++backslashes;
+                }
+                if (backslashes % 2 == 0)
+                {
+                    return quote + 1;
+                }
+                i = quote + 1;
+            }
+            return kScanError;
+        }
+
+        // Skip any value
+        std::size_t skipValue(std::string_view text, std::size_t pos)
+        {
+            if (pos >= text.size())
+            {
+                return kScanError;
+            }
+
+            char first = text[pos];
+            if (first == '"')
+            {
+                return skipString(text, pos);
+            }
+
+            if (first == '{' || first == '[')
+            {
+                int depth = 0;
+                std::size_t i = pos;
+                while (i < text.size())
+                {
+                    char c = text[i];
+                    if (c == '"')
+                    {
+                        i = skipString(text, i);
+                        if (i == kScanError)
+                        {
+                            return kScanError;
+                        }
+                        continue;
+                    }
+                    if (c == '{' || c == '[')
+                    {
+                        ++depth;
+                    }
+                    else if (c == '}' || c == ']')
+                    {
+                        if (--depth == 0)
+                        {
+                            return i + 1;
+                        }
+                    }
+                    ++i;
+                }
+                return kScanError;
+            }
+
+            // Scalar: number, true, false or null
+            std::size_t i = pos;
+            while (i < text.size() && !isWhitespace(text[i]) && text[i] != ',' && text[i] != ']' && text[i] != '}')
+            {
+                ++i;
+            }
+            return i;
+        }
+
+        // Find the array holding the users
+        std::size_t findUserArray(std::string_view text, std::string &error)
+        {
+            std::size_t pos = skipWhitespace(text, 0);
+            if (pos >= text.size())
+            {
+                error = "Empty response";
+                return kScanError;
+            }
+            if (text[pos] == '[')
+            {
+                return pos;
+            }
+            if (text[pos] != '{')
+            {
+                return text.size(); // other shapes carry no users
+            }
+
+            std::size_t usersPos = text.size();
+            std::size_t end = forEachMember(text, pos, [&](std::string_view key, Range value)
+                                            {
+                                                if (key == "users" && text[value.begin] == '[')
+                                                {
+                                                    usersPos = value.begin;
+                                                    return false;
+                                                }
+                                                return true; });
+            if (end == kScanError && usersPos == text.size())
+            {
+                error = "Malformed response object";
+                return kScanError;
+            }
+            return usersPos;
+        }
+
+        /**
+         * @brief Visit every element of a JSON array
+         * @details After each element only whitespace followed by ',' or ']' is accepted,
+         *          so structural errors between elements are reported here; the elements
+         *          themselves are validated by whoever consumes them.
+         */
+        bool forEachElement(
+            std::string_view text,
+            std::size_t arrayPos,
+            const std::function<std::size_t(std::size_t pos)> &visit,
+            std::string &error)
+        {
+            std::size_t pos = skipWhitespace(text, arrayPos + 1);
+            if (pos < text.size() && text[pos] == ']')
+            {
+                return true;
+            }
+
+            while (pos < text.size())
+            {
+                std::size_t end = visit(pos);
+                if (end == kScanError || end <= pos)
+                {
+                    if (error.empty())
+                    {
+                        error = "Malformed array element at offset " + std::to_string(pos);
+                    }
+                    return false;
+                }
+
+                pos = skipWhitespace(text, end);
+                if (pos < text.size() && text[pos] == ']')
+                {
+                    return true;
+                }
+                if (pos >= text.size() || text[pos] != ',')
+                {
+                    error = "Expected ',' or ']' at offset " + std::to_string(pos);
+                    return false;
+                }
+                pos = skipWhitespace(text, pos + 1);
+            }
+
+            error = "Unexpected end of response";
+            return false;
+        }
+
+        // Visit every member of an object
+        std::size_t forEachMember(
+            std::string_view text,
+            std::size_t objectPos,
+            const std::function<bool(std::string_view key, Range value)> &visit)
+        {
+            std::size_t pos = skipWhitespace(text, objectPos + 1);
+            if (pos < text.size() && text[pos] == '}')
+            {
+                return pos + 1;
+            }
+
+            while (pos < text.size())
+            {
+                if (text[pos] != '"')
+                {
+                    return kScanError;
+                }
+                std::size_t keyEnd = skipString(text, pos);
+                if (keyEnd == kScanError)
+                {
+                    return kScanError;
+                }
+                std::string_view key = text.substr(pos + 1, keyEnd - pos - 2);
+
+                pos = skipWhitespace(text, keyEnd);
+                if (pos >= text.size() || text[pos] != ':')
+                {
+                    return kScanError;
+                }
+                pos = skipWhitespace(text, pos + 1);
+
+                std::size_t valueEnd = skipValue(text, pos);
+                if (valueEnd == kScanError || valueEnd == pos)
+                {
+                    return kScanError;
+                }
+                if (!visit(key, Range{pos, valueEnd}))
+                {
+                    return kScanError;
+                }
+
+                pos = skipWhitespace(text, valueEnd);
+                if (pos < text.size() && text[pos] == '}')
+                {
+                    return pos + 1;
+                }
+                if (pos >= text.size() || text[pos] != ',')
+                {
+                    return kScanError;
+                }
+                pos = skipWhitespace(text, pos + 1);
+            }
+            return kScanError;
+        }
+
+        /**
+         * @brief Decode the escape sequences of a JSON string
+         * @details \uXXXX escapes are converted to UTF-8, including surrogate pairs.
+         */
+        bool unescapeString(std::string_view raw, std::string &out)
+        {
+            out.clear();
+            out.reserve(raw.size());
+
+            auto hex4 = [&raw](std::size_t pos, std::uint32_t &value)
+            {
+                if (pos + 4 > raw.size())
+                {
+                    return false;
+                }
+                value = 0;
+                for (std::size_t i = pos; i < pos + 4; ++i)
+                {
+                    char c = raw[i];
+                    value <<= 4;
+                    if (c >= '0' && c <= '9')
+                        value |= static_cast<std::uint32_t>(c - '0');
+                    else if (c >= 'a' && c <= 'f')
+                        value |= static_cast<std::uint32_t>(c - 'a' + 10);
+                    else if (c >= 'A' && c <= 'F')
+                        value |= static_cast<std::uint32_t>(c - 'A' + 10);
+                    else
+                        return false;
+                }
+                return true;
+            };
+
+            for (std::size_t i = 0; i < raw.size(); ++i)
+            {
+                char c = raw[i];
+                if (c != '\\')
+                {
+                    out.push_back(c);
+                    continue;
+                }
+                if (++i >= raw.size())
+                {
+                    return false;
+                }
+                switch (raw[i])
+                {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u':
+                {
+                    std::uint32_t code = 0;
+                    if (!hex4(i + 1, code))
+                    {
+                        return false;
+                    }
+                    i += 4;
+                    if (code >= 0xD800 && code <= 0xDBFF)
+                    {
+                        std::uint32_t low = 0;
+                        if (i + 2 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u' || !hex4(i + 3, low) || low < 0xDC00 || low > 0xDFFF)
+                        {
+                            return false;
+                        }
+                        i += 6;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    if (code < 0x80)
+                    {
+                        out.push_back(static_cast<char>(code));
+                    }
+                    else if (code < 0x800)
+                    {
+                        out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    else if (code < 0x10000)
+                    {
+                        out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    else
+                    {
+                        out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                        out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                        out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                        out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                    }
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Visit the users of a response
+         * @details A top-level array ends at its closing ']'; other top-level values are
+         *          skipped as a whole. Only whitespace may follow.
+         */
+        bool forEachUser(std::string_view text, const std::function<std::size_t(std::size_t pos)> &visit, std::string &error)
+        {
+            std::size_t pos = findUserArray(text, error);
+            if (pos == kScanError)
+            {
+                return false;
+            }
+
+            std::size_t close = pos;
+            if (pos < text.size())
+            {
+                std::size_t last = pos + 1;
+                if (!forEachElement(text, pos, [&](std::size_t element)
+                                    {
+                                        std::size_t end = visit(element);
+                                        if (end != kScanError)
+                                        {
+                                            last = end;
+                                        }
+                                        return end; }, error))
+                {
+                    return false;
+                }
+                close = skipWhitespace(text, last) + 1;
+            }
+
+            std::size_t root = skipWhitespace(text, 0);
+            std::size_t end = pos == root ? close : skipValue(text, root);
+            if (end == kScanError)
+            {
+                error = "Malformed response object";
+                return false;
+            }
+            end = skipWhitespace(text, end);
+            if (end < text.size())
+            {
+                error = "Unexpected data after the response at offset " + std::to_string(end);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Find the element ranges of a user list response
+         * @details Built on forEachUser(), skipping each element structurally.
+         */
+        bool scanUserArray(std::string_view text, std::vector<Range> &elements, std::string &error)
+        {
+            return forEachUser(text, [&](std::size_t element)
+                               {
+                                   std::size_t end = skipValue(text, element);
+                                   if (end != kScanError)
+                                   {
+                                       elements.push_back(Range{element, end});
+                                   }
+                                   return end; }, error);
+        }
+
+    } // namespace json
+} // namespace logipad
@@ -29,6 +29,7 @@
  * @details This file implements the LPKeyCloakClient class, which is used to interact with the Keycloak authentication server.
  */
 #include <LPKeyCloakClient.hpp>
+#include <LPJsonBackend.hpp>
 #include <iostream>
 #include <stdexcept>
 
@@ -69,8 +70,8 @@ namespace logipad
 
         /**
          * @brief Constructor implementation
-         * @details Initializes all member variables and creates the SSL client connection
-         *          with 10-second connection and read timeouts.
+         * @details Initializes all member variables and creates the HTTPS transport
+         *          with the default timeouts.
          */
         KeycloakClient::KeycloakClient(
             const std::string &host,
@@ -84,26 +85,27 @@ namespace logipad
                                            m_clientId(clientId),
                                            m_username(username),
                                            m_password(password),
-                                           m_client(std::make_unique<httplib::SSLClient>(host, port))
+                                           m_transportFactory(net::httpTransportFactory()),
+                                           m_client(m_transportFactory(host, port))
         {
-            // Set connection timeout (10 seconds)
-            m_client->set_connection_timeout(10, 0);
-            m_client->set_read_timeout(10, 0);
+            m_client->setTimeouts(m_connectTimeout, m_readTimeout);
         }
 
         /**
          * @brief Destructor implementation
-         * @details Automatically cleans up the SSL client and all member variables.
+         * @details Automatically cleans up the transport and all member variables.
          */
         KeycloakClient::~KeycloakClient() = default;
 
         /**
          * @brief Authenticate with Keycloak server
          * @details Performs password grant OAuth2 authentication and stores the access token.
+         *          The token response is parsed with the JSON backend selected at build time.
          */
-        bool KeycloakClient::authenticate()
+        bool KeycloakClient::authenticate(const net::CallContext &call)
         {
             m_lastError.clear();
+            m_lastStatus = 0;
             m_accessToken.clear();
 
             if (m_username.empty() || m_password.empty())
@@ -122,29 +124,14 @@ namespace logipad
             params.emplace("password", m_password);
 
             // Make the POST request
-            auto res = m_client->Post(tokenUrl.c_str(), params);
+            auto request = net::Request::postForm(tokenUrl, params);
+            request.context = call;
+            auto res = m_client->send(request);
+            m_lastStatus = res ? res->status : 0;
 
             if (res && res->status == 200)
             {
-                try
-                {
-                    auto json = nlohmann::json::parse(res->body);
-                    if (json.contains("access_token"))
-                    {
-                        m_accessToken = json["access_token"].get<std::string>();
-                        return true;
-                    }
-                    else
-                    {
-                        m_lastError = "Access token not found in response";
-                        return false;
-                    }
-                }
-                catch (const nlohmann::json::exception &e)
-                {
-                    m_lastError = "Failed to parse JSON response: " + std::string(e.what());
-                    return false;
-                }
+                return json::Backend::parseAccessToken(res->body, m_accessToken, m_lastError);
             }
             else
             {
@@ -158,18 +145,18 @@ namespace logipad
                 }
                 else
                 {
-                    m_lastError = "Authentication request failed";
+                    m_lastError = call.stopped() ? "Authentication request failed: " + call.stopReason() : "Authentication request failed";
                 }
                 return false;
             }
         }
 
         // Ensure authenticated
-        bool KeycloakClient::ensureAuthenticated()
+        bool KeycloakClient::ensureAuthenticated(const net::CallContext &call)
         {
             if (m_accessToken.empty())
             {
-                return authenticate();
+                return authenticate(call);
             }
             return true;
         }
@@ -188,12 +175,13 @@ namespace logipad
         }
 
         // Create user in Keycloak
-        bool KeycloakClient::createUser(const UserInfo &userInfo, const std::string &realm)
+        bool KeycloakClient::createUser(const UserInfo &userInfo, const std::string &realm, const net::CallContext &call)
         {
             m_lastError.clear();
+            m_lastStatus = 0;
 
             // Ensure we're authenticated
-            if (!ensureAuthenticated())
+            if (!ensureAuthenticated(call))
             {
                 m_lastError = "Not authenticated: " + m_lastError;
                 return false;
@@ -223,7 +211,15 @@ namespace logipad
             auto headers = getAuthHeaders();
 
             // Make the POST request to create user
-            auto res = m_client->Post(userUrl.c_str(), headers, jsonBody, "application/json");
+            auto request = net::Request::post(userUrl, headers, jsonBody, "application/json");
+            request.context = call;
+            auto res = m_client->send(request);
+            m_lastStatus = res ? res->status : 0;
+            if (res && res->status == 401)
+            {
+                // Token expired or revoked: authenticate again on the next call
+                m_accessToken.clear();
+            }
 
             if (res && res->status == 201)
             {
@@ -263,12 +259,92 @@ namespace logipad
                 }
                 else
                 {
-                    m_lastError = "Request failed to create user";
+                    m_lastError = call.stopped() ? "Request failed to create user: " + call.stopReason() : "Request failed to create user";
                 }
                 return false;
             }
         }
 
+        /**
+         * @brief List all users of a realm
+         * @details Each page is parsed with nlohmann::json; string members missing from
+         *          the brief representation stay empty. Every page request carries the
+         *          call context, so a cancelled listing stops within the current page.
+         */
+        bool KeycloakClient::listUsers(std::vector<Account> &accounts, const std::string &realm, int pageSize, const net::CallContext &call)
+        {
+            m_lastError.clear();
+            m_lastStatus = 0;
+            accounts.clear();
+            if (pageSize <= 0)
+            {
+                m_lastError = "Page size must be positive";
+                return false;
+            }
+            if (!ensureAuthenticated(call))
+            {
+                m_lastError = "Not authenticated: " + m_lastError;
+                return false;
+            }
+
+            // The realm is a path segment, so it is percent-encoded like a query value
+            std::string usersPath = "/admin/realms/" + httplib::detail::encode_query_param(realm) + "/users";
+            auto headers = getAuthHeaders();
+            for (int first = 0;; first += pageSize)
+            {
+                if (call.stopped())
+                {
+                    m_lastError = "Listing users stopped after " + std::to_string(accounts.size()) + " accounts: " + call.stopReason();
+                    return false;
+                }
+                std::string path = usersPath + "?briefRepresentation=true&first=" +
+                                   std::to_string(first) + "&max=" + std::to_string(pageSize);
+                auto request = net::Request::get(path, headers);
+                request.context = call;
+                auto res = m_client->send(request);
+                m_lastStatus = res ? res->status : 0;
+                if (!res || res->status != 200)
+                {
+                    m_lastError = res ? "Failed to list users. Status: " + std::to_string(res->status)
+                                      : (call.stopped() ? "Request failed to list users: " + call.stopReason() : "Request failed to list users");
+                    return false;
+                }
+
+                std::size_t received = 0;
+                try
+                {
+                    auto page = nlohmann::json::parse(res->body);
+                    if (!page.is_array())
+                    {
+                        m_lastError = "Failed to list users: response is not an array";
+                        return false;
+                    }
+                    for (const auto &item : page)
+                    {
+                        Account account;
+                        account.id = item.value("id", "");
+                        account.username = item.value("username", "");
+                        account.email = item.value("email", "");
+                        account.firstName = item.value("firstName", "");
+                        account.lastName = item.value("lastName", "");
+                        account.enabled = item.value("enabled", true);
+                        accounts.push_back(std::move(account));
+                    }
+                    received = page.size();
+                }
+                catch (const std::exception &ex)
+                {
+                    m_lastError = std::string("Failed to parse user list: ") + ex.what();
+                    return false;
+                }
+
+                if (received < static_cast<std::size_t>(pageSize))
+                {
+                    return true;
+                }
+            }
+        }
+
         // Set credentials
         void KeycloakClient::setCredentials(const std::string &username, const std::string &password)
         {
@@ -278,5 +354,21 @@ namespace logipad
             m_accessToken.clear();
         }
 
+        // Set timeouts
+        void KeycloakClient::setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout)
+        {
+            m_connectTimeout = connectTimeout;
+            m_readTimeout = readTimeout;
+            m_client->setTimeouts(m_connectTimeout, m_readTimeout);
+        }
+
+        // Replace transport factory
+        void KeycloakClient::setTransportFactory(net::TransportFactory factory)
+        {
+            m_transportFactory = std::move(factory);
+            m_client = m_transportFactory(m_host, m_port);
+            m_client->setTimeouts(m_connectTimeout, m_readTimeout);
+        }
+
     } // namespace auth
 } // namespace logipad
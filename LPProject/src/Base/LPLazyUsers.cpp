@@ -0,0 +1,196 @@
+/**
+ * @file LPLazyUsers.cpp
+ * @brief Implementation of the lazily decoded user list
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPLazyUsers.hpp>
+#include <LPJsonScan.hpp>
+#include <cstring>
+#include <limits>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        /**
+         * @brief Load a user list response
+         * @details Walks the user array once, recording per field the offset and length of
+         *          its raw value and whether it contains escapes. Value types are checked
+         *          here, and escape sequences are decoded once into a scratch buffer to
+         *          validate them, so that accessors never fail later. As in the eager
+         *          backends, the guid may be missing but not null and only whitespace may
+         *          follow the body.
+         */
+        bool LazyUsers::load(std::string body, std::string &error, const UserFieldMask &fields)
+        {
+            clear();
+            if (body.size() > std::numeric_limits<std::uint32_t>::max())
+            {
+                error = "Response too large for lazy loading";
+                return false;
+            }
+            m_body = std::move(body);
+            std::string_view text(m_body);
+
+            std::string scratch;
+            auto visitUser = [&](std::size_t pos) -> std::size_t
+            {
+                if (text[pos] != '{')
+                {
+                    error = "Expected user object at offset " + std::to_string(pos);
+                    return json::kScanError;
+                }
+
+                std::size_t base = m_slots.size();
+                m_slots.resize(base + kUserFieldCount);
+
+                return json::forEachMember(text, pos, [&](std::string_view key, json::Range value)
+                                           {
+                                               UserField field;
+                                               if (!userFieldFromName(key, field) || !fields.contains(field))
+                                               {
+                                                   return true;
+                                               }
+
+                                               Slot &target = m_slots[base + static_cast<std::size_t>(field)];
+                                               char first = text[value.begin];
+                                               if (isBooleanField(field))
+                                               {
+                                                   std::string_view literal = text.substr(value.begin, value.end - value.begin);
+                                                   if (literal == "true" || literal == "false")
+                                                   {
+                                                       target.kind = literal == "true" ? SlotKind::True : SlotKind::False;
+                                                       return true;
+                                                   }
+                                               }
+                                               else if (first == '"')
+                                               {
+                                                   target.offset = static_cast<std::uint32_t>(value.begin + 1);
+                                                   target.length = static_cast<std::uint32_t>(value.end - value.begin - 2);
+                                                   bool escaped = std::memchr(m_body.data() + target.offset, '\\', target.length) != nullptr;
+                                                   target.kind = escaped ? SlotKind::EscapedString : SlotKind::String;
+                                                   if (!escaped || json::unescapeString(text.substr(target.offset, target.length), scratch))
+                                                   {
+                                                       return true;
+                                                   }
+                                                   error = "Field '" + std::string(key) + "' has an invalid escape sequence at offset " + std::to_string(value.begin);
+                                                   return false;
+                                               }
+                                               else if (text.substr(value.begin, value.end - value.begin) == "null" && field != UserField::Guid)
+                                               {
+                                                   target.kind = SlotKind::Null;
+                                                   return true;
+                                               }
+
+                                               error = "Field '" + std::string(key) + "' has an unexpected type at offset " + std::to_string(value.begin);
+                                               return false; });
+            };
+
+            if (!json::forEachUser(text, visitUser, error))
+            {
+                clear();
+                return false;
+            }
+
+            m_count = m_slots.size() / kUserFieldCount;
+            return true;
+        }
+
+        // Discard all users
+        void LazyUsers::clear()
+        {
+            std::lock_guard<std::mutex> lock(m_decodedMutex);
+            m_body.clear();
+            m_slots.clear();
+            m_decoded.clear();
+            m_count = 0;
+        }
+
+        /**
+         * @brief Read a string slot
+         * @details Plain strings are returned as views into the retained body. Escaped
+         *          strings are decoded on first access and cached; the cache is node based,
+         *          so returned views stay valid while other entries are added.
+         */
+        std::optional<std::string_view> LazyUsers::stringValue(std::size_t index, UserField field) const
+        {
+            const Slot &s = slot(index, field);
+            switch (s.kind)
+            {
+            case SlotKind::String:
+                return std::string_view(m_body.data() + s.offset, s.length);
+            case SlotKind::EscapedString:
+            {
+                std::size_t key = index * kUserFieldCount + static_cast<std::size_t>(field);
+                std::lock_guard<std::mutex> lock(m_decodedMutex);
+                auto it = m_decoded.find(key);
+                if (it == m_decoded.end())
+                {
+                    // Escapes were validated by load()
+                    std::string decoded;
+                    json::unescapeString(std::string_view(m_body.data() + s.offset, s.length), decoded);
+                    it = m_decoded.emplace(key, std::move(decoded)).first;
+                }
+                return std::string_view(it->second);
+            }
+            default:
+                return std::nullopt;
+            }
+        }
+
+        // Get a field
+        std::optional<std::string_view> LazyUsers::View::get(UserField field) const
+        {
+            switch (field)
+            {
+            case UserField::IsActive:
+                return std::string_view(isActive() ? "true" : "false");
+            case UserField::IsReportable:
+                return std::string_view(isReportable() ? "true" : "false");
+            default:
+                return m_owner->stringValue(m_index, field);
+            }
+        }
+
+        // Get is_active
+        bool LazyUsers::View::isActive() const
+        {
+            return m_owner->slot(m_index, UserField::IsActive).kind != SlotKind::False;
+        }
+
+        // Get is_reportable
+        bool LazyUsers::View::isReportable() const
+        {
+            return m_owner->slot(m_index, UserField::IsReportable).kind == SlotKind::True;
+        }
+
+        /**
+         * @brief Decode all fields into a regular User
+         * @details Produces the same record the eager JSON backends would build.
+         */
+        LogipadClient::User LazyUsers::View::toUser() const
+        {
+            LogipadClient::User user;
+            user.guid = std::string(guid());
+
+            for (std::size_t i = 0; i < kUserFieldCount; ++i)
+            {
+                auto field = static_cast<UserField>(i);
+                auto member = LogipadClient::User::optionalMember(field);
+                auto value = member ? get(field) : std::nullopt;
+                if (value.has_value())
+                {
+                    user.*member = std::string(*value);
+                }
+            }
+
+            user.is_active = isActive();
+            user.is_reportable = isReportable();
+            return user;
+        }
+
+    } // namespace client
+} // namespace logipad
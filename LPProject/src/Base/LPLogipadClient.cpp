@@ -8,14 +8,76 @@
  */
 
 #include <LPLogipadClient.hpp>
+#include <LPJsonBackend.hpp>
+#include <LPParallelUserParser.hpp>
+#include <LPLazyUsers.hpp>
+#include <LPJsonScan.hpp>
+#include <LPHash.hpp>
+#include <future>
 #include <iostream>
+#include <unordered_set>
 
 namespace logipad {
 namespace client {
 
+namespace {
+// Smallest response body worth splitting across parser threads
+const std::size_t kParallelParseMinBytes = 1024 * 1024;
+
+/**
+ * @brief Extract the paging information of a user list page
+ * @param body Page body
+ * @param count Receives the number of users on the page
+ * @param cursor Receives the "next_cursor" value if it is a non-empty string
+ * @param cursorPaging Set if the page has a "next_cursor" member
+ * @return false if the body is malformed
+ */
+bool scanPage(std::string_view body, std::size_t& count, std::optional<std::string>& cursor, bool& cursorPaging)
+{
+    std::string error;
+    std::size_t arrayPos = json::findUserArray(body, error);
+    if (arrayPos == json::kScanError)
+    {
+        return false;
+    }
+
+    count = 0;
+    if (arrayPos < body.size() && !json::forEachElement(body, arrayPos, [&](std::size_t pos)
+                                                         {
+                                                             ++count;
+                                                             return json::skipValue(body, pos); }, error))
+    {
+        return false;
+    }
+
+    cursor.reset();
+    cursorPaging = false;
+    std::size_t root = json::skipWhitespace(body, 0);
+    if (root < body.size() && body[root] == '{')
+    {
+        json::forEachMember(body, root, [&](std::string_view key, json::Range value)
+                            {
+                                if (key != "next_cursor")
+                                {
+                                    return true;
+                                }
+                                cursorPaging = true;
+                                std::string decoded;
+                                std::string_view raw = body.substr(value.begin, value.end - value.begin);
+                                if (raw.size() > 2 && raw.front() == '"' && json::unescapeString(raw.substr(1, raw.size() - 2), decoded))
+                                {
+                                    cursor = std::move(decoded);
+                                }
+                                return false; });
+    }
+    return true;
+}
+} // namespace
+
 /**
  * @brief Constructor implementation
- * @details Initializes all connection parameters and creates the SSL client.
+ * @details Initializes all connection parameters and creates the HTTPS transport
+ *          with the default timeouts.
  */
 LogipadClient::LogipadClient(
     const std::string &host,
@@ -29,13 +91,14 @@ LogipadClient::LogipadClient(
                                    m_clientId(clientId),
                                    m_username(username),
                                    m_password(password),
-                                   m_httplibClient(std::make_unique<httplib::SSLClient>(host, port))
+                                   m_transportFactory(net::httpTransportFactory()),
+                                   m_transport(createTransport(host, port))
 {
 }
 
 /**
  * @brief Destructor implementation
- * @details Automatically cleans up the SSL client and member variables.
+ * @details Automatically cleans up the transport and member variables.
  */
 LogipadClient::~LogipadClient() = default;
 
@@ -43,7 +106,7 @@ LogipadClient::~LogipadClient() = default;
  * @brief Authenticate with Keycloak server
  * @details Performs password grant authentication and stores the access token.
  */
-bool LogipadClient::authenticate()
+bool LogipadClient::authenticate(const net::CallContext& call)
 {
     m_accessToken.clear();
 
@@ -62,14 +125,15 @@ bool LogipadClient::authenticate()
     params.emplace("password", m_password);
 
     // Make the POST request
-    auto res = m_httplibClient->Post(token_url.c_str(), params);
+    auto request = net::Request::postForm(token_url, params);
+    request.context = call;
+    auto res = m_transport->send(request);
 
     // Check and parse the response
     if (res && res->status == 200)
     {
-        auto json = nlohmann::json::parse(res->body);
-        m_accessToken = json["access_token"];
-        return true;
+        std::string error;
+        return json::Backend::parseAccessToken(res->body, m_accessToken, error);
     }
 
     return false;
@@ -107,24 +171,72 @@ nlohmann::json LogipadClient::User::toJson() const {
 }
 
 /**
- * @brief Retrieve all users from the Logipad identity API
- * @details Makes authenticated GET request, parses JSON response, and populates users vector.
- *          Handles both direct array responses and nested object responses.
+ * @brief Read a field generically
+ * @details Dispatches on the field through optionalMember(); guid and the boolean
+ *          fields are handled explicitly.
  */
-bool LogipadClient::getAllUsers(Users& users, const std::string& apiHost, int apiPort)
+std::optional<std::string_view> LogipadClient::User::get(UserField field) const
 {
-    // Clear existing users
-    users.users.clear();
+    switch (field)
+    {
+    case UserField::Guid:
+        return std::string_view(guid);
+    case UserField::IsActive:
+        return std::string_view(is_active ? "true" : "false");
+    case UserField::IsReportable:
+        return std::string_view(is_reportable ? "true" : "false");
+    default:
+    {
+        const auto &value = this->*optionalMember(field);
+        if (value.has_value())
+        {
+            return std::string_view(*value);
+        }
+        return std::nullopt;
+    }
+    }
+}
 
+// Member pointer of an optional string field
+std::optional<std::string> LogipadClient::User::*LogipadClient::User::optionalMember(UserField field)
+{
+    switch (field)
+    {
+    case UserField::CreatedAt: return &User::created_at;
+    case UserField::CreatedBy: return &User::created_by;
+    case UserField::ModifiedAt: return &User::modified_at;
+    case UserField::ModifiedBy: return &User::modified_by;
+    case UserField::LastLoginAt: return &User::last_login_at;
+    case UserField::LastActivityAt: return &User::last_activity_at;
+    case UserField::LastDocumentServiceActivity: return &User::last_document_service_activity;
+    case UserField::LastEformServiceActivity: return &User::last_eform_service_activity;
+    case UserField::LastBriefingServiceActivity: return &User::last_briefing_service_activity;
+    case UserField::Name: return &User::name;
+    case UserField::Type: return &User::type;
+    case UserField::FullName: return &User::full_name;
+    case UserField::Email: return &User::email;
+    case UserField::ThreeLc: return &User::three_lc;
+    case UserField::Department: return &User::department;
+    case UserField::Description: return &User::description;
+    default: return nullptr;
+    }
+}
+
+/**
+ * @brief Fetch the raw response body of one /users request
+ * @details Makes authenticated GET request against the API host. A projection is sent as
+ *          "fields" query parameter; if the API answers 400 to it, the request is repeated
+ *          without the parameter and the projection is only applied client-side from then on.
+ */
+bool LogipadClient::fetchUsers(std::string& body, net::Transport& apiClient, const UserQuery& query, const net::CallContext& call)
+{
     // Check if authenticated
+    m_lastStatus = 0;
     if (m_accessToken.empty())
     {
         return false;
     }
 
-    // Create SSL client for API host
-    httplib::SSLClient apiClient(apiHost, apiPort);
-
     // Prepare headers with Bearer token
     std::string token = "Bearer " + m_accessToken;
     httplib::Headers headers = {
@@ -133,134 +245,280 @@ bool LogipadClient::getAllUsers(Users& users, const std::string& apiHost, int ap
     };
 
     // Make GET request to /users endpoint
-    auto res = apiClient.Get("/users", headers);
+    bool withFields = !query.getFields().isAll() && !m_projectionUnsupported;
+    auto request = net::Request::get(query.toPath(withFields), headers);
+    request.context = call;
+    auto res = apiClient.send(request);
 
-    // Check and parse the response
+    if (res && res->status == 400 && withFields)
+    {
+        m_projectionUnsupported = true;
+        request.path = query.toPath(false);
+        res = apiClient.send(request);
+    }
+
+    m_lastStatus = res ? res->status : 0;
     if (res && res->status == 200)
     {
-        try
+        body = std::move(res->body);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Parse a user list body and append the users
+ * @details Uses the JSON backend selected at build time; large bodies are parsed on
+ *          several threads if enabled with setParseThreads().
+ */
+bool LogipadClient::parseUsers(const std::string& body, std::vector<User>& users, const UserFieldMask& fields, std::string& error) const
+{
+    if (m_parseThreads != 1 && body.size() >= kParallelParseMinBytes)
+    {
+        return json::ParallelUserParser(m_parseThreads).parse(body, users, error, fields);
+    }
+    return json::Backend::parseUsers(body, users, error, fields);
+}
+
+/**
+ * @brief Retrieve all users from the Logipad identity API
+ * @details Fetches the /users body, parses it and populates users vector.
+ * @see json::Backend
+ */
+bool LogipadClient::getAllUsers(Users& users, const std::string& apiHost, int apiPort, const UserFieldMask& fields, const net::CallContext& call)
+{
+    // Clear existing users
+    users.users.clear();
+    m_lastError.clear();
+
+    // Create transport for API host
+    auto apiClient = createTransport(apiHost, apiPort);
+
+    std::string body;
+    if (!fetchUsers(body, *apiClient, UserQuery().fields(fields), call))
+    {
+        m_lastError = "Failed to fetch users. Status: " + std::to_string(m_lastStatus);
+        return false;
+    }
+
+    // Parse the response
+    return parseUsers(body, users.users, fields, m_lastError);
+}
+
+/**
+ * @brief Retrieve all users unless the response is unchanged
+ * @details Hashing runs at memory bandwidth and costs a small fraction of parsing.
+ *          A changed body is parsed into a fresh list first, so users is only
+ *          replaced on success.
+ */
+bool LogipadClient::refreshUsers(Users& users, std::uint64_t& digest, const std::string& apiHost, int apiPort, const UserFieldMask& fields,
+                                 const net::CallContext& call)
+{
+    m_lastError.clear();
+    auto apiClient = createTransport(apiHost, apiPort);
+
+    std::string body;
+    if (!fetchUsers(body, *apiClient, UserQuery().fields(fields), call))
+    {
+        m_lastError = "Failed to fetch users. Status: " + std::to_string(m_lastStatus);
+        return false;
+    }
+
+    std::uint64_t bodyDigest = io::xxh64(body);
+    if (bodyDigest == digest)
+    {
+        return true;
+    }
+
+    Users parsed;
+    if (!parseUsers(body, parsed.users, fields, m_lastError))
+    {
+        return false;
+    }
+    users = std::move(parsed);
+    digest = bodyDigest;
+    return true;
+}
+
+/**
+ * @brief Retrieve all users as lazily decoded views
+ * @details Hands the response body over to the LazyUsers container without copying it.
+ */
+bool LogipadClient::getAllUsers(LazyUsers& users, const std::string& apiHost, int apiPort, const UserFieldMask& fields, const net::CallContext& call)
+{
+    users.clear();
+    m_lastError.clear();
+
+    auto apiClient = createTransport(apiHost, apiPort);
+
+    std::string body;
+    if (!fetchUsers(body, *apiClient, UserQuery().fields(fields), call))
+    {
+        m_lastError = "Failed to fetch users. Status: " + std::to_string(m_lastStatus);
+        return false;
+    }
+
+    return users.load(std::move(body), m_lastError, fields);
+}
+
+/**
+ * @brief Retrieve the users matching a query
+ * @details Pages are fetched in a pipeline: as soon as a page has arrived, the request
+ *          for the next page is started on a background thread and the current page is
+ *          parsed meanwhile. The next request is derived from a structural scan of the
+ *          page, which is much cheaper than parsing it. A page carrying a "next_cursor"
+ *          member is continued with that cursor (null or missing ends the result);
+ *          otherwise the offset is advanced until a page returns fewer users than the
+ *          page size.
+ *
+ *          The pages share a child of the caller's token. If a page fails to parse, the
+ *          prefetch in flight is cancelled instead of being waited for.
+ *
+ *          A server that ignores the paging parameters would keep the loop running, so
+ *          the query fails if a cursor repeats, if a page without users carries a cursor,
+ *          or if a page is byte for byte the same as the one before it.
+ */
+bool LogipadClient::queryUsers(Users& users, const UserQuery& query, const std::string& apiHost, int apiPort, const net::CallContext& call)
+{
+    users.users.clear();
+    m_lastError.clear();
+
+    auto apiClient = createTransport(apiHost, apiPort);
+
+    net::CallContext pages{call.deadline, call.cancel.child()};
+    std::string body;
+    if (!fetchUsers(body, *apiClient, query, pages))
+    {
+        m_lastError = "Failed to fetch users. Status: " + std::to_string(m_lastStatus);
+        return false;
+    }
+
+    UserQuery page = query;
+    std::unordered_set<std::string> seenCursors;
+    std::optional<std::uint64_t> previousDigest;
+    while (true)
+    {
+        if (pages.stopped())
         {
-            auto json = nlohmann::json::parse(res->body);
-            
-            // Check if response is an array
-            if (json.is_array())
+            m_lastError = "Query stopped after " + std::to_string(users.users.size()) + " users: " + pages.stopReason();
+            users.users.clear();
+            return false;
+        }
+
+        // Determine the follow-up request without decoding the users
+        std::optional<UserQuery> next;
+        if (page.getPageSize() > 0)
+        {
+            std::size_t count = 0;
+            std::optional<std::string> cursor;
+            bool cursorPaging = false;
+            if (!scanPage(body, count, cursor, cursorPaging))
             {
-                // Parse each user from the array
-                for (const auto& userJson : json)
-                {
-                    User user;
-                    
-                    // Required field
-                    if (userJson.contains("guid"))
-                    {
-                        user.guid = userJson["guid"].get<std::string>();
-                    }
-                    
-                    // Optional fields
-                    if (userJson.contains("created_at") && !userJson["created_at"].is_null())
-                        user.created_at = userJson["created_at"].get<std::string>();
-                    if (userJson.contains("created_by") && !userJson["created_by"].is_null())
-                        user.created_by = userJson["created_by"].get<std::string>();
-                    if (userJson.contains("modified_at") && !userJson["modified_at"].is_null())
-                        user.modified_at = userJson["modified_at"].get<std::string>();
-                    if (userJson.contains("modified_by") && !userJson["modified_by"].is_null())
-                        user.modified_by = userJson["modified_by"].get<std::string>();
-                    if (userJson.contains("last_login_at") && !userJson["last_login_at"].is_null())
-                        user.last_login_at = userJson["last_login_at"].get<std::string>();
-                    if (userJson.contains("last_activity_at") && !userJson["last_activity_at"].is_null())
-                        user.last_activity_at = userJson["last_activity_at"].get<std::string>();
-                    if (userJson.contains("last_document_service_activity") && !userJson["last_document_service_activity"].is_null())
-                        user.last_document_service_activity = userJson["last_document_service_activity"].get<std::string>();
-                    if (userJson.contains("last_eform_service_activity") && !userJson["last_eform_service_activity"].is_null())
-                        user.last_eform_service_activity = userJson["last_eform_service_activity"].get<std::string>();
-                    if (userJson.contains("last_briefing_service_activity") && !userJson["last_briefing_service_activity"].is_null())
-                        user.last_briefing_service_activity = userJson["last_briefing_service_activity"].get<std::string>();
-                    if (userJson.contains("name") && !userJson["name"].is_null())
-                        user.name = userJson["name"].get<std::string>();
-                    if (userJson.contains("type") && !userJson["type"].is_null())
-                        user.type = userJson["type"].get<std::string>();
-                    if (userJson.contains("full_name") && !userJson["full_name"].is_null())
-                        user.full_name = userJson["full_name"].get<std::string>();
-                    if (userJson.contains("email") && !userJson["email"].is_null())
-                        user.email = userJson["email"].get<std::string>();
-                    if (userJson.contains("three_lc") && !userJson["three_lc"].is_null())
-                        user.three_lc = userJson["three_lc"].get<std::string>();
-                    if (userJson.contains("department") && !userJson["department"].is_null())
-                        user.department = userJson["department"].get<std::string>();
-                    if (userJson.contains("description") && !userJson["description"].is_null())
-                        user.description = userJson["description"].get<std::string>();
-                    
-                    // Boolean fields with defaults
-                    user.is_active = userJson.contains("is_active") ? userJson["is_active"].get<bool>() : true;
-                    user.is_reportable = userJson.contains("is_reportable") ? userJson["is_reportable"].get<bool>() : false;
-                    
-                    users.users.push_back(user);
-                }
+                m_lastError = "Malformed user page";
+                users.users.clear();
+                return false;
             }
-            // Check if response is an object with a users array
-            else if (json.is_object() && json.contains("users") && json["users"].is_array())
+
+            // Refuse to follow paging that makes no progress
+            std::uint64_t digest = io::xxh64(body);
+            if (previousDigest == digest)
             {
-                // Parse users from nested array
-                for (const auto& userJson : json["users"])
+                m_lastError = "Paging made no progress: page at offset " + std::to_string(page.getOffset()) + " repeats the previous page";
+                users.users.clear();
+                return false;
+            }
+            previousDigest = digest;
+            if (cursor.has_value() && (count == 0 || !seenCursors.insert(*cursor).second))
+            {
+                m_lastError = count == 0 ? "Paging made no progress: page without users carries a cursor"
+                                         : "Paging made no progress: cursor \"" + *cursor + "\" was returned twice";
+                users.users.clear();
+                return false;
+            }
+
+            if (cursorPaging ? cursor.has_value() : count == page.getPageSize())
+            {
+                next = page;
+                if (cursorPaging)
                 {
-                    User user;
-                    
-                    if (userJson.contains("guid"))
-                    {
-                        user.guid = userJson["guid"].get<std::string>();
-                    }
-                    
-                    // Optional fields (same as above)
-                    if (userJson.contains("created_at") && !userJson["created_at"].is_null())
-                        user.created_at = userJson["created_at"].get<std::string>();
-                    if (userJson.contains("created_by") && !userJson["created_by"].is_null())
-                        user.created_by = userJson["created_by"].get<std::string>();
-                    if (userJson.contains("modified_at") && !userJson["modified_at"].is_null())
-                        user.modified_at = userJson["modified_at"].get<std::string>();
-                    if (userJson.contains("modified_by") && !userJson["modified_by"].is_null())
-                        user.modified_by = userJson["modified_by"].get<std::string>();
-                    if (userJson.contains("last_login_at") && !userJson["last_login_at"].is_null())
-                        user.last_login_at = userJson["last_login_at"].get<std::string>();
-                    if (userJson.contains("last_activity_at") && !userJson["last_activity_at"].is_null())
-                        user.last_activity_at = userJson["last_activity_at"].get<std::string>();
-                    if (userJson.contains("last_document_service_activity") && !userJson["last_document_service_activity"].is_null())
-                        user.last_document_service_activity = userJson["last_document_service_activity"].get<std::string>();
-                    if (userJson.contains("last_eform_service_activity") && !userJson["last_eform_service_activity"].is_null())
-                        user.last_eform_service_activity = userJson["last_eform_service_activity"].get<std::string>();
-                    if (userJson.contains("last_briefing_service_activity") && !userJson["last_briefing_service_activity"].is_null())
-                        user.last_briefing_service_activity = userJson["last_briefing_service_activity"].get<std::string>();
-                    if (userJson.contains("name") && !userJson["name"].is_null())
-                        user.name = userJson["name"].get<std::string>();
-                    if (userJson.contains("type") && !userJson["type"].is_null())
-                        user.type = userJson["type"].get<std::string>();
-                    if (userJson.contains("full_name") && !userJson["full_name"].is_null())
-                        user.full_name = userJson["full_name"].get<std::string>();
-                    if (userJson.contains("email") && !userJson["email"].is_null())
-                        user.email = userJson["email"].get<std::string>();
-                    if (userJson.contains("three_lc") && !userJson["three_lc"].is_null())
-                        user.three_lc = userJson["three_lc"].get<std::string>();
-                    if (userJson.contains("department") && !userJson["department"].is_null())
-                        user.department = userJson["department"].get<std::string>();
-                    if (userJson.contains("description") && !userJson["description"].is_null())
-                        user.description = userJson["description"].get<std::string>();
-                    
-                    user.is_active = userJson.contains("is_active") ? userJson["is_active"].get<bool>() : true;
-                    user.is_reportable = userJson.contains("is_reportable") ? userJson["is_reportable"].get<bool>() : false;
-                    
-                    users.users.push_back(user);
+                    next->cursor(*cursor);
+                }
+                else
+                {
+                    next->offset(page.getOffset() + count);
                 }
             }
-            
-            return true;
         }
-        catch (const nlohmann::json::exception& e)
+
+        // Prefetch the next page while parsing this one
+        std::string nextBody;
+        std::future<bool> prefetch;
+        if (next.has_value())
         {
-            // JSON parsing failed
+            prefetch = std::async(std::launch::async, [this, &nextBody, &apiClient, &next, &pages]()
+                                  { return fetchUsers(nextBody, *apiClient, *next, pages); });
+        }
+
+        std::string error;
+        bool parsed = parseUsers(body, users.users, query.getFields(), error);
+        if (!parsed)
+        {
+            pages.cancel.cancel();
+        }
+        bool fetched = !prefetch.valid() || prefetch.get();
+        if (!parsed)
+        {
+            m_lastError = error;
+        }
+        else if (!fetched)
+        {
+            m_lastError = "Failed to fetch users. Status: " + std::to_string(m_lastStatus);
+        }
+        if (!parsed || !fetched)
+        {
+            users.users.clear();
             return false;
         }
+
+        if (!next.has_value())
+        {
+            return true;
+        }
+        body = std::move(nextBody);
+        page = std::move(*next);
     }
+}
 
-    return false;
+/**
+ * @brief Create a transport with the configured timeouts
+ */
+std::unique_ptr<net::Transport> LogipadClient::createTransport(const std::string& host, int port) const
+{
+    auto transport = m_transportFactory(host, port);
+    transport->setTimeouts(m_connectTimeout, m_readTimeout);
+    return transport;
+}
+
+/**
+ * @brief Set the timeouts
+ * @details Applies to the Keycloak transport and to every API host transport created afterwards.
+ */
+void LogipadClient::setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout)
+{
+    m_connectTimeout = connectTimeout;
+    m_readTimeout = readTimeout;
+    m_transport->setTimeouts(m_connectTimeout, m_readTimeout);
+}
+
+/**
+ * @brief Replace the transport factory
+ * @details Recreates the Keycloak transport with the new factory.
+ */
+void LogipadClient::setTransportFactory(net::TransportFactory factory)
+{
+    m_transportFactory = std::move(factory);
+    m_transport = createTransport(m_host, m_port);
 }
 
 } // namespace client
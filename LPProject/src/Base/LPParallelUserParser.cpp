@@ -0,0 +1,116 @@
+/**
+ * @file LPParallelUserParser.cpp
+ * @brief Implementation of the multi-threaded user list parser
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPParallelUserParser.hpp>
+#include <LPJsonBackend.hpp>
+#include <LPJsonScan.hpp>
+#include <algorithm>
+#include <system_error>
+#include <thread>
+
+namespace logipad
+{
+    namespace json
+    {
+
+        namespace
+        {
+            // Below this many elements per thread the thread start-up cost dominates
+            const std::size_t kMinElementsPerThread = 256;
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        ParallelUserParser::ParallelUserParser(unsigned threads) : m_threads(threads)
+        {
+            if (m_threads == 0)
+            {
+                m_threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
+
+        /**
+         * @brief Parse a user list response
+         * @details The element ranges are split into one contiguous chunk per thread. The
+         *          calling thread parses the first chunk itself. On failure the error of
+         *          the lowest failing chunk is reported.
+         */
+        bool ParallelUserParser::parse(
+            const std::string &body,
+            std::vector<client::LogipadClient::User> &users,
+            std::string &error,
+            const client::UserFieldMask &fields) const
+        {
+            std::vector<Range> elements;
+            if (!scanUserArray(body, elements, error))
+            {
+                return false;
+            }
+
+            std::size_t first = users.size();
+            users.resize(first + elements.size());
+
+            std::size_t chunks = std::min<std::size_t>(m_threads, std::max<std::size_t>(1, elements.size() / kMinElementsPerThread));
+            std::size_t chunkSize = (elements.size() + chunks - 1) / std::max<std::size_t>(1, chunks);
+
+            std::vector<std::string> errors(chunks);
+            auto parseChunk = [&](std::size_t chunk)
+            {
+                std::size_t begin = chunk * chunkSize;
+                std::size_t end = std::min(elements.size(), begin + chunkSize);
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    if (!Backend::parseUser(body, elements[i], users[first + i], errors[chunk], fields))
+                    {
+                        return;
+                    }
+                }
+            };
+
+            std::vector<std::thread> workers;
+            workers.reserve(chunks);
+            try
+            {
+                for (std::size_t chunk = 1; chunk < chunks; ++chunk)
+                {
+                    workers.emplace_back(parseChunk, chunk);
+                }
+            }
+            catch (const std::system_error &)
+            {
+                // Joinable threads must not be destroyed; the started ones still use users
+                for (auto &worker : workers)
+                {
+                    worker.join();
+                }
+                users.resize(first);
+                throw;
+            }
+            if (chunks > 0)
+            {
+                parseChunk(0);
+            }
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+
+            for (const auto &chunkError : errors)
+            {
+                if (!chunkError.empty())
+                {
+                    error = chunkError;
+                    users.resize(first);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    } // namespace json
+} // namespace logipad
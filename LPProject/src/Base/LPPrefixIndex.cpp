@@ -0,0 +1,328 @@
+/**
+ * @file LPPrefixIndex.cpp
+ * @brief Implementation of the front-coded prefix index
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPPrefixIndex.hpp>
+#include <LPBinaryIO.hpp>
+#include <LPLazyUsers.hpp>
+#include <LPUserSearch.hpp>
+#include <algorithm>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Indexed fields, in slot order
+            const UserField kPrefixFields[] = {UserField::Name, UserField::ThreeLc, UserField::FullName};
+
+            // Keys per bucket; only the first key of a bucket is stored in full
+            const std::size_t kBucketKeys = 16;
+
+            // Overlay postings tolerated before a rebuild: an eighth of the dictionary plus this
+            const std::size_t kOverlaySlack = 1024;
+
+            // Length of the common prefix of two keys
+            std::size_t sharedPrefix(std::string_view a, std::string_view b)
+            {
+                std::size_t n = std::min(a.size(), b.size());
+                std::size_t i = 0;
+                while (i < n && a[i] == b[i])
+                {
+                    ++i;
+                }
+                return i;
+            }
+        } // namespace
+
+        // Fields read by the index
+        UserFieldMask PrefixIndex::fields()
+        {
+            return UserFieldMask{UserField::Name, UserField::ThreeLc, UserField::FullName};
+        }
+
+        // Build from decoded users
+        void PrefixIndex::build(const std::vector<LogipadClient::User> &users)
+        {
+            load(users, users.size());
+        }
+
+        // Build from lazily decoded users
+        void PrefixIndex::build(const LazyUsers &users)
+        {
+            load(users, users.size());
+        }
+
+        /**
+         * @brief Build the dictionary
+         * @details All (key, posting) pairs are sorted once; equal keys share one
+         *          dictionary entry whose postings are contiguous in m_postings.
+         */
+        template <typename Source>
+        void PrefixIndex::load(const Source &users, std::size_t count)
+        {
+            std::vector<std::pair<std::string, std::uint32_t>> entries;
+            entries.reserve(count * std::size(kPrefixFields));
+            std::string key;
+            for (std::size_t row = 0; row < count; ++row)
+            {
+                auto &&user = users[row];
+                for (std::uint32_t slot = 0; slot < std::size(kPrefixFields); ++slot)
+                {
+                    UserSearchIndex::fold(user.get(kPrefixFields[slot]).value_or(std::string_view()), key);
+                    if (!key.empty())
+                    {
+                        entries.emplace_back(key, static_cast<std::uint32_t>(row) << kSlotBits | slot);
+                    }
+                }
+            }
+            std::sort(entries.begin(), entries.end());
+
+            m_dictionary.clear();
+            m_buckets.clear();
+            m_keyCount = 0;
+            m_postingStart.clear();
+            m_postings.clear();
+            m_postings.reserve(entries.size());
+            std::string_view previous;
+            for (const auto &[value, posting] : entries)
+            {
+                if (m_keyCount == 0 || value != previous)
+                {
+                    if (m_keyCount % kBucketKeys == 0)
+                    {
+                        m_buckets.push_back(static_cast<std::uint32_t>(m_dictionary.size()));
+                        io::putVarint(m_dictionary, value.size());
+                        m_dictionary += value;
+                    }
+                    else
+                    {
+                        std::size_t shared = sharedPrefix(previous, value);
+                        io::putVarint(m_dictionary, shared);
+                        io::putVarint(m_dictionary, value.size() - shared);
+                        m_dictionary.append(value, shared, std::string::npos);
+                    }
+                    m_postingStart.push_back(static_cast<std::uint32_t>(m_postings.size()));
+                    previous = value;
+                    ++m_keyCount;
+                }
+                m_postings.push_back(posting);
+            }
+            m_postingStart.push_back(static_cast<std::uint32_t>(m_postings.size()));
+
+            m_replaced.assign(count, 0);
+            m_overlay.clear();
+            m_overlayKeys.clear();
+            m_overlaySize = 0;
+        }
+
+        /**
+         * @brief Apply a refresh
+         * @details Dictionary postings of a changed user are masked, and the user's
+         *          previous overlay postings, if any, are removed before its new keys
+         *          are added to the overlay.
+         */
+        void PrefixIndex::update(const std::vector<LogipadClient::User> &users, const std::vector<std::size_t> &changed)
+        {
+            if (users.size() < m_replaced.size() || 2 * changed.size() > users.size())
+            {
+                build(users);
+                return;
+            }
+
+            m_replaced.resize(users.size(), 0);
+            std::string key;
+            for (std::size_t row : changed)
+            {
+                auto user = static_cast<std::uint32_t>(row);
+                m_replaced[row] = 1;
+                auto &keys = m_overlayKeys[user];
+                for (const std::string &old : keys)
+                {
+                    auto it = m_overlay.find(old);
+                    if (it == m_overlay.end())
+                    {
+                        continue;
+                    }
+                    auto &postings = it->second;
+                    auto end = std::remove_if(postings.begin(), postings.end(), [user](std::uint32_t posting)
+                                              { return posting >> kSlotBits == user; });
+                    m_overlaySize -= static_cast<std::size_t>(postings.end() - end);
+                    postings.erase(end, postings.end());
+                    if (postings.empty())
+                    {
+                        m_overlay.erase(it);
+                    }
+                }
+                keys.clear();
+
+                for (std::uint32_t slot = 0; slot < std::size(kPrefixFields); ++slot)
+                {
+                    UserSearchIndex::fold(users[row].get(kPrefixFields[slot]).value_or(std::string_view()), key);
+                    if (!key.empty())
+                    {
+                        auto &postings = m_overlay[key];
+                        std::uint32_t posting = user << kSlotBits | slot;
+                        postings.insert(std::upper_bound(postings.begin(), postings.end(), posting), posting);
+                        keys.push_back(key);
+                        ++m_overlaySize;
+                    }
+                }
+            }
+
+            if (m_overlaySize > m_postings.size() / 8 + kOverlaySlack)
+            {
+                build(users);
+            }
+        }
+
+        // Decode the keys from a bucket on, until the visitor returns false
+        template <typename Visitor>
+        void PrefixIndex::forEachKey(std::size_t bucket, Visitor &&visit) const
+        {
+            io::Reader reader{m_dictionary, m_buckets[bucket]};
+            std::string key;
+            for (std::size_t index = bucket * kBucketKeys; index < m_keyCount; ++index)
+            {
+                std::size_t shared = 0;
+                if (index % kBucketKeys != 0)
+                {
+                    shared = static_cast<std::size_t>(reader.getVarint());
+                }
+                auto suffix = static_cast<std::size_t>(reader.getVarint());
+                key.resize(shared);
+                key.append(m_dictionary, reader.pos, suffix);
+                reader.pos += suffix;
+                if (!visit(index, std::string_view(key)))
+                {
+                    return;
+                }
+            }
+        }
+
+        /**
+         * @brief Find completions
+         * @details The first candidate bucket is the one before the first bucket whose
+         *          head is not below the prefix. Dictionary and overlay keys are merged
+         *          in key order, so the result is the same as for a freshly built index.
+         */
+        void PrefixIndex::complete(std::string_view prefix, std::vector<Completion> &completions, std::size_t limit) const
+        {
+            completions.clear();
+            std::string folded;
+            UserSearchIndex::fold(prefix, folded);
+            if (folded.empty() || limit == 0)
+            {
+                return;
+            }
+            std::string_view wanted = folded;
+            auto matches = [wanted](std::string_view key)
+            {
+                return key.substr(0, wanted.size()) == wanted;
+            };
+
+            // Add the users of one key from the dictionary and the overlay in posting
+            // order, as a fresh build would list them; false once the limit is reached
+            const std::uint32_t *none = nullptr;
+            auto take = [&](const std::uint32_t *dictionary, const std::uint32_t *dictionaryEnd, const std::uint32_t *added, const std::uint32_t *addedEnd)
+            {
+                while (dictionary != dictionaryEnd || added != addedEnd)
+                {
+                    bool fromDictionary = added == addedEnd || (dictionary != dictionaryEnd && *dictionary < *added);
+                    std::uint32_t posting = fromDictionary ? *dictionary++ : *added++;
+                    std::size_t user = posting >> kSlotBits;
+                    if (fromDictionary && m_replaced[user])
+                    {
+                        continue;
+                    }
+                    if (std::any_of(completions.begin(), completions.end(), [user](const Completion &c)
+                                    { return c.user == user; }))
+                    {
+                        continue;
+                    }
+                    completions.push_back(Completion{user, kPrefixFields[posting & ((1u << kSlotBits) - 1)]});
+                    if (completions.size() == limit)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            // Overlay keys before a dictionary key (or all remaining ones)
+            auto overlay = m_overlay.lower_bound(wanted);
+            auto takeOverlay = [&](const std::string_view *before)
+            {
+                for (; overlay != m_overlay.end() && matches(overlay->first) && (before == nullptr || overlay->first < *before); ++overlay)
+                {
+                    const auto &postings = overlay->second;
+                    if (!take(none, none, postings.data(), postings.data() + postings.size()))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            if (!m_buckets.empty())
+            {
+                auto heads = [this](std::size_t bucket)
+                {
+                    io::Reader reader{m_dictionary, m_buckets[bucket]};
+                    auto size = static_cast<std::size_t>(reader.getVarint());
+                    return std::string_view(m_dictionary).substr(reader.pos, size);
+                };
+                std::size_t low = 0, high = m_buckets.size();
+                while (low < high)
+                {
+                    std::size_t mid = (low + high) / 2;
+                    if (heads(mid) < wanted)
+                    {
+                        low = mid + 1;
+                    }
+                    else
+                    {
+                        high = mid;
+                    }
+                }
+
+                bool more = true;
+                forEachKey(low > 0 ? low - 1 : 0, [&](std::size_t index, std::string_view key)
+                           {
+                    if (key < wanted)
+                    {
+                        return true;
+                    }
+                    if (!matches(key))
+                    {
+                        return false;
+                    }
+                    if (!takeOverlay(&key))
+                    {
+                        more = false;
+                        return false;
+                    }
+                    const std::uint32_t *added = none, *addedEnd = none;
+                    if (overlay != m_overlay.end() && overlay->first == key)
+                    {
+                        added = overlay->second.data();
+                        addedEnd = added + overlay->second.size();
+                        ++overlay;
+                    }
+                    more = take(m_postings.data() + m_postingStart[index], m_postings.data() + m_postingStart[index + 1], added, addedEnd);
+                    return more; });
+                if (!more)
+                {
+                    return;
+                }
+            }
+            takeOverlay(nullptr);
+        }
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,290 @@
+/**
+ * @file LPProvisioningJournal.cpp
+ * @brief Implementation of the provisioning write-ahead journal
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPProvisioningJournal.hpp>
+#include <LPBinaryIO.hpp>
+#include <LPHash.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace logipad
+{
+    namespace auth
+    {
+
+        namespace
+        {
+            const char kMagic[] = "LPJRN001";
+            const std::size_t kMagicSize = 8;
+
+            // Record kinds
+            const std::uint8_t kBegin = 1;
+            const std::uint8_t kIntent = 2;
+            const std::uint8_t kOutcome = 3;
+
+            // Checksum of a record body
+            std::uint32_t checksum(std::string_view body)
+            {
+                return static_cast<std::uint32_t>(io::fnv1a(body));
+            }
+
+            // Flush the stdio buffer and sync the file to disk
+            bool syncFile(std::FILE *file)
+            {
+                if (std::fflush(file) != 0)
+                {
+                    return false;
+                }
+#ifdef _WIN32
+                return _commit(_fileno(file)) == 0;
+#else
+                return fsync(fileno(file)) == 0;
+#endif
+            }
+        } // namespace
+
+        // Commit and close
+        ProvisioningJournal::~ProvisioningJournal()
+        {
+            if (m_file != nullptr)
+            {
+                commit();
+                std::fclose(m_file);
+            }
+        }
+
+        /**
+         * @brief Open a journal
+         * @details Records are replayed up to the first one that is incomplete, fails its
+         *          checksum or does not fit the roster; the file is cut there so that new
+         *          records follow the last good one.
+         */
+        bool ProvisioningJournal::open(const std::string &path, bool truncate)
+        {
+            if (m_file != nullptr)
+            {
+                std::fclose(m_file);
+                m_file = nullptr;
+            }
+            m_path = path;
+            m_buffer.clear();
+            m_pending = 0;
+            m_begun = false;
+            m_fingerprint = 0;
+            m_realm.clear();
+            m_entries.clear();
+            m_lastError.clear();
+
+            std::error_code ec;
+            if (truncate || !std::filesystem::exists(path, ec))
+            {
+                m_file = std::fopen(path.c_str(), "wb");
+                if (m_file == nullptr || std::fwrite(kMagic, 1, kMagicSize, m_file) != kMagicSize || !syncFile(m_file))
+                {
+                    m_lastError = "Cannot create journal " + path;
+                    return false;
+                }
+                return true;
+            }
+
+            std::ifstream in(path, std::ios::binary);
+            std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (!in.good() && !in.eof())
+            {
+                m_lastError = "Cannot read journal " + path;
+                return false;
+            }
+            if (data.compare(0, kMagicSize, kMagic) != 0)
+            {
+                m_lastError = "Not a provisioning journal: " + path;
+                return false;
+            }
+
+            std::size_t good = kMagicSize;
+            while (good < data.size())
+            {
+                io::Reader header{data, good};
+                std::uint32_t length = header.getU32();
+                std::uint32_t sum = header.getU32();
+                if (!header.ok || data.size() - header.pos < length)
+                {
+                    break;
+                }
+                std::string body = data.substr(header.pos, length);
+                if (checksum(body) != sum || !replay(body))
+                {
+                    break;
+                }
+                good = header.pos + length;
+            }
+            if (good < data.size())
+            {
+                std::filesystem::resize_file(path, good, ec);
+                if (ec)
+                {
+                    m_lastError = "Cannot repair journal " + path + ": " + ec.message();
+                    return false;
+                }
+            }
+
+            m_file = std::fopen(path.c_str(), "ab");
+            if (m_file == nullptr)
+            {
+                m_lastError = "Cannot append to journal " + path;
+                return false;
+            }
+            return true;
+        }
+
+        // Apply one record read from the file
+        bool ProvisioningJournal::replay(const std::string &body)
+        {
+            io::Reader reader{body};
+            auto kind = static_cast<std::uint8_t>(reader.getInt(1));
+            if (kind == kBegin)
+            {
+                std::uint64_t fingerprint = reader.getU64();
+                std::uint64_t size = reader.getVarint();
+                std::string realm = reader.getString();
+                if (!reader.ok || m_begun)
+                {
+                    return false;
+                }
+                m_begun = true;
+                m_fingerprint = fingerprint;
+                m_realm = realm;
+                m_entries.assign(static_cast<std::size_t>(size), Entry());
+                return true;
+            }
+
+            std::uint64_t index = reader.getVarint();
+            if (!reader.ok || !m_begun || index >= m_entries.size())
+            {
+                return false;
+            }
+            Entry &entry = m_entries[static_cast<std::size_t>(index)];
+            if (kind == kIntent)
+            {
+                entry = Entry{State::Intended, 0, std::string()};
+                return true;
+            }
+            if (kind == kOutcome)
+            {
+                auto state = static_cast<State>(reader.getInt(1));
+                auto status = static_cast<int>(reader.getVarint());
+                std::string message = reader.getString();
+                if (!reader.ok || state < State::Created || state > State::Failed)
+                {
+                    return false;
+                }
+                entry = Entry{state, status, std::move(message)};
+                return true;
+            }
+            return false;
+        }
+
+        // Bind to a roster
+        bool ProvisioningJournal::begin(std::uint64_t fingerprint, std::size_t size, const std::string &realm)
+        {
+            if (m_begun)
+            {
+                if (fingerprint != m_fingerprint || size != m_entries.size() || realm != m_realm)
+                {
+                    m_lastError = "Journal " + m_path + " was written for another roster or realm";
+                    return false;
+                }
+                return true;
+            }
+
+            std::string body(1, static_cast<char>(kBegin));
+            io::putU64(body, fingerprint);
+            io::putVarint(body, size);
+            io::putString(body, realm);
+            append(body);
+            m_begun = true;
+            m_fingerprint = fingerprint;
+            m_realm = realm;
+            m_entries.assign(size, Entry());
+            return true;
+        }
+
+        // Record an intent
+        void ProvisioningJournal::intent(std::size_t index)
+        {
+            std::string body(1, static_cast<char>(kIntent));
+            io::putVarint(body, index);
+            append(body);
+            m_entries[index] = Entry{State::Intended, 0, std::string()};
+        }
+
+        // Record an outcome
+        void ProvisioningJournal::outcome(std::size_t index, State state, int status, const std::string &message)
+        {
+            std::string body(1, static_cast<char>(kOutcome));
+            io::putVarint(body, index);
+            body += static_cast<char>(state);
+            io::putVarint(body, static_cast<std::uint64_t>(status < 0 ? 0 : status));
+            io::putString(body, message);
+            append(body);
+            m_entries[index] = Entry{state, status, message};
+        }
+
+        // Frame a record into the pending buffer
+        void ProvisioningJournal::append(const std::string &body)
+        {
+            io::putU32(m_buffer, static_cast<std::uint32_t>(body.size()));
+            io::putU32(m_buffer, checksum(body));
+            m_buffer += body;
+            ++m_pending;
+        }
+
+        /**
+         * @brief Commit pending records
+         * @details One write and one fsync for the whole group.
+         */
+        bool ProvisioningJournal::commit()
+        {
+            if (m_file == nullptr)
+            {
+                m_lastError = "Journal is not open";
+                return false;
+            }
+            if (m_pending == 0)
+            {
+                return true;
+            }
+            if (std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size() || !syncFile(m_file))
+            {
+                m_lastError = "Cannot write journal " + m_path;
+                return false;
+            }
+            m_buffer.clear();
+            m_pending = 0;
+            return true;
+        }
+
+        // Fingerprint a roster
+        std::uint64_t ProvisioningJournal::fingerprint(const std::vector<KeycloakClient::UserInfo> &roster)
+        {
+            std::string keys;
+            for (const auto &user : roster)
+            {
+                io::putString(keys, user.username);
+                io::putString(keys, user.email);
+            }
+            return io::xxh64(keys);
+        }
+
+    } // namespace auth
+} // namespace logipad
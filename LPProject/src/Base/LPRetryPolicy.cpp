@@ -0,0 +1,44 @@
+/**
+ * @file LPRetryPolicy.cpp
+ * @brief Implementation of the retry policy
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPRetryPolicy.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @brief Get the delay before a retry
+         * @details "Equal jitter": the lower half of the capped exponential delay is
+         *          fixed, the upper half uniformly random.
+         */
+        std::chrono::milliseconds RetryPolicy::delay(int attempt) const
+        {
+            double base = static_cast<double>(initialDelay.count()) * std::pow(multiplier, std::max(0, attempt - 1));
+            auto capped = static_cast<std::int64_t>(std::min(base, static_cast<double>(maxDelay.count())));
+            if (!jitter || capped < 2)
+            {
+                return std::chrono::milliseconds(capped);
+            }
+            thread_local std::mt19937_64 random{std::random_device{}()};
+            std::uniform_int_distribution<std::int64_t> upper(0, capped - capped / 2);
+            return std::chrono::milliseconds(capped / 2 + upper(random));
+        }
+
+        // Transient outcomes
+        bool RetryPolicy::isRetryable(int status)
+        {
+            return status == 0 || status == 408 || status == 429 || status >= 500;
+        }
+
+    } // namespace net
+} // namespace logipad
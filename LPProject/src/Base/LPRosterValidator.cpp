@@ -0,0 +1,249 @@
+/**
+ * @file LPRosterValidator.cpp
+ * @brief Implementation of the roster validator
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPRosterValidator.hpp>
+#include <LPEmail.hpp>
+#include <LPWorkerThreads.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+namespace logipad
+{
+    namespace auth
+    {
+
+        namespace
+        {
+            // Below this many users per thread the thread start-up cost dominates
+            const std::size_t kMinRowsPerThread = 2048;
+
+            bool isAlnum(char c)
+            {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+            }
+
+            // Characters accepted in usernames
+            bool isUsernameChar(char c)
+            {
+                return isAlnum(c) || c == '.' || c == '_' || c == '-' || c == '@';
+            }
+
+            // RFC 5322 atext characters of an unquoted local part
+            bool isAtext(char c)
+            {
+                return isAlnum(c) || std::string_view("!#$%&'*+/=?^_`{|}~-").find(c) != std::string_view::npos;
+            }
+
+            // Value without surrounding white space
+            std::string_view trim(std::string_view value)
+            {
+                while (!value.empty() && static_cast<unsigned char>(value.front()) <= ' ')
+                {
+                    value.remove_prefix(1);
+                }
+                while (!value.empty() && static_cast<unsigned char>(value.back()) <= ' ')
+                {
+                    value.remove_suffix(1);
+                }
+                return value;
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        RosterValidator::RosterValidator(const Options &options) : m_options(options)
+        {
+            if (m_options.threads == 0)
+            {
+                m_options.threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
+
+        /**
+         * @brief Default constructor implementation
+         */
+        RosterValidator::RosterValidator() : RosterValidator(Options())
+        {
+        }
+
+        // Field names as in UserInfo::toJson()
+        const char *RosterValidator::fieldName(Field field)
+        {
+            switch (field)
+            {
+            case Field::Username: return "username";
+            case Field::Email: return "email";
+            case Field::FirstName: return "firstName";
+            case Field::LastName: return "lastName";
+            case Field::Password: return "password";
+            }
+            return "";
+        }
+
+        /**
+         * @brief Check email syntax
+         * @details Quoted local parts, IP literals and internationalized domains are not
+         *          accepted; Keycloak's own email validator rejects them as well.
+         */
+        bool RosterValidator::isValidEmail(std::string_view email)
+        {
+            std::size_t at = email.find('@');
+            if (at == std::string_view::npos || email.size() > 254)
+            {
+                return false;
+            }
+            std::string_view local = email.substr(0, at);
+            std::string_view domain = email.substr(at + 1);
+            if (local.empty() || local.size() > 64 || local.front() == '.' || local.back() == '.' ||
+                local.find("..") != std::string_view::npos ||
+                !std::all_of(local.begin(), local.end(), [](char c)
+                             { return isAtext(c) || c == '.'; }))
+            {
+                return false;
+            }
+
+            std::size_t labels = 0;
+            std::string_view last;
+            while (true)
+            {
+                std::size_t dot = domain.find('.');
+                std::string_view label = domain.substr(0, dot);
+                if (label.empty() || label.size() > 63 || label.front() == '-' || label.back() == '-' ||
+                    !std::all_of(label.begin(), label.end(), [](char c)
+                                 { return isAlnum(c) || c == '-'; }))
+                {
+                    return false;
+                }
+                ++labels;
+                last = label;
+                if (dot == std::string_view::npos)
+                {
+                    break;
+                }
+                domain.remove_prefix(dot + 1);
+            }
+            return labels >= 2 && last.size() >= 2 && std::all_of(last.begin(), last.end(), [](char c)
+                                                                   { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); });
+        }
+
+        // Check one user
+        void RosterValidator::check(const KeycloakClient::UserInfo &user, std::size_t row, std::vector<Issue> &issues) const
+        {
+            auto issue = [&](Field field, std::string message)
+            {
+                issues.push_back(Issue{row, field, std::move(message)});
+            };
+
+            if (user.username.empty())
+            {
+                issue(Field::Username, "Username is required");
+            }
+            else if (user.username.size() > m_options.maxUsernameLength)
+            {
+                issue(Field::Username, "Username is longer than " + std::to_string(m_options.maxUsernameLength) + " characters");
+            }
+            else if (!std::all_of(user.username.begin(), user.username.end(), isUsernameChar))
+            {
+                issue(Field::Username, "Username '" + user.username + "' may only contain letters, digits and . _ - @");
+            }
+
+            if (user.email.empty())
+            {
+                issue(Field::Email, "Email is required");
+            }
+            else if (!isValidEmail(user.email))
+            {
+                issue(Field::Email, "Email '" + user.email + "' is not a valid address");
+            }
+
+            const std::pair<Field, const std::string *> names[] = {{Field::FirstName, &user.firstName}, {Field::LastName, &user.lastName}};
+            for (const auto &[field, value] : names)
+            {
+                if (trim(*value).empty())
+                {
+                    issue(field, std::string(fieldName(field)) + " is required");
+                }
+                else if (value->size() > m_options.maxNameLength)
+                {
+                    issue(field, std::string(fieldName(field)) + " is longer than " + std::to_string(m_options.maxNameLength) + " characters");
+                }
+            }
+
+            if (user.password.size() < std::max<std::size_t>(1, m_options.minPasswordLength))
+            {
+                issue(Field::Password, user.password.empty() ? std::string("Password is required")
+                                                             : "Password is shorter than " + std::to_string(m_options.minPasswordLength) + " characters");
+            }
+        }
+
+        // Validate a single user
+        bool RosterValidator::validate(const KeycloakClient::UserInfo &user, std::vector<Issue> &issues) const
+        {
+            issues.clear();
+            check(user, 0, issues);
+            return issues.empty();
+        }
+
+        /**
+         * @brief Validate a roster
+         * @details Rows are split into one contiguous range per thread, each collecting
+         *          its own issues; the duplicate check runs afterwards over the whole
+         *          roster and skips fields that are already invalid. Issues are finally
+         *          ordered by row and field.
+         */
+        bool RosterValidator::validate(const std::vector<KeycloakClient::UserInfo> &roster, std::vector<Issue> &issues, const client::DuplicateDetector *known) const
+        {
+            issues.clear();
+            std::size_t chunks = std::min<std::size_t>(m_options.threads, std::max<std::size_t>(1, roster.size() / kMinRowsPerThread));
+            std::size_t size = (roster.size() + chunks - 1) / chunks;
+            std::vector<std::vector<Issue>> found(chunks);
+            auto work = [&](std::size_t chunk)
+            {
+                for (std::size_t row = chunk * size; row < std::min(roster.size(), (chunk + 1) * size); ++row)
+                {
+                    check(roster[row], row, found[chunk]);
+                }
+            };
+            core::runTasks(chunks, work);
+            for (auto &part : found)
+            {
+                issues.insert(issues.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+            }
+
+            // Fields that already failed are not reported again as duplicates
+            std::vector<std::uint8_t> failed(roster.size(), 0);
+            for (const auto &issue : issues)
+            {
+                failed[issue.row] |= static_cast<std::uint8_t>(1u << static_cast<unsigned>(issue.field));
+            }
+
+            client::DuplicateDetector local;
+            std::vector<client::DuplicateDetector::Duplicate> duplicates;
+            (known != nullptr ? *known : local).check(roster, duplicates);
+            for (const auto &duplicate : duplicates)
+            {
+                bool email = duplicate.key == client::DuplicateDetector::Key::Email;
+                Field field = email ? Field::Email : Field::Username;
+                if (failed[duplicate.index] & (1u << static_cast<unsigned>(field)))
+                {
+                    continue;
+                }
+                std::string holder = duplicate.owner.empty() ? "row " + std::to_string(duplicate.row)
+                                                             : "tenant " + duplicate.owner + " (row " + std::to_string(duplicate.row) + ")";
+                issues.push_back(Issue{duplicate.index, field,
+                                       std::string(email ? "Email '" : "Username '") + duplicate.value + "' is already used by " + holder});
+            }
+
+            std::stable_sort(issues.begin(), issues.end(), [](const Issue &a, const Issue &b)
+                             { return a.row != b.row ? a.row < b.row : a.field < b.field; });
+            return issues.empty();
+        }
+
+    } // namespace auth
+} // namespace logipad
@@ -0,0 +1,176 @@
+/**
+ * @file LPTransport.cpp
+ * @brief Implementation of the HTTP transport layer
+ * @details This file implements the Request helpers and the default
+ *          HttpTransport based on httplib::SSLClient.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPTransport.hpp>
+#include <algorithm>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        // Build a GET request
+        Request Request::get(const std::string &path, const httplib::Headers &headers)
+        {
+            Request request;
+            request.method = "GET";
+            request.path = path;
+            request.headers = headers;
+            return request;
+        }
+
+        // Build a POST request with a raw body
+        Request Request::post(
+            const std::string &path,
+            const httplib::Headers &headers,
+            const std::string &body,
+            const std::string &contentType)
+        {
+            Request request;
+            request.method = "POST";
+            request.path = path;
+            request.headers = headers;
+            request.body = body;
+            request.contentType = contentType;
+            return request;
+        }
+
+        // Build a form-encoded POST request
+        Request Request::postForm(const std::string &path, const httplib::Params &params)
+        {
+            return post(path, {}, httplib::detail::params_to_query_str(params), "application/x-www-form-urlencoded");
+        }
+
+        /**
+         * @brief Get the supported content codings
+         * @details The CPPHTTPLIB_*_SUPPORT definitions are exported by the httplib target
+         *          when zlib or brotli were found (see cmake/cpp-httplib.cmake).
+         */
+        std::string acceptEncoding()
+        {
+            std::string encodings;
+#ifdef CPPHTTPLIB_BROTLI_SUPPORT
+            encodings = "br";
+#endif
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+            encodings += encodings.empty() ? "gzip, deflate" : ", gzip, deflate";
+#endif
+            return encodings;
+        }
+
+        /**
+         * @brief Constructor implementation
+         * @details Creates the underlying SSL client for the given endpoint.
+         */
+        HttpTransport::HttpTransport(const std::string &host, int port) : m_host(host),
+                                                                          m_port(port),
+                                                                          m_client(std::make_unique<httplib::SSLClient>(host, port)),
+                                                                          m_acceptEncoding(acceptEncoding()),
+                                                                          m_connectTimeout(std::chrono::seconds(CPPHTTPLIB_CONNECTION_TIMEOUT_SECOND)),
+                                                                          m_readTimeout(std::chrono::seconds(CPPHTTPLIB_READ_TIMEOUT_SECOND))
+        {
+            m_client->set_decompress(true);
+        }
+
+        /**
+         * @brief Destructor implementation
+         */
+        HttpTransport::~HttpTransport() = default;
+
+        /**
+         * @brief Send a request through httplib
+         * @details Converts the Request into an httplib::Request. The Content-Type header
+         *          is added from Request::contentType unless the caller already set one;
+         *          Accept-Encoding likewise. The read timeout applies to every wait for
+         *          data, so the deadline is also checked by the progress callback between
+         *          received chunks of the body.
+         *
+         *          httplib::SSLClient::stop() only shuts down a socket of a request in
+         *          flight. A cancel that lands in the short gap between the second check
+         *          and httplib registering the socket is caught by the progress callback
+         *          once the response starts, and the timeouts stay bounded by the deadline.
+         */
+        httplib::Result HttpTransport::send(const Request &request)
+        {
+            const CallContext &context = request.context;
+            if (context.stopped())
+            {
+                return httplib::Result(nullptr, httplib::Error::Canceled);
+            }
+
+            httplib::Request req;
+            req.method = request.method;
+            req.path = request.path;
+            req.headers = request.headers;
+            req.body = request.body;
+
+            if (!request.contentType.empty() && !req.has_header("Content-Type"))
+            {
+                req.set_header("Content-Type", request.contentType);
+            }
+            if (!m_acceptEncoding.empty() && !req.has_header("Accept-Encoding"))
+            {
+                req.set_header("Accept-Encoding", m_acceptEncoding);
+            }
+
+            req.progress = [&context](std::uint64_t, std::uint64_t)
+            {
+                return !context.stopped();
+            };
+
+            // Never below 1 ms: httplib treats a zero timeout as an immediate failure
+            std::chrono::milliseconds left = std::max(context.deadline.remaining(), std::chrono::milliseconds(1));
+            m_client->set_connection_timeout(std::min(m_connectTimeout, left));
+            m_client->set_read_timeout(std::min(m_readTimeout, left));
+
+            // A cancel between the check above and the registration ran the callback
+            // before any socket existed, which stops nothing; check again so it is not lost
+            std::size_t callback = context.cancel.onCancel([this]
+                                                           { m_client->stop(); });
+            if (context.stopped())
+            {
+                context.cancel.removeCallback(callback);
+                return httplib::Result(nullptr, httplib::Error::Canceled);
+            }
+            auto result = m_client->send(req);
+            context.cancel.removeCallback(callback);
+            if (result.error() != httplib::Error::Success && context.stopped())
+            {
+                return httplib::Result(nullptr, httplib::Error::Canceled);
+            }
+            return result;
+        }
+
+        /**
+         * @brief Set the timeouts
+         * @details Applied to the SSL client on every send(), clamped to the deadline.
+         */
+        void HttpTransport::setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout)
+        {
+            m_connectTimeout = connectTimeout;
+            m_readTimeout = readTimeout;
+        }
+
+        // Get endpoint
+        std::string HttpTransport::endpoint() const
+        {
+            return m_host + ":" + std::to_string(m_port);
+        }
+
+        // Default factory
+        TransportFactory httpTransportFactory()
+        {
+            return [](const std::string &host, int port) -> std::unique_ptr<Transport>
+            {
+                return std::make_unique<HttpTransport>(host, port);
+            };
+        }
+
+    } // namespace net
+} // namespace logipad
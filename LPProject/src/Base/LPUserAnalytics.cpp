@@ -0,0 +1,261 @@
+/**
+ * @file LPUserAnalytics.cpp
+ * @brief Implementation of the inactive-user and license analytics
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserAnalytics.hpp>
+#include <LPUserTable.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Rows processed per batch
+            const std::size_t kBatchRows = 1024;
+
+            // Timestamps that make up a user's last activity
+            const UserField kActivityFields[] = {
+                UserField::LastLoginAt,
+                UserField::LastActivityAt,
+                UserField::LastDocumentServiceActivity,
+                UserField::LastEformServiceActivity,
+                UserField::LastBriefingServiceActivity};
+
+            // Per-service activity timestamps, in Counts::serviceActive order
+            const UserField kServiceFields[UserAnalytics::kServiceCount] = {
+                UserField::LastDocumentServiceActivity,
+                UserField::LastEformServiceActivity,
+                UserField::LastBriefingServiceActivity};
+
+            // Column titles of the per-service figures
+            const char *const kServiceNames[UserAnalytics::kServiceCount] = {"document", "eform", "briefing"};
+
+            // Format a threshold as "90d", "12h" or "45s"
+            std::string durationName(std::int64_t seconds)
+            {
+                if (seconds % 86400 == 0)
+                {
+                    return std::to_string(seconds / 86400) + "d";
+                }
+                if (seconds % 3600 == 0)
+                {
+                    return std::to_string(seconds / 3600) + "h";
+                }
+                return std::to_string(seconds) + "s";
+            }
+
+            // Add the figures of one group to another
+            void accumulate(UserAnalytics::Counts &to, const UserAnalytics::Counts &from)
+            {
+                to.users += from.users;
+                to.active += from.active;
+                to.neverSeen += from.neverSeen;
+                for (std::size_t t = 0; t < to.inactive.size(); ++t)
+                {
+                    to.inactive[t] += from.inactive[t];
+                }
+                for (std::size_t s = 0; s < UserAnalytics::kServiceCount; ++s)
+                {
+                    to.serviceActive[s] += from.serviceActive[s];
+                }
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        UserAnalytics::UserAnalytics(const Options &options) : m_options(options)
+        {
+        }
+
+        // Fields read by the analysis
+        UserFieldMask UserAnalytics::fields()
+        {
+            UserFieldMask mask{UserField::IsActive, UserField::IsReportable, UserField::Department};
+            for (UserField field : kActivityFields)
+            {
+                mask.add(field);
+            }
+            return mask;
+        }
+
+        // Analyze relative to the current time
+        bool UserAnalytics::analyze(const UserTable &table, Report &report) const
+        {
+            auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            return analyze(table, report, static_cast<std::int64_t>(now));
+        }
+
+        /**
+         * @brief Analyze a table
+         * @details Rows are processed in batches: the last activity of a batch is the
+         *          element-wise maximum of the activity columns (kNoTime is the smallest
+         *          value, so missing timestamps drop out), after which every row adds to
+         *          the counters of its department. Totals are the sum over departments.
+         */
+        bool UserAnalytics::analyze(const UserTable &table, Report &report, std::int64_t now) const
+        {
+            report = Report();
+            report.now = now;
+            report.thresholds = m_options.thresholds;
+
+            const auto *reportable = table.flags(UserField::IsReportable);
+            const auto *active = table.flags(UserField::IsActive);
+            const UserTable::TextColumn *department = m_options.byDepartment ? table.text(UserField::Department) : nullptr;
+            if (reportable == nullptr || active == nullptr || (m_options.byDepartment && department == nullptr))
+            {
+                m_lastError = "Table lacks is_active, is_reportable or department";
+                return false;
+            }
+            std::vector<const std::int64_t *> activity;
+            for (UserField field : kActivityFields)
+            {
+                const auto *column = table.times(field);
+                if (column == nullptr)
+                {
+                    m_lastError = std::string("Table lacks ") + userFieldName(field);
+                    return false;
+                }
+                activity.push_back(column->data());
+            }
+            const std::int64_t *services[kServiceCount];
+            for (std::size_t s = 0; s < kServiceCount; ++s)
+            {
+                services[s] = table.times(kServiceFields[s])->data();
+            }
+
+            // Activity before a cutoff means inactive for that threshold
+            std::vector<std::int64_t> cutoffs;
+            for (std::int64_t threshold : m_options.thresholds)
+            {
+                cutoffs.push_back(now - threshold);
+            }
+            std::int64_t serviceCutoff = now - m_options.serviceWindow;
+
+            Counts empty;
+            empty.inactive.assign(cutoffs.size(), 0);
+            std::vector<Counts> groups(department != nullptr ? department->dictionary.size() : 1, empty);
+
+            std::int64_t lastSeen[kBatchRows];
+            for (std::size_t begin = 0; begin < table.size(); begin += kBatchRows)
+            {
+                std::size_t count = std::min(kBatchRows, table.size() - begin);
+                std::fill(lastSeen, lastSeen + count, UserTable::kNoTime);
+                for (const std::int64_t *column : activity)
+                {
+                    const std::int64_t *values = column + begin;
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        lastSeen[i] = std::max(lastSeen[i], values[i]);
+                    }
+                }
+
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    std::size_t row = begin + i;
+                    if (!(*reportable)[row])
+                    {
+                        ++report.excluded;
+                        continue;
+                    }
+                    Counts &group = groups[department != nullptr ? department->codes[row] : 0];
+                    ++group.users;
+                    group.active += (*active)[row];
+                    group.neverSeen += lastSeen[i] == UserTable::kNoTime;
+                    for (std::size_t t = 0; t < cutoffs.size(); ++t)
+                    {
+                        group.inactive[t] += lastSeen[i] < cutoffs[t];
+                    }
+                    for (std::size_t s = 0; s < kServiceCount; ++s)
+                    {
+                        group.serviceActive[s] += services[s][row] >= serviceCutoff;
+                    }
+                }
+            }
+
+            report.total = empty;
+            for (std::size_t code = 0; code < groups.size(); ++code)
+            {
+                accumulate(report.total, groups[code]);
+                if (department != nullptr && groups[code].users > 0)
+                {
+                    report.departments.emplace_back(department->dictionary[code], std::move(groups[code]));
+                }
+            }
+            std::sort(report.departments.begin(), report.departments.end(), [](const auto &a, const auto &b)
+                      { return a.first < b.first; });
+            return true;
+        }
+
+        // Format a report
+        std::string UserAnalytics::format(const Report &report)
+        {
+            std::vector<std::string> header = {"department", "users", "active", "never"};
+            for (std::int64_t threshold : report.thresholds)
+            {
+                header.push_back("inactive>" + durationName(threshold));
+            }
+            for (const char *name : kServiceNames)
+            {
+                header.push_back(name);
+            }
+
+            auto cells = [](const std::string &name, const Counts &counts)
+            {
+                std::vector<std::string> row = {name, std::to_string(counts.users), std::to_string(counts.active), std::to_string(counts.neverSeen)};
+                for (std::size_t value : counts.inactive)
+                {
+                    row.push_back(std::to_string(value));
+                }
+                for (std::size_t value : counts.serviceActive)
+                {
+                    row.push_back(std::to_string(value));
+                }
+                return row;
+            };
+            std::vector<std::vector<std::string>> rows = {header, cells("(total)", report.total)};
+            for (const auto &[name, counts] : report.departments)
+            {
+                rows.push_back(cells(name.empty() ? "(none)" : name, counts));
+            }
+
+            // Department left-aligned, figures right-aligned
+            std::vector<std::size_t> widths(header.size(), 0);
+            for (const auto &row : rows)
+            {
+                for (std::size_t c = 0; c < row.size(); ++c)
+                {
+                    widths[c] = std::max(widths[c], row[c].size());
+                }
+            }
+            std::string out;
+            for (const auto &row : rows)
+            {
+                for (std::size_t c = 0; c < row.size(); ++c)
+                {
+                    std::size_t pad = widths[c] - row[c].size();
+                    if (c == 0)
+                    {
+                        out += row[c];
+                        out.append(pad, ' ');
+                    }
+                    else
+                    {
+                        out.append(pad + 2, ' ');
+                        out += row[c];
+                    }
+                }
+                out += '\n';
+            }
+            return out;
+        }
+
+    } // namespace client
+} // namespace logipad
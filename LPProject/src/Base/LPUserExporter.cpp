@@ -0,0 +1,409 @@
+/**
+ * @file LPUserExporter.cpp
+ * @brief Implementation of the user directory exporter
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserExporter.hpp>
+#include <LPBinaryIO.hpp>
+#include <LPLazyUsers.hpp>
+#include <LPWorkerThreads.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Buffer of the output stream; chunks are usually larger and bypass it
+            const std::size_t kWriteBufferSize = 1024 * 1024;
+
+            const char kBinaryMagic[] = "LPUSR001";
+            const std::size_t kBinaryMagicSize = sizeof(kBinaryMagic) - 1;
+
+            // Append a CSV field, quoted only when needed
+            void appendCsvField(std::string &out, std::string_view value)
+            {
+                if (value.find_first_of(",\"\r\n") == std::string_view::npos)
+                {
+                    out.append(value.data(), value.size());
+                    return;
+                }
+                out.push_back('"');
+                for (char c : value)
+                {
+                    if (c == '"')
+                    {
+                        out.push_back('"');
+                    }
+                    out.push_back(c);
+                }
+                out.push_back('"');
+            }
+
+            // Append a JSON string literal
+            void appendJsonString(std::string &out, std::string_view value)
+            {
+                static const char kHex[] = "0123456789abcdef";
+                out.push_back('"');
+                for (char c : value)
+                {
+                    switch (c)
+                    {
+                    case '"': out += "\\\""; break;
+                    case '\\': out += "\\\\"; break;
+                    case '\b': out += "\\b"; break;
+                    case '\f': out += "\\f"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                        {
+                            out += "\\u00";
+                            out.push_back(kHex[(c >> 4) & 0xF]);
+                            out.push_back(kHex[c & 0xF]);
+                        }
+                        else
+                        {
+                            out.push_back(c);
+                        }
+                    }
+                }
+                out.push_back('"');
+            }
+
+            /**
+             * @brief Format a range of users
+             * @details Works on anything indexable whose elements provide get(UserField),
+             *          i.e. LogipadClient::User and LazyUsers::View.
+             */
+            template <typename Source>
+            void formatRows(
+                const Source &users,
+                std::size_t begin,
+                std::size_t end,
+                ExportFormat format,
+                const std::vector<UserField> &fields,
+                std::string &out)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    auto &&user = users[i];
+                    switch (format)
+                    {
+                    case ExportFormat::Csv:
+                        for (std::size_t f = 0; f < fields.size(); ++f)
+                        {
+                            if (f > 0)
+                            {
+                                out.push_back(',');
+                            }
+                            auto value = user.get(fields[f]);
+                            if (value.has_value())
+                            {
+                                appendCsvField(out, *value);
+                            }
+                        }
+                        out.push_back('\n');
+                        break;
+
+                    case ExportFormat::NdJson:
+                    {
+                        out.push_back('{');
+                        bool first = true;
+                        for (UserField field : fields)
+                        {
+                            auto value = user.get(field);
+                            if (!value.has_value())
+                            {
+                                continue;
+                            }
+                            if (!first)
+                            {
+                                out.push_back(',');
+                            }
+                            first = false;
+                            out.push_back('"');
+                            out += userFieldName(field);
+                            out += "\":";
+                            if (isBooleanField(field))
+                            {
+                                out.append(value->data(), value->size());
+                            }
+                            else
+                            {
+                                appendJsonString(out, *value);
+                            }
+                        }
+                        out += "}\n";
+                        break;
+                    }
+
+                    case ExportFormat::Binary:
+                    {
+                        std::size_t bitmapPos = out.size();
+                        io::putU32(out, 0);
+                        std::uint32_t bitmap = 0;
+                        for (std::size_t f = 0; f < fields.size(); ++f)
+                        {
+                            auto value = user.get(fields[f]);
+                            if (isBooleanField(fields[f]))
+                            {
+                                bitmap |= (value == "true" ? 1u : 0u) << f;
+                            }
+                            else if (value.has_value())
+                            {
+                                bitmap |= 1u << f;
+                                io::putVarint(out, value->size());
+                                out.append(value->data(), value->size());
+                            }
+                        }
+                        std::string encoded;
+                        io::putU32(encoded, bitmap);
+                        std::memcpy(&out[bitmapPos], encoded.data(), encoded.size());
+                        break;
+                    }
+                    }
+                }
+            }
+
+            // Number of rows of a source
+            std::size_t rowCount(const std::vector<LogipadClient::User> &users) { return users.size(); }
+            std::size_t rowCount(const LazyUsers &users) { return users.size(); }
+        } // namespace
+
+        // Look up a format by name
+        bool exportFormatFromName(std::string_view name, ExportFormat &format)
+        {
+            if (name == "csv")
+                format = ExportFormat::Csv;
+            else if (name == "ndjson")
+                format = ExportFormat::NdJson;
+            else if (name == "binary")
+                format = ExportFormat::Binary;
+            else
+                return false;
+            return true;
+        }
+
+        /**
+         * @brief Constructor implementation
+         */
+        UserExporter::UserExporter(const Options &options) : m_options(options)
+        {
+            if (m_options.threads == 0)
+            {
+                m_options.threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            m_options.rowsPerChunk = std::max<std::size_t>(1, m_options.rowsPerChunk);
+        }
+
+        // Check for zlib
+        bool UserExporter::gzipSupported()
+        {
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // Export eagerly decoded users
+        bool UserExporter::exportToFile(const std::vector<LogipadClient::User> &users, const std::string &path)
+        {
+            return run(users, path);
+        }
+
+        // Export lazily decoded users
+        bool UserExporter::exportToFile(const LazyUsers &users, const std::string &path)
+        {
+            return run(users, path);
+        }
+
+        /**
+         * @brief Build the format header
+         * @details CSV gets the column names, binary the magic and field table; NDJSON
+         *          has no header.
+         */
+        std::string UserExporter::header() const
+        {
+            std::string out;
+            std::vector<UserField> fields = m_options.fields.toFields();
+            switch (m_options.format)
+            {
+            case ExportFormat::Csv:
+                for (std::size_t f = 0; f < fields.size(); ++f)
+                {
+                    if (f > 0)
+                    {
+                        out.push_back(',');
+                    }
+                    out += userFieldName(fields[f]);
+                }
+                out.push_back('\n');
+                break;
+            case ExportFormat::NdJson:
+                break;
+            case ExportFormat::Binary:
+                out.assign(kBinaryMagic, kBinaryMagicSize);
+                io::putU32(out, static_cast<std::uint32_t>(fields.size()));
+                for (UserField field : fields)
+                {
+                    io::putString(out, userFieldName(field));
+                }
+                break;
+            }
+            return out;
+        }
+
+        /**
+         * @brief Compress a chunk into a standalone gzip member
+         */
+        bool UserExporter::compress(std::string &chunk) const
+        {
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+            z_stream stream{};
+            if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                return false;
+            }
+            std::string compressed(deflateBound(&stream, static_cast<uLong>(chunk.size())), '\0');
+            stream.next_in = reinterpret_cast<Bytef *>(chunk.data());
+            stream.avail_in = static_cast<uInt>(chunk.size());
+            stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+            stream.avail_out = static_cast<uInt>(compressed.size());
+            int rc = deflate(&stream, Z_FINISH);
+            compressed.resize(stream.total_out);
+            deflateEnd(&stream);
+            if (rc != Z_STREAM_END)
+            {
+                return false;
+            }
+            chunk = std::move(compressed);
+            return true;
+#else
+            (void)chunk;
+            return false;
+#endif
+        }
+
+        /**
+         * @brief Run an export
+         * @details Chunks are formatted in waves of two chunks per thread. Each worker
+         *          formats (and compresses) every threads-th chunk of the wave into its
+         *          own slot; the slots are then written in order. Memory use is bounded
+         *          by the wave size, independent of the number of users.
+         */
+        template <typename Source>
+        bool UserExporter::run(const Source &users, const std::string &path)
+        {
+            m_bytesWritten = 0;
+            m_lastError.clear();
+            if (m_options.gzip && !gzipSupported())
+            {
+                m_lastError = "gzip output requires zlib support";
+                return false;
+            }
+
+            bool toStdout = path == "-";
+            std::FILE *file = toStdout ? stdout : std::fopen(path.c_str(), "wb");
+            if (file == nullptr)
+            {
+                m_lastError = "Cannot open " + path + " for writing";
+                return false;
+            }
+            std::vector<char> buffer;
+            if (!toStdout)
+            {
+                buffer.resize(kWriteBufferSize);
+                std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+            }
+
+            bool ok = true;
+            auto write = [&](std::string &chunk)
+            {
+                if (ok && m_options.gzip && !chunk.empty() && !compress(chunk))
+                {
+                    m_lastError = "gzip compression failed";
+                    ok = false;
+                }
+                if (ok && std::fwrite(chunk.data(), 1, chunk.size(), file) != chunk.size())
+                {
+                    m_lastError = "Write to " + path + " failed";
+                    ok = false;
+                }
+                m_bytesWritten += ok ? chunk.size() : 0;
+            };
+
+            std::string head = header();
+            write(head);
+
+            std::vector<UserField> fields = m_options.fields.toFields();
+            std::size_t rows = rowCount(users);
+            std::size_t chunkRows = m_options.rowsPerChunk;
+            std::size_t chunks = (rows + chunkRows - 1) / chunkRows;
+            std::size_t threads = std::min<std::size_t>(m_options.threads, std::max<std::size_t>(1, chunks));
+            std::size_t waveChunks = threads * 2;
+
+            std::vector<std::string> slots(waveChunks);
+            std::vector<char> failed(waveChunks);
+            for (std::size_t wave = 0; ok && wave < chunks; wave += waveChunks)
+            {
+                std::size_t count = std::min(waveChunks, chunks - wave);
+                auto formatSlots = [&](std::size_t first)
+                {
+                    for (std::size_t s = first; s < count; s += threads)
+                    {
+                        std::size_t begin = (wave + s) * chunkRows;
+                        slots[s].clear();
+                        formatRows(users, begin, std::min(rows, begin + chunkRows), m_options.format, fields, slots[s]);
+                        failed[s] = m_options.gzip && !compress(slots[s]);
+                    }
+                };
+
+                core::runTasks(std::min(threads, count), formatSlots);
+
+                for (std::size_t s = 0; ok && s < count; ++s)
+                {
+                    if (failed[s])
+                    {
+                        m_lastError = "gzip compression failed";
+                        ok = false;
+                        break;
+                    }
+                    if (std::fwrite(slots[s].data(), 1, slots[s].size(), file) != slots[s].size())
+                    {
+                        m_lastError = "Write to " + path + " failed";
+                        ok = false;
+                        break;
+                    }
+                    m_bytesWritten += slots[s].size();
+                }
+            }
+
+            if (std::fflush(file) != 0 && ok)
+            {
+                m_lastError = "Write to " + path + " failed";
+                ok = false;
+            }
+            if (!toStdout && std::fclose(file) != 0 && ok)
+            {
+                m_lastError = "Write to " + path + " failed";
+                ok = false;
+            }
+            return ok;
+        }
+
+    } // namespace client
+} // namespace logipad
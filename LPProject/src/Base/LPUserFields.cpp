@@ -0,0 +1,113 @@
+/**
+ * @file LPUserFields.cpp
+ * @brief Implementation of the user field helpers
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            const std::string_view kFieldNames[kUserFieldCount] = {
+                "guid",
+                "created_at",
+                "created_by",
+                "modified_at",
+                "modified_by",
+                "last_login_at",
+                "last_activity_at",
+                "last_document_service_activity",
+                "last_eform_service_activity",
+                "last_briefing_service_activity",
+                "name",
+                "type",
+                "full_name",
+                "email",
+                "three_lc",
+                "department",
+                "description",
+                "is_active",
+                "is_reportable",
+            };
+        } // namespace
+
+        // Get JSON name of a field
+        const char *userFieldName(UserField field)
+        {
+            return kFieldNames[static_cast<std::size_t>(field)].data();
+        }
+
+        // Look up field by JSON name
+        bool userFieldFromName(std::string_view name, UserField &field)
+        {
+            for (std::size_t i = 0; i < kUserFieldCount; ++i)
+            {
+                if (kFieldNames[i] == name)
+                {
+                    field = static_cast<UserField>(i);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Parse comma-separated field names
+        bool UserFieldMask::fromNames(std::string_view names, UserFieldMask &mask)
+        {
+            UserFieldMask result;
+            while (!names.empty())
+            {
+                std::size_t comma = names.find(',');
+                std::string_view name = names.substr(0, comma);
+                UserField field;
+                if (!userFieldFromName(name, field))
+                {
+                    return false;
+                }
+                result.add(field);
+                names = comma == std::string_view::npos ? std::string_view() : names.substr(comma + 1);
+            }
+            mask = result;
+            return true;
+        }
+
+        // Format as comma-separated field names
+        std::string UserFieldMask::toNames() const
+        {
+            std::string names;
+            for (std::size_t i = 0; i < kUserFieldCount; ++i)
+            {
+                if (contains(static_cast<UserField>(i)))
+                {
+                    if (!names.empty())
+                    {
+                        names += ',';
+                    }
+                    names += kFieldNames[i];
+                }
+            }
+            return names;
+        }
+
+        // List selected fields
+        std::vector<UserField> UserFieldMask::toFields() const
+        {
+            std::vector<UserField> fields;
+            for (std::size_t i = 0; i < kUserFieldCount; ++i)
+            {
+                if (contains(static_cast<UserField>(i)))
+                {
+                    fields.push_back(static_cast<UserField>(i));
+                }
+            }
+            return fields;
+        }
+
+    } // namespace client
+} // namespace logipad
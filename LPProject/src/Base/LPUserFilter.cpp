@@ -0,0 +1,742 @@
+/**
+ * @file LPUserFilter.cpp
+ * @brief Implementation of compiled user filters
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserFilter.hpp>
+#include <LPUserTable.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            using Compare = UserFilter::Compare;
+            using Term = UserFilter::Term;
+            using Instruction = UserFilter::Instruction;
+
+            /**
+             * @struct Token
+             * @brief Lexical token of a filter expression
+             */
+            struct Token
+            {
+                enum class Kind
+                {
+                    End,
+                    Identifier,
+                    String,
+                    Duration,
+                    And,
+                    Or,
+                    Not,
+                    Open,
+                    Close,
+                    Plus,
+                    Minus,
+                    Compare
+                };
+
+                Kind kind = Kind::End;
+                std::string text;       ///< Identifier name or decoded string literal
+                std::int64_t value = 0; ///< Duration in seconds
+                Compare op = Compare::Eq;
+                std::size_t offset = 0; ///< Position in the expression
+            };
+
+            /**
+             * @struct Operand
+             * @brief Side of a comparison
+             */
+            struct Operand
+            {
+                enum class Kind
+                {
+                    Field,
+                    String,
+                    Bool,
+                    Time
+                };
+
+                Kind kind = Kind::Field;
+                UserField field = UserField::Guid;
+                std::string text;
+                bool flag = false;
+                std::int64_t value = 0; ///< Offset from now in seconds
+            };
+
+            // Operator with swapped operands (a < b  <=>  b > a)
+            Compare mirror(Compare op)
+            {
+                switch (op)
+                {
+                case Compare::Lt: return Compare::Gt;
+                case Compare::Le: return Compare::Ge;
+                case Compare::Gt: return Compare::Lt;
+                case Compare::Ge: return Compare::Le;
+                default: return op;
+                }
+            }
+
+            /**
+             * @class Parser
+             * @brief Recursive-descent parser emitting the postfix program
+             */
+            class Parser
+            {
+            public:
+                Parser(std::string_view text, std::vector<Term> &terms, std::vector<Instruction> &program, UserFieldMask &fields)
+                    : m_text(text), m_terms(terms), m_program(program), m_fields(fields)
+                {
+                }
+
+                bool parse(std::string &error)
+                {
+                    if (next() && expression() && expect(Token::Kind::End, "end of expression"))
+                    {
+                        return true;
+                    }
+                    error = m_error;
+                    return false;
+                }
+
+            private:
+                std::string_view m_text;
+                std::size_t m_pos = 0;
+                Token m_token;
+                std::string m_error;
+                std::vector<Term> &m_terms;
+                std::vector<Instruction> &m_program;
+                UserFieldMask &m_fields;
+
+                bool fail(const std::string &message)
+                {
+                    if (m_error.empty())
+                    {
+                        m_error = message + " at offset " + std::to_string(m_token.offset);
+                    }
+                    return false;
+                }
+
+                bool expect(Token::Kind kind, const char *what)
+                {
+                    if (m_token.kind != kind)
+                    {
+                        return fail(std::string("Expected ") + what);
+                    }
+                    return kind == Token::Kind::End || next();
+                }
+
+                // Read the next token into m_token
+                bool next()
+                {
+                    while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r'))
+                    {
+                        ++m_pos;
+                    }
+                    m_token = Token();
+                    m_token.offset = m_pos;
+                    if (m_pos >= m_text.size())
+                    {
+                        return true;
+                    }
+
+                    char c = m_text[m_pos];
+                    char n = m_pos + 1 < m_text.size() ? m_text[m_pos + 1] : '\0';
+                    auto single = [&](Token::Kind kind, std::size_t length)
+                    {
+                        m_token.kind = kind;
+                        m_pos += length;
+                        return true;
+                    };
+                    auto compare = [&](Compare op, std::size_t length)
+                    {
+                        m_token.op = op;
+                        return single(Token::Kind::Compare, length);
+                    };
+
+                    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+                    {
+                        std::size_t start = m_pos;
+                        while (m_pos < m_text.size() && ((m_text[m_pos] >= 'a' && m_text[m_pos] <= 'z') || (m_text[m_pos] >= 'A' && m_text[m_pos] <= 'Z') ||
+                                                         (m_text[m_pos] >= '0' && m_text[m_pos] <= '9') || m_text[m_pos] == '_'))
+                        {
+                            ++m_pos;
+                        }
+                        m_token.kind = Token::Kind::Identifier;
+                        m_token.text = std::string(m_text.substr(start, m_pos - start));
+                        return true;
+                    }
+                    if (c >= '0' && c <= '9')
+                    {
+                        std::int64_t count = 0;
+                        while (m_pos < m_text.size() && m_text[m_pos] >= '0' && m_text[m_pos] <= '9')
+                        {
+                            if (count > 1000000000)
+                            {
+                                return fail("Duration too large");
+                            }
+                            count = count * 10 + (m_text[m_pos++] - '0');
+                        }
+                        char unit = m_pos < m_text.size() ? m_text[m_pos] : '\0';
+                        std::int64_t scale = unit == 's' ? 1 : unit == 'm' ? 60 : unit == 'h' ? 3600 : unit == 'd' ? 86400 : unit == 'w' ? 604800 : 0;
+                        if (scale == 0)
+                        {
+                            return fail("Expected duration unit s, m, h, d or w");
+                        }
+                        ++m_pos;
+                        m_token.kind = Token::Kind::Duration;
+                        m_token.value = count * scale;
+                        return true;
+                    }
+                    if (c == '"')
+                    {
+                        ++m_pos;
+                        while (m_pos < m_text.size() && m_text[m_pos] != '"')
+                        {
+                            if (m_text[m_pos] == '\\' && m_pos + 1 < m_text.size())
+                            {
+                                ++m_pos;
+                            }
+                            m_token.text.push_back(m_text[m_pos++]);
+                        }
+                        if (m_pos >= m_text.size())
+                        {
+                            return fail("Unterminated string");
+                        }
+                        ++m_pos;
+                        m_token.kind = Token::Kind::String;
+                        return true;
+                    }
+
+                    switch (c)
+                    {
+                    case '&':
+                        if (n == '&')
+                        {
+                            return single(Token::Kind::And, 2);
+                        }
+                        break;
+                    case '|':
+                        if (n == '|')
+                        {
+                            return single(Token::Kind::Or, 2);
+                        }
+                        break;
+                    case '!': return n == '=' ? compare(Compare::Ne, 2) : single(Token::Kind::Not, 1);
+                    case '=':
+                        if (n == '=')
+                        {
+                            return compare(Compare::Eq, 2);
+                        }
+                        break;
+                    case '<': return n == '=' ? compare(Compare::Le, 2) : compare(Compare::Lt, 1);
+                    case '>': return n == '=' ? compare(Compare::Ge, 2) : compare(Compare::Gt, 1);
+                    case '(': return single(Token::Kind::Open, 1);
+                    case ')': return single(Token::Kind::Close, 1);
+                    case '+': return single(Token::Kind::Plus, 1);
+                    case '-': return single(Token::Kind::Minus, 1);
+                    default: break;
+                    }
+                    return fail(std::string("Unexpected character '") + c + "'");
+                }
+
+                void emit(Instruction::Op op, std::size_t term = 0)
+                {
+                    Instruction instruction;
+                    instruction.op = op;
+                    instruction.term = term;
+                    m_program.push_back(instruction);
+                }
+
+                void emitTerm(Term term)
+                {
+                    m_fields.add(term.field);
+                    if (term.kind == Term::Kind::TimeField)
+                    {
+                        m_fields.add(term.other);
+                    }
+                    m_terms.push_back(std::move(term));
+                    emit(Instruction::Op::Term, m_terms.size() - 1);
+                }
+
+                bool expression()
+                {
+                    if (!conjunction())
+                    {
+                        return false;
+                    }
+                    while (m_token.kind == Token::Kind::Or)
+                    {
+                        if (!next() || !conjunction())
+                        {
+                            return false;
+                        }
+                        emit(Instruction::Op::Or);
+                    }
+                    return true;
+                }
+
+                bool conjunction()
+                {
+                    if (!unary())
+                    {
+                        return false;
+                    }
+                    while (m_token.kind == Token::Kind::And)
+                    {
+                        if (!next() || !unary())
+                        {
+                            return false;
+                        }
+                        emit(Instruction::Op::And);
+                    }
+                    return true;
+                }
+
+                bool unary()
+                {
+                    if (m_token.kind == Token::Kind::Not)
+                    {
+                        if (!next() || !unary())
+                        {
+                            return false;
+                        }
+                        emit(Instruction::Op::Not);
+                        return true;
+                    }
+                    if (m_token.kind == Token::Kind::Open)
+                    {
+                        return next() && expression() && expect(Token::Kind::Close, "')'");
+                    }
+
+                    Operand left;
+                    if (!operand(left))
+                    {
+                        return false;
+                    }
+                    if (m_token.kind != Token::Kind::Compare)
+                    {
+                        if (left.kind != Operand::Kind::Field)
+                        {
+                            return fail("Expected a condition");
+                        }
+                        Term term;
+                        term.kind = isBooleanField(left.field) ? Term::Kind::Flag : Term::Kind::Present;
+                        term.field = left.field;
+                        emitTerm(std::move(term));
+                        return true;
+                    }
+
+                    Compare op = m_token.op;
+                    Operand right;
+                    if (!next() || !operand(right))
+                    {
+                        return false;
+                    }
+                    if (left.kind != Operand::Kind::Field && right.kind == Operand::Kind::Field)
+                    {
+                        std::swap(left, right);
+                        op = mirror(op);
+                    }
+                    return comparison(left, op, right);
+                }
+
+                // Type-check a comparison and emit its term
+                bool comparison(const Operand &left, Compare op, const Operand &right)
+                {
+                    if (left.kind != Operand::Kind::Field)
+                    {
+                        return fail("Comparison needs a field");
+                    }
+
+                    Term term;
+                    term.field = left.field;
+                    term.op = op;
+                    std::string name = userFieldName(left.field);
+                    if (isBooleanField(left.field))
+                    {
+                        if (right.kind != Operand::Kind::Bool || (op != Compare::Eq && op != Compare::Ne))
+                        {
+                            return fail("Field " + name + " can only be compared with == or != against true or false");
+                        }
+                        term.kind = Term::Kind::Flag;
+                        term.flag = right.flag == (op == Compare::Eq);
+                    }
+                    else if (isTimestampField(left.field))
+                    {
+                        if (right.kind == Operand::Kind::Time)
+                        {
+                            term.kind = Term::Kind::Time;
+                            term.value = right.value;
+                            term.relative = true;
+                        }
+                        else if (right.kind == Operand::Kind::String)
+                        {
+                            term.kind = Term::Kind::Time;
+                            if (!parseTimestamp(right.text, term.value))
+                            {
+                                return fail("Invalid timestamp \"" + right.text + "\"");
+                            }
+                        }
+                        else if (right.kind == Operand::Kind::Field && isTimestampField(right.field))
+                        {
+                            term.kind = Term::Kind::TimeField;
+                            term.other = right.field;
+                        }
+                        else
+                        {
+                            return fail("Field " + name + " must be compared with a point in time");
+                        }
+                    }
+                    else
+                    {
+                        if (right.kind != Operand::Kind::String)
+                        {
+                            return fail("Field " + name + " must be compared with a string");
+                        }
+                        term.kind = Term::Kind::Text;
+                        term.text = right.text;
+                    }
+                    emitTerm(std::move(term));
+                    return true;
+                }
+
+                bool operand(Operand &result)
+                {
+                    if (m_token.kind == Token::Kind::String)
+                    {
+                        result.kind = Operand::Kind::String;
+                        result.text = std::move(m_token.text);
+                        return next();
+                    }
+                    if (m_token.kind != Token::Kind::Identifier)
+                    {
+                        return fail("Expected a field, string, true, false or now");
+                    }
+
+                    const std::string &name = m_token.text;
+                    if (name == "true" || name == "false")
+                    {
+                        result.kind = Operand::Kind::Bool;
+                        result.flag = name == "true";
+                        return next();
+                    }
+                    if (name == "now")
+                    {
+                        result.kind = Operand::Kind::Time;
+                        if (!next())
+                        {
+                            return false;
+                        }
+                        while (m_token.kind == Token::Kind::Plus || m_token.kind == Token::Kind::Minus)
+                        {
+                            bool minus = m_token.kind == Token::Kind::Minus;
+                            if (!next())
+                            {
+                                return false;
+                            }
+                            if (m_token.kind != Token::Kind::Duration)
+                            {
+                                return fail("Expected duration");
+                            }
+                            result.value += minus ? -m_token.value : m_token.value;
+                            if (!next())
+                            {
+                                return false;
+                            }
+                        }
+                        return true;
+                    }
+                    if (!userFieldFromName(name, result.field))
+                    {
+                        return fail("Unknown field " + name);
+                    }
+                    result.kind = Operand::Kind::Field;
+                    return next();
+                }
+            };
+
+            // Fill mask[i] = cmp(values[i], value) for present values
+            template <typename Cmp>
+            void compareTimes(std::uint8_t *mask, const std::int64_t *values, std::size_t count, std::int64_t value, Cmp cmp)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    mask[i] = values[i] != UserTable::kNoTime && cmp(values[i], value);
+                }
+            }
+
+            // Fill mask[i] = cmp(left[i], right[i]) where both are present
+            template <typename Cmp>
+            void compareTimeColumns(std::uint8_t *mask, const std::int64_t *left, const std::int64_t *right, std::size_t count, Cmp cmp)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    mask[i] = left[i] != UserTable::kNoTime && right[i] != UserTable::kNoTime && cmp(left[i], right[i]);
+                }
+            }
+
+            // Dispatch a comparison operator to a function object
+            template <typename Fn>
+            void withCompare(Compare op, Fn &&fn)
+            {
+                switch (op)
+                {
+                case Compare::Eq: fn(std::equal_to<>()); break;
+                case Compare::Ne: fn(std::not_equal_to<>()); break;
+                case Compare::Lt: fn(std::less<>()); break;
+                case Compare::Le: fn(std::less_equal<>()); break;
+                case Compare::Gt: fn(std::greater<>()); break;
+                case Compare::Ge: fn(std::greater_equal<>()); break;
+                }
+            }
+
+            /**
+             * @struct BoundTerm
+             * @brief Term resolved against the columns of one table
+             * @details Text and presence predicates are evaluated once per dictionary
+             *          entry, so the row loop is a single table lookup per row.
+             */
+            struct BoundTerm
+            {
+                const Term *term = nullptr;
+                const std::uint8_t *flags = nullptr;
+                const std::uint32_t *codes = nullptr;
+                std::vector<std::uint8_t> accept; ///< Result per dictionary code
+                const std::int64_t *times = nullptr;
+                const std::int64_t *other = nullptr;
+                std::int64_t value = 0;
+            };
+        } // namespace
+
+        /**
+         * @brief Compile a filter expression
+         * @details The program is in postfix order; its maximum mask stack depth is
+         *          computed here so evaluation never allocates per batch.
+         */
+        bool UserFilter::compile(std::string_view expression)
+        {
+            std::vector<Term> terms;
+            std::vector<Instruction> program;
+            UserFieldMask fields;
+            Parser parser(expression, terms, program, fields);
+            if (!parser.parse(m_lastError))
+            {
+                return false;
+            }
+
+            std::size_t depth = 0;
+            std::size_t maxDepth = 0;
+            for (const Instruction &instruction : program)
+            {
+                if (instruction.op == Instruction::Op::Term)
+                {
+                    maxDepth = std::max(maxDepth, ++depth);
+                }
+                else if (instruction.op != Instruction::Op::Not)
+                {
+                    --depth;
+                }
+            }
+
+            m_terms = std::move(terms);
+            m_program = std::move(program);
+            m_depth = maxDepth;
+            m_fields = fields;
+            m_lastError.clear();
+            return true;
+        }
+
+        // Evaluate relative to the current time
+        bool UserFilter::evaluate(const UserTable &table, std::vector<std::uint32_t> &rows) const
+        {
+            auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            return evaluate(table, rows, static_cast<std::int64_t>(now));
+        }
+
+        /**
+         * @brief Evaluate the program over a table
+         * @details Every instruction processes a whole batch of rows: terms write one
+         *          byte per row into a mask on the stack, operators combine the top
+         *          masks. The loops have no data-dependent branches and vectorize.
+         */
+        bool UserFilter::evaluate(const UserTable &table, std::vector<std::uint32_t> &rows, std::int64_t now) const
+        {
+            rows.clear();
+            if (m_program.empty())
+            {
+                m_lastError = "No filter compiled";
+                return false;
+            }
+
+            // Bind the terms to the table
+            std::vector<BoundTerm> bound(m_terms.size());
+            for (std::size_t t = 0; t < m_terms.size(); ++t)
+            {
+                const Term &term = m_terms[t];
+                BoundTerm &b = bound[t];
+                b.term = &term;
+                std::string missing;
+                switch (term.kind)
+                {
+                case Term::Kind::Flag:
+                    if (const auto *column = table.flags(term.field))
+                    {
+                        b.flags = column->data();
+                    }
+                    else
+                    {
+                        missing = userFieldName(term.field);
+                    }
+                    break;
+                case Term::Kind::Present:
+                case Term::Kind::Text:
+                    if (const auto *column = table.text(term.field))
+                    {
+                        b.codes = column->codes.data();
+                        b.accept.resize(column->dictionary.size());
+                        for (std::size_t code = 1; code < b.accept.size(); ++code)
+                        {
+                            b.accept[code] = term.kind == Term::Kind::Present;
+                        }
+                        if (term.kind == Term::Kind::Text)
+                        {
+                            withCompare(term.op, [&](auto cmp)
+                                        {
+                                            std::string_view value(term.text);
+                                            for (std::size_t code = 1; code < b.accept.size(); ++code)
+                                            {
+                                                b.accept[code] = cmp(std::string_view(column->dictionary[code]), value);
+                                            } });
+                        }
+                    }
+                    else
+                    {
+                        missing = userFieldName(term.field);
+                    }
+                    break;
+                case Term::Kind::Time:
+                case Term::Kind::TimeField:
+                    if (const auto *column = table.times(term.field))
+                    {
+                        b.times = column->data();
+                        b.value = term.relative ? now + term.value : term.value;
+                    }
+                    else
+                    {
+                        missing = userFieldName(term.field);
+                    }
+                    if (term.kind == Term::Kind::TimeField)
+                    {
+                        if (const auto *column = table.times(term.other))
+                        {
+                            b.other = column->data();
+                        }
+                        else
+                        {
+                            missing = userFieldName(term.other);
+                        }
+                    }
+                    break;
+                }
+                if (!missing.empty())
+                {
+                    m_lastError = "Column " + missing + " not loaded";
+                    return false;
+                }
+            }
+
+            std::vector<std::uint8_t> stack(m_depth * kBatchRows);
+            for (std::size_t begin = 0; begin < table.size(); begin += kBatchRows)
+            {
+                std::size_t count = std::min(kBatchRows, table.size() - begin);
+                std::size_t top = 0;
+                for (const Instruction &instruction : m_program)
+                {
+                    if (instruction.op == Instruction::Op::Term)
+                    {
+                        std::uint8_t *mask = stack.data() + top++ * kBatchRows;
+                        const BoundTerm &b = bound[instruction.term];
+                        switch (b.term->kind)
+                        {
+                        case Term::Kind::Flag:
+                        {
+                            std::uint8_t expected = b.term->flag;
+                            const std::uint8_t *flags = b.flags + begin;
+                            for (std::size_t i = 0; i < count; ++i)
+                            {
+                                mask[i] = flags[i] == expected;
+                            }
+                            break;
+                        }
+                        case Term::Kind::Present:
+                        case Term::Kind::Text:
+                        {
+                            const std::uint8_t *accept = b.accept.data();
+                            const std::uint32_t *codes = b.codes + begin;
+                            for (std::size_t i = 0; i < count; ++i)
+                            {
+                                mask[i] = accept[codes[i]];
+                            }
+                            break;
+                        }
+                        case Term::Kind::Time:
+                            withCompare(b.term->op, [&](auto cmp)
+                                        { compareTimes(mask, b.times + begin, count, b.value, cmp); });
+                            break;
+                        case Term::Kind::TimeField:
+                            withCompare(b.term->op, [&](auto cmp)
+                                        { compareTimeColumns(mask, b.times + begin, b.other + begin, count, cmp); });
+                            break;
+                        }
+                        continue;
+                    }
+
+                    std::uint8_t *right = stack.data() + (top - 1) * kBatchRows;
+                    if (instruction.op == Instruction::Op::Not)
+                    {
+                        for (std::size_t i = 0; i < count; ++i)
+                        {
+                            right[i] ^= 1;
+                        }
+                        continue;
+                    }
+                    std::uint8_t *left = right - kBatchRows;
+                    if (instruction.op == Instruction::Op::And)
+                    {
+                        for (std::size_t i = 0; i < count; ++i)
+                        {
+                            left[i] &= right[i];
+                        }
+                    }
+                    else
+                    {
+                        for (std::size_t i = 0; i < count; ++i)
+                        {
+                            left[i] |= right[i];
+                        }
+                    }
+                    --top;
+                }
+
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    if (stack[i])
+                    {
+                        rows.push_back(static_cast<std::uint32_t>(begin + i));
+                    }
+                }
+            }
+            return true;
+        }
+
+    } // namespace client
+} // namespace logipad
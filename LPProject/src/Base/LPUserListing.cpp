@@ -0,0 +1,234 @@
+/**
+ * @file LPUserListing.cpp
+ * @brief Implementation of the console user listing
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserListing.hpp>
+#include <LPLazyUsers.hpp>
+#include <LPUserTable.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Output is handed to the stream whenever the buffer exceeds this size
+            const std::size_t kFlushThreshold = 1024 * 1024;
+
+            // Separator between fixed-width columns
+            const std::string_view kColumnGap = "  ";
+
+            // Display width of a UTF-8 string (code points, not bytes)
+            std::size_t displayWidth(std::string_view value)
+            {
+                std::size_t width = 0;
+                for (char c : value)
+                {
+                    width += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+                }
+                return width;
+            }
+
+            // Append a value for the TSV layout
+            void appendTsv(std::string &out, std::string_view value)
+            {
+                for (char c : value)
+                {
+                    switch (c)
+                    {
+                    case '\t': out += "\\t"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\\': out += "\\\\"; break;
+                    default: out.push_back(c);
+                    }
+                }
+            }
+
+            // Selected rows of a table, indexed like a user list
+            struct Selection
+            {
+                const UserTable &table;
+                const std::vector<std::uint32_t> &rows;
+
+                UserTable::Row operator[](std::size_t i) const { return table[rows[i]]; }
+            };
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        UserListing::UserListing(const Options &options) : m_options(options)
+        {
+        }
+
+        // Parse a column list
+        bool UserListing::columnsFromNames(std::string_view names, std::vector<UserField> &columns)
+        {
+            std::vector<UserField> result;
+            while (!names.empty())
+            {
+                std::size_t comma = names.find(',');
+                UserField field;
+                if (!userFieldFromName(names.substr(0, comma), field))
+                {
+                    return false;
+                }
+                result.push_back(field);
+                names = comma == std::string_view::npos ? std::string_view() : names.substr(comma + 1);
+            }
+            columns = std::move(result);
+            return true;
+        }
+
+        // Fields read by the listing
+        UserFieldMask UserListing::fields() const
+        {
+            UserFieldMask mask;
+            for (UserField field : m_options.columns)
+            {
+                mask.add(field);
+            }
+            if (m_options.sortBy.has_value())
+            {
+                mask.add(*m_options.sortBy);
+            }
+            return mask;
+        }
+
+        // List eagerly decoded users
+        bool UserListing::write(const std::vector<LogipadClient::User> &users, std::FILE *out) const
+        {
+            return render(users, users.size(), out);
+        }
+
+        // List lazily decoded users
+        bool UserListing::write(const LazyUsers &users, std::FILE *out) const
+        {
+            return render(users, users.size(), out);
+        }
+
+        // List selected table rows
+        bool UserListing::write(const UserTable &users, const std::vector<std::uint32_t> &rows, std::FILE *out) const
+        {
+            return render(Selection{users, rows}, rows.size(), out);
+        }
+
+        /**
+         * @brief Render the table
+         * @details Cells are fetched once into a row-major table of views (the sources
+         *          keep the strings alive), which is then sorted by index and formatted.
+         *          Missing values sort last in either direction.
+         */
+        template <typename Source>
+        bool UserListing::render(const Source &users, std::size_t count, std::FILE *out) const
+        {
+            const auto &columns = m_options.columns;
+            std::size_t width = columns.size() + 1;
+            std::vector<std::optional<std::string_view>> cells(count * width);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto &&user = users[i];
+                for (std::size_t c = 0; c < columns.size(); ++c)
+                {
+                    cells[i * width + c] = user.get(columns[c]);
+                }
+                if (m_options.sortBy.has_value())
+                {
+                    cells[i * width + columns.size()] = user.get(*m_options.sortBy);
+                }
+            }
+
+            std::vector<std::size_t> order(count);
+            std::iota(order.begin(), order.end(), 0);
+            if (m_options.sortBy.has_value())
+            {
+                std::size_t key = columns.size();
+                bool descending = m_options.descending;
+                std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+                                 {
+                                     const auto &left = cells[a * width + key];
+                                     const auto &right = cells[b * width + key];
+                                     if (!left.has_value() || !right.has_value())
+                                     {
+                                         return left.has_value() && !right.has_value();
+                                     }
+                                     return descending ? *right < *left : *left < *right; });
+            }
+
+            std::vector<std::size_t> widths(columns.size(), 0);
+            if (m_options.layout == Layout::Fixed)
+            {
+                for (std::size_t c = 0; c < columns.size(); ++c)
+                {
+                    widths[c] = m_options.header ? displayWidth(userFieldName(columns[c])) : 0;
+                    for (std::size_t i = 0; i < count; ++i)
+                    {
+                        const auto &cell = cells[i * width + c];
+                        widths[c] = std::max(widths[c], cell.has_value() ? displayWidth(*cell) : 0);
+                    }
+                }
+            }
+
+            std::string buffer;
+            buffer.reserve(kFlushThreshold + 4096);
+            bool ok = true;
+            auto flush = [&]()
+            {
+                ok = ok && std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+                buffer.clear();
+            };
+
+            auto appendRow = [&](auto &&cellAt)
+            {
+                for (std::size_t c = 0; c < columns.size(); ++c)
+                {
+                    std::string_view value = cellAt(c);
+                    bool last = c + 1 == columns.size();
+                    if (m_options.layout == Layout::Tsv)
+                    {
+                        appendTsv(buffer, value);
+                        buffer.push_back(last ? '\n' : '\t');
+                    }
+                    else
+                    {
+                        buffer.append(value.data(), value.size());
+                        if (!last)
+                        {
+                            buffer.append(widths[c] - std::min(widths[c], displayWidth(value)), ' ');
+                            buffer.append(kColumnGap.data(), kColumnGap.size());
+                        }
+                        else
+                        {
+                            buffer.push_back('\n');
+                        }
+                    }
+                }
+            };
+
+            if (m_options.header)
+            {
+                appendRow([&](std::size_t c)
+                          { return std::string_view(userFieldName(columns[c])); });
+            }
+            for (std::size_t i : order)
+            {
+                appendRow([&](std::size_t c)
+                          { return cells[i * width + c].value_or(std::string_view()); });
+                if (buffer.size() >= kFlushThreshold)
+                {
+                    flush();
+                }
+            }
+            flush();
+            return ok && std::fflush(out) == 0;
+        }
+
+    } // namespace client
+} // namespace logipad
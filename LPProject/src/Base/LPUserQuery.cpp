@@ -0,0 +1,123 @@
+/**
+ * @file LPUserQuery.cpp
+ * @brief Implementation of the user query builder
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserQuery.hpp>
+#include <httplib.h>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        // Filter on is_active
+        UserQuery &UserQuery::active(bool active)
+        {
+            m_active = active;
+            return *this;
+        }
+
+        // Filter on modified_at
+        UserQuery &UserQuery::modifiedSince(const std::string &timestamp)
+        {
+            m_modifiedSince = timestamp;
+            return *this;
+        }
+
+        // Filter on department
+        UserQuery &UserQuery::department(const std::string &department)
+        {
+            m_department = department;
+            return *this;
+        }
+
+        // Filter on type
+        UserQuery &UserQuery::type(const std::string &type)
+        {
+            m_type = type;
+            return *this;
+        }
+
+        // Set projection
+        UserQuery &UserQuery::fields(const UserFieldMask &fields)
+        {
+            m_fields = fields;
+            return *this;
+        }
+
+        // Set page size
+        UserQuery &UserQuery::pageSize(std::size_t limit)
+        {
+            m_limit = limit;
+            return *this;
+        }
+
+        // Set offset
+        UserQuery &UserQuery::offset(std::size_t offset)
+        {
+            m_offset = offset;
+            m_cursor.reset();
+            return *this;
+        }
+
+        // Set cursor
+        UserQuery &UserQuery::cursor(const std::string &cursor)
+        {
+            m_cursor = cursor;
+            m_offset = 0;
+            return *this;
+        }
+
+        /**
+         * @brief Render the request path
+         * @details Parameters are percent-encoded by httplib. A cursor takes precedence
+         *          over the offset.
+         */
+        std::string UserQuery::toPath(bool withFields) const
+        {
+            httplib::Params params;
+            if (m_active.has_value())
+            {
+                params.emplace("is_active", *m_active ? "true" : "false");
+            }
+            if (m_modifiedSince.has_value())
+            {
+                params.emplace("modified_since", *m_modifiedSince);
+            }
+            if (m_department.has_value())
+            {
+                params.emplace("department", *m_department);
+            }
+            if (m_type.has_value())
+            {
+                params.emplace("type", *m_type);
+            }
+            if (withFields && !m_fields.isAll())
+            {
+                params.emplace("fields", m_fields.toNames());
+            }
+            if (m_limit > 0)
+            {
+                params.emplace("limit", std::to_string(m_limit));
+            }
+            if (m_cursor.has_value())
+            {
+                params.emplace("cursor", *m_cursor);
+            }
+            else if (m_offset > 0)
+            {
+                params.emplace("offset", std::to_string(m_offset));
+            }
+
+            if (params.empty())
+            {
+                return "/users";
+            }
+            return httplib::append_query_params("/users", params);
+        }
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,474 @@
+/**
+ * @file LPUserSearch.cpp
+ * @brief Implementation of the trigram user search index
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserSearch.hpp>
+#include <LPLazyUsers.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Indexed fields, in storage order
+            const UserField kSearchFields[] = {UserField::Name, UserField::FullName, UserField::Email};
+            const std::size_t kSearchFieldCount = 3;
+
+            // An array container turns into a bitset beyond this many offsets (both take 8 KiB)
+            const std::size_t kMaxOffsets = 4096;
+
+            // Words of a bitset container
+            const std::size_t kBitsetWords = 65536 / 64;
+
+            // Query trigrams are counted in bytes, so longer queries are cut
+            const std::size_t kMaxQueryTrigrams = 255;
+
+            // Base letters of U+00C0..U+017F; '_' marks two-letter replacements, ' ' separators
+            const char kLatinBase[] =
+                "aaaaaa_ceeeeiiii"
+                "dnooooo ouuuuy__"
+                "aaaaaa_ceeeeiiii"
+                "dnooooo ouuuuy_y"
+                "aaaaaaccccccccdddd"
+                "eeeeeeeeeegggggggghhhh"
+                "iiiiiiiiii__jjkkk"
+                "llllllllllnnnnnnnnn"
+                "oooooo__rrrrrrsssssssstttttt"
+                "uuuuuuuuuuuuwwyyyzzzzzzs";
+            static_assert(sizeof(kLatinBase) == 0x17F - 0xC0 + 2, "one entry per code point");
+
+            // Two-letter replacements of kLatinBase
+            const char *ligature(std::uint32_t code)
+            {
+                switch (code)
+                {
+                case 0xC6:
+                case 0xE6:
+                    return "ae";
+                case 0xDE:
+                case 0xFE:
+                    return "th";
+                case 0xDF:
+                    return "ss";
+                case 0x132:
+                case 0x133:
+                    return "ij";
+                default:
+                    return "oe"; // U+0152, U+0153
+                }
+            }
+
+            // Pack three bytes into a trigram key
+            std::uint32_t trigram(const char *text)
+            {
+                return static_cast<std::uint32_t>(static_cast<unsigned char>(text[0])) << 16 |
+                       static_cast<std::uint32_t>(static_cast<unsigned char>(text[1])) << 8 |
+                       static_cast<std::uint32_t>(static_cast<unsigned char>(text[2]));
+            }
+
+            // Check whether a container holds a user offset
+            bool contains(const std::vector<std::uint16_t> &offsets, const std::vector<std::uint64_t> &bits, std::uint16_t offset)
+            {
+                if (!bits.empty())
+                {
+                    return (bits[offset >> 6] >> (offset & 63)) & 1;
+                }
+                return !offsets.empty() && offsets.back() == offset;
+            }
+        } // namespace
+
+        /**
+         * @brief Constructor implementation
+         */
+        UserSearchIndex::UserSearchIndex(const Options &options) : m_options(options)
+        {
+        }
+
+        /**
+         * @brief Default constructor implementation
+         */
+        UserSearchIndex::UserSearchIndex() : m_options()
+        {
+        }
+
+        // Fields read by the index
+        UserFieldMask UserSearchIndex::fields()
+        {
+            return UserFieldMask{UserField::Name, UserField::FullName, UserField::Email};
+        }
+
+        /**
+         * @brief Fold a text
+         * @details UTF-8 is decoded only for two-byte sequences, which cover every
+         *          folded letter and the combining marks U+0300..U+036F; invalid and
+         *          longer sequences are copied byte by byte.
+         */
+        void UserSearchIndex::fold(std::string_view text, std::string &out)
+        {
+            out.clear();
+            auto separate = [&out]()
+            {
+                if (!out.empty() && out.back() != ' ')
+                {
+                    out += ' ';
+                }
+            };
+            for (std::size_t i = 0; i < text.size(); ++i)
+            {
+                auto byte = static_cast<unsigned char>(text[i]);
+                if (byte < 0x80)
+                {
+                    if ((byte >= 'a' && byte <= 'z') || (byte >= '0' && byte <= '9'))
+                    {
+                        out += static_cast<char>(byte);
+                    }
+                    else if (byte >= 'A' && byte <= 'Z')
+                    {
+                        out += static_cast<char>(byte | 0x20);
+                    }
+                    else
+                    {
+                        separate();
+                    }
+                    continue;
+                }
+
+                auto next = i + 1 < text.size() ? static_cast<unsigned char>(text[i + 1]) : 0;
+                if (byte >= 0xC2 && byte <= 0xDF && (next & 0xC0) == 0x80)
+                {
+                    std::uint32_t code = (static_cast<std::uint32_t>(byte & 0x1F) << 6) | (next & 0x3F);
+                    if (code >= 0xC0 && code <= 0x17F)
+                    {
+                        char base = kLatinBase[code - 0xC0];
+                        if (base == '_')
+                        {
+                            out += ligature(code);
+                        }
+                        else if (base == ' ')
+                        {
+                            separate();
+                        }
+                        else
+                        {
+                            out += base;
+                        }
+                        ++i;
+                        continue;
+                    }
+                    if (code >= 0x300 && code <= 0x36F)
+                    {
+                        ++i;
+                        continue;
+                    }
+                }
+                out += static_cast<char>(byte);
+            }
+            if (!out.empty() && out.back() == ' ')
+            {
+                out.pop_back();
+            }
+        }
+
+        // Index decoded users
+        void UserSearchIndex::add(const std::string &tenant, const std::vector<LogipadClient::User> &users)
+        {
+            load(tenant, users, users.size());
+        }
+
+        // Index lazily decoded users
+        void UserSearchIndex::add(const std::string &tenant, const LazyUsers &users)
+        {
+            load(tenant, users, users.size());
+        }
+
+        /**
+         * @brief Index a directory
+         * @details Users are numbered in the order they are added, so every posting list
+         *          grows only at its end: a user is appended to the last container, or a
+         *          new container is started for the next block.
+         */
+        template <typename Source>
+        void UserSearchIndex::load(const std::string &tenant, const Source &users, std::size_t count)
+        {
+            auto owner = static_cast<std::uint32_t>(m_tenants.size());
+            m_tenants.push_back(tenant);
+            m_docs.reserve(m_docs.size() + count);
+            m_ends.reserve(m_ends.size() + kSearchFieldCount * count);
+
+            std::string folded;
+            for (std::size_t row = 0; row < count; ++row)
+            {
+                auto doc = static_cast<std::uint32_t>(m_docs.size());
+                auto block = static_cast<std::uint16_t>(doc >> 16);
+                auto offset = static_cast<std::uint16_t>(doc & 0xFFFF);
+                m_docs.push_back(Doc{owner, static_cast<std::uint32_t>(row), static_cast<std::uint32_t>(m_text.size())});
+
+                auto &&user = users[row];
+                for (UserField field : kSearchFields)
+                {
+                    fold(user.get(field).value_or(std::string_view()), folded);
+                    if (folded.empty())
+                    {
+                        m_ends.push_back(static_cast<std::uint32_t>(m_text.size()));
+                        continue;
+                    }
+
+                    // Padding turns word starts and ends into trigrams of their own
+                    std::size_t begin = m_text.size();
+                    m_text += ' ';
+                    m_text += folded;
+                    m_text += ' ';
+                    m_ends.push_back(static_cast<std::uint32_t>(m_text.size()));
+                    for (std::size_t i = begin; i + 3 <= m_text.size(); ++i)
+                    {
+                        auto &containers = m_postings[trigram(m_text.data() + i)];
+                        if (containers.empty() || containers.back().block != block)
+                        {
+                            containers.push_back(Container{block, {}, {}});
+                        }
+                        Container &container = containers.back();
+                        if (contains(container.offsets, container.bits, offset))
+                        {
+                            continue;
+                        }
+                        if (!container.bits.empty())
+                        {
+                            container.bits[offset >> 6] |= std::uint64_t(1) << (offset & 63);
+                            continue;
+                        }
+                        container.offsets.push_back(offset);
+                        if (container.offsets.size() > kMaxOffsets)
+                        {
+                            container.bits.assign(kBitsetWords, 0);
+                            for (std::uint16_t value : container.offsets)
+                            {
+                                container.bits[value >> 6] |= std::uint64_t(1) << (value & 63);
+                            }
+                            container.offsets = std::vector<std::uint16_t>();
+                        }
+                    }
+                }
+            }
+        }
+
+        // Get a folded, padded field of a user
+        std::string_view UserSearchIndex::field(std::size_t doc, std::size_t index) const
+        {
+            std::size_t end = m_ends[doc * kSearchFieldCount + index];
+            std::size_t begin = index == 0 ? m_docs[doc].text : m_ends[doc * kSearchFieldCount + index - 1];
+            return std::string_view(m_text).substr(begin, end - begin);
+        }
+
+        /**
+         * @brief Search the index
+         * @details The postings of the query trigrams are walked block by block. Per
+         *          block, occurrences are counted into a byte array; users reaching the
+         *          required number of trigrams are candidates. Candidates are then scored
+         *          per field against the stored folded text, so trigrams spread over
+         *          several fields do not make a hit. A one-character query takes the
+         *          union of the postings of all trigrams starting a word with it.
+         */
+        bool UserSearchIndex::search(std::string_view query, std::vector<Hit> &hits, std::size_t limit) const
+        {
+            hits.clear();
+            m_lastError.clear();
+
+            // Short queries match word starts through the leading padding
+            std::string pattern;
+            fold(query, pattern);
+            if (pattern.size() < 3)
+            {
+                pattern.insert(0, 1, ' ');
+            }
+            if (pattern.size() < 2)
+            {
+                m_lastError = "Search query needs at least one letter or digit";
+                return false;
+            }
+            pattern.resize(std::min(pattern.size(), kMaxQueryTrigrams + 2));
+
+            std::vector<std::uint32_t> keys;
+            for (std::size_t i = 0; i + 3 <= pattern.size(); ++i)
+            {
+                keys.push_back(trigram(pattern.data() + i));
+            }
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+            std::size_t required = 1;
+            if (pattern.size() == 2)
+            {
+                // A single character has no trigram of its own: any trigram of a word
+                // starting with it will do, one per following byte, so fewer than 255
+                std::uint32_t prefix = trigram((pattern + ' ').data()) >> 8;
+                for (const auto &posting : m_postings)
+                {
+                    if (posting.first >> 8 == prefix)
+                    {
+                        keys.push_back(posting.first);
+                    }
+                }
+                if (keys.empty())
+                {
+                    return true;
+                }
+            }
+            else
+            {
+                required = static_cast<std::size_t>(std::ceil(m_options.minSimilarity * static_cast<double>(keys.size())));
+                required = std::clamp<std::size_t>(required, 1, keys.size());
+            }
+
+            std::vector<const std::vector<Container> *> postings;
+            for (std::uint32_t key : keys)
+            {
+                auto it = m_postings.find(key);
+                if (it != m_postings.end())
+                {
+                    postings.push_back(&it->second);
+                }
+            }
+            if (postings.size() < required)
+            {
+                return true;
+            }
+
+            // Walk the blocks in order, counting trigram occurrences per user
+            std::vector<std::uint32_t> candidates;
+            std::vector<std::size_t> positions(postings.size(), 0);
+            std::vector<std::uint8_t> counts(65536);
+            std::vector<const Container *> present;
+            for (;;)
+            {
+                std::uint32_t block = UINT32_MAX;
+                for (std::size_t p = 0; p < postings.size(); ++p)
+                {
+                    if (positions[p] < postings[p]->size())
+                    {
+                        block = std::min<std::uint32_t>(block, (*postings[p])[positions[p]].block);
+                    }
+                }
+                if (block == UINT32_MAX)
+                {
+                    break;
+                }
+                present.clear();
+                for (std::size_t p = 0; p < postings.size(); ++p)
+                {
+                    if (positions[p] < postings[p]->size() && (*postings[p])[positions[p]].block == block)
+                    {
+                        present.push_back(&(*postings[p])[positions[p]++]);
+                    }
+                }
+                if (present.size() < required)
+                {
+                    continue;
+                }
+
+                std::fill(counts.begin(), counts.end(), 0);
+                for (const Container *container : present)
+                {
+                    for (std::uint16_t offset : container->offsets)
+                    {
+                        ++counts[offset];
+                    }
+                    for (std::size_t word = 0; word < container->bits.size(); ++word)
+                    {
+                        for (std::uint64_t bits = container->bits[word]; bits != 0; bits &= bits - 1)
+                        {
+                            ++counts[word * 64 + static_cast<std::size_t>(std::countr_zero(bits))];
+                        }
+                    }
+                }
+                for (std::size_t offset = 0; offset < counts.size(); ++offset)
+                {
+                    if (counts[offset] >= required)
+                    {
+                        candidates.push_back(block << 16 | static_cast<std::uint32_t>(offset));
+                    }
+                }
+            }
+
+            // Score every candidate by its best field
+            struct Scored
+            {
+                std::uint32_t doc;
+                std::uint8_t field;
+                bool exact;
+                std::size_t matched;
+                std::size_t length;
+            };
+            std::vector<Scored> scored;
+            for (std::uint32_t doc : candidates)
+            {
+                Scored best{doc, 0, false, 0, 0};
+                for (std::size_t f = 0; f < kSearchFieldCount; ++f)
+                {
+                    std::string_view text = field(doc, f);
+                    Scored current{doc, static_cast<std::uint8_t>(f), text.find(pattern) != std::string_view::npos, 0, text.size()};
+                    if (current.exact)
+                    {
+                        current.matched = keys.size();
+                    }
+                    else
+                    {
+                        for (std::uint32_t key : keys)
+                        {
+                            const char gram[3] = {static_cast<char>(key >> 16), static_cast<char>(key >> 8), static_cast<char>(key)};
+                            current.matched += text.find(std::string_view(gram, 3)) != std::string_view::npos;
+                        }
+                    }
+                    if (current.matched > best.matched || (current.matched == best.matched && current.exact && !best.exact))
+                    {
+                        best = current;
+                    }
+                }
+                if (best.matched >= required)
+                {
+                    scored.push_back(best);
+                }
+            }
+
+            auto better = [](const Scored &a, const Scored &b)
+            {
+                if (a.exact != b.exact)
+                {
+                    return a.exact;
+                }
+                if (a.matched != b.matched)
+                {
+                    return a.matched > b.matched;
+                }
+                if (a.length != b.length)
+                {
+                    return a.length < b.length;
+                }
+                return a.doc < b.doc;
+            };
+            std::size_t count = std::min(limit, scored.size());
+            std::partial_sort(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(count), scored.end(), better);
+
+            hits.reserve(count);
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const Doc &doc = m_docs[scored[i].doc];
+                Hit hit;
+                hit.tenant = m_tenants[doc.tenant];
+                hit.row = doc.row;
+                hit.field = kSearchFields[scored[i].field];
+                hit.similarity = static_cast<double>(scored[i].matched) / static_cast<double>(keys.size());
+                hit.exact = scored[i].exact;
+                hits.push_back(std::move(hit));
+            }
+            return true;
+        }
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,268 @@
+/**
+ * @file LPUserTable.cpp
+ * @brief Implementation of the columnar user table
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPUserTable.hpp>
+#include <LPLazyUsers.hpp>
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        namespace
+        {
+            // Parse a fixed number of digits
+            bool digits(std::string_view text, std::size_t pos, std::size_t count, int &value)
+            {
+                if (pos + count > text.size())
+                {
+                    return false;
+                }
+                value = 0;
+                for (std::size_t i = pos; i < pos + count; ++i)
+                {
+                    if (text[i] < '0' || text[i] > '9')
+                    {
+                        return false;
+                    }
+                    value = value * 10 + (text[i] - '0');
+                }
+                return true;
+            }
+
+            // Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's algorithm)
+            std::int64_t daysFromCivil(int year, int month, int day)
+            {
+                year -= month <= 2;
+                const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+                const unsigned yoe = static_cast<unsigned>(year - era * 400);
+                const unsigned doy = (153 * static_cast<unsigned>(month + (month > 2 ? -3 : 9)) + 2) / 5 + static_cast<unsigned>(day) - 1;
+                const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+                return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+            }
+        } // namespace
+
+        // Check for timestamp fields
+        bool isTimestampField(UserField field)
+        {
+            switch (field)
+            {
+            case UserField::CreatedAt:
+            case UserField::ModifiedAt:
+            case UserField::LastLoginAt:
+            case UserField::LastActivityAt:
+            case UserField::LastDocumentServiceActivity:
+            case UserField::LastEformServiceActivity:
+            case UserField::LastBriefingServiceActivity:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * @brief Parse an ISO 8601 timestamp
+         * @details Accepts "YYYY-MM-DD", optionally followed by "THH:MM[:SS[.fraction]]"
+         *          (a space may replace the T) and "Z" or a "+HH:MM"/"-HH:MM" offset.
+         *          Times without zone are taken as UTC.
+         */
+        bool parseTimestamp(std::string_view text, std::int64_t &seconds)
+        {
+            int year, month, day;
+            if (!digits(text, 0, 4, year) || text.size() < 10 || text[4] != '-' || !digits(text, 5, 2, month) ||
+                text[7] != '-' || !digits(text, 8, 2, day) || month < 1 || month > 12 || day < 1 || day > 31)
+            {
+                return false;
+            }
+
+            int hour = 0, minute = 0, second = 0;
+            std::size_t pos = 10;
+            if (pos < text.size() && (text[pos] == 'T' || text[pos] == ' '))
+            {
+                if (!digits(text, pos + 1, 2, hour) || pos + 3 >= text.size() || text[pos + 3] != ':' ||
+                    !digits(text, pos + 4, 2, minute) || hour > 23 || minute > 59)
+                {
+                    return false;
+                }
+                pos += 6;
+                if (pos < text.size() && text[pos] == ':')
+                {
+                    if (!digits(text, pos + 1, 2, second) || second > 60)
+                    {
+                        return false;
+                    }
+                    pos += 3;
+                }
+                if (pos < text.size() && text[pos] == '.')
+                {
+                    do
+                    {
+                        ++pos;
+                    } while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9');
+                }
+            }
+
+            int offset = 0;
+            if (pos < text.size() && text[pos] == 'Z')
+            {
+                ++pos;
+            }
+            else if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+            {
+                int offsetHours, offsetMinutes;
+                if (!digits(text, pos + 1, 2, offsetHours) || pos + 3 >= text.size() || text[pos + 3] != ':' ||
+                    !digits(text, pos + 4, 2, offsetMinutes))
+                {
+                    return false;
+                }
+                offset = (offsetHours * 60 + offsetMinutes) * 60 * (text[pos] == '-' ? -1 : 1);
+                pos += 6;
+            }
+            if (pos != text.size())
+            {
+                return false;
+            }
+
+            seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offset;
+            return true;
+        }
+
+        // Build from decoded users
+        void UserTable::build(const std::vector<LogipadClient::User> &users, const UserFieldMask &fields)
+        {
+            load(users, users.size(), fields);
+        }
+
+        // Build from lazily decoded users
+        void UserTable::build(const LazyUsers &users, const UserFieldMask &fields)
+        {
+            load(users, users.size(), fields);
+        }
+
+        /**
+         * @brief Fill the columns
+         * @details Dictionaries are built with a temporary hash map per column; the
+         *          parsed epoch column is derived once per distinct timestamp value.
+         */
+        template <typename Source>
+        void UserTable::load(const Source &users, std::size_t count, const UserFieldMask &fields)
+        {
+            m_rows = count;
+            m_fields = fields;
+            m_text.assign(kUserFieldCount, TextColumn());
+            m_times.assign(kUserFieldCount, {});
+            m_flags.assign(kUserFieldCount, {});
+
+            for (UserField field : fields.toFields())
+            {
+                auto index = static_cast<std::size_t>(field);
+                if (isBooleanField(field))
+                {
+                    auto &column = m_flags[index];
+                    column.resize(count);
+                    for (std::size_t row = 0; row < count; ++row)
+                    {
+                        column[row] = users[row].get(field) == std::string_view("true");
+                    }
+                    continue;
+                }
+
+                TextColumn &column = m_text[index];
+                column.codes.resize(count);
+                column.dictionary.clear();
+                // Keys view into a deque, whose elements never move, so known values cost no allocation
+                std::deque<std::string> values(1);
+                std::unordered_map<std::string_view, std::uint32_t> codes;
+                for (std::size_t row = 0; row < count; ++row)
+                {
+                    auto value = users[row].get(field);
+                    if (!value.has_value())
+                    {
+                        continue;
+                    }
+                    auto it = codes.find(*value);
+                    if (it == codes.end())
+                    {
+                        values.emplace_back(*value);
+                        it = codes.emplace(values.back(), static_cast<std::uint32_t>(values.size() - 1)).first;
+                    }
+                    column.codes[row] = it->second;
+                }
+                codes.clear();
+                column.dictionary.reserve(values.size());
+                std::move(values.begin(), values.end(), std::back_inserter(column.dictionary));
+
+                if (isTimestampField(field))
+                {
+                    std::vector<std::int64_t> parsed(column.dictionary.size(), kNoTime);
+                    for (std::size_t code = 1; code < parsed.size(); ++code)
+                    {
+                        if (!parseTimestamp(column.dictionary[code], parsed[code]))
+                        {
+                            parsed[code] = kNoTime;
+                        }
+                    }
+                    auto &times = m_times[index];
+                    times.resize(count);
+                    for (std::size_t row = 0; row < count; ++row)
+                    {
+                        times[row] = parsed[column.codes[row]];
+                    }
+                }
+            }
+        }
+
+        // Get a text column
+        const UserTable::TextColumn *UserTable::text(UserField field) const
+        {
+            if (isBooleanField(field) || !m_fields.contains(field))
+            {
+                return nullptr;
+            }
+            return &m_text[static_cast<std::size_t>(field)];
+        }
+
+        // Get a timestamp column
+        const std::vector<std::int64_t> *UserTable::times(UserField field) const
+        {
+            if (!isTimestampField(field) || !m_fields.contains(field))
+            {
+                return nullptr;
+            }
+            return &m_times[static_cast<std::size_t>(field)];
+        }
+
+        // Get a boolean column
+        const std::vector<std::uint8_t> *UserTable::flags(UserField field) const
+        {
+            if (!isBooleanField(field) || !m_fields.contains(field))
+            {
+                return nullptr;
+            }
+            return &m_flags[static_cast<std::size_t>(field)];
+        }
+
+        // Read a cell
+        std::optional<std::string_view> UserTable::get(UserField field, std::size_t row) const
+        {
+            if (const auto *column = flags(field))
+            {
+                return std::string_view((*column)[row] ? "true" : "false");
+            }
+            const TextColumn *column = text(field);
+            if (column == nullptr || column->codes[row] == 0)
+            {
+                return std::nullopt;
+            }
+            return std::string_view(column->dictionary[column->codes[row]]);
+        }
+
+    } // namespace client
+} // namespace logipad
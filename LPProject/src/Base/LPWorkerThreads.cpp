@@ -0,0 +1,71 @@
+/**
+ * @file LPWorkerThreads.cpp
+ * @brief Implementation of runTasks()
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPWorkerThreads.hpp>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace logipad
+{
+    namespace core
+    {
+
+        namespace
+        {
+            // Joins the started threads when leaving the scope, also during unwinding
+            struct JoinGuard
+            {
+                std::vector<std::thread> threads;
+
+                ~JoinGuard()
+                {
+                    for (auto &thread : threads)
+                    {
+                        thread.join();
+                    }
+                }
+            };
+        } // namespace
+
+        /**
+         * @brief Run tasks
+         * @details Threads are started one by one; the first failure to start one ends the
+         *          loop, and the tasks not yet handed to a thread are run serially.
+         */
+        void runTasks(std::size_t count, const std::function<void(std::size_t)> &task)
+        {
+            JoinGuard guard;
+            std::size_t started = 1;
+            if (count > 1)
+            {
+                guard.threads.reserve(count - 1);
+                try
+                {
+                    for (; started < count; ++started)
+                    {
+                        guard.threads.emplace_back(task, started);
+                    }
+                }
+                catch (const std::system_error &)
+                {
+                    // Out of threads: the calling thread takes over the rest
+                }
+            }
+
+            if (count > 0)
+            {
+                task(0);
+            }
+            for (std::size_t index = started; index < count; ++index)
+            {
+                task(index);
+            }
+        }
+
+    } // namespace core
+} // namespace logipad
@@ -0,0 +1,110 @@
+/**
+ * @file LPAccountMatcher.hpp
+ * @brief Matching of Logipad users to Keycloak accounts
+ * @details This file declares the AccountMatcher class, a partitioned, multi-threaded
+ *          hash join between a Logipad user list and a list of Keycloak accounts. Users
+ *          are matched by normalized email first; users and accounts left over are then
+ *          matched by username (Logipad name against Keycloak username, case-insensitive).
+ *          Every user and every account is matched at most once.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <LPKeyCloakClient.hpp>
+#include <LPLogipadClient.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class LazyUsers;
+
+        /**
+         * @class AccountMatcher
+         * @brief Reconciles Logipad users with Keycloak accounts
+         */
+        class AccountMatcher
+        {
+        public:
+            /**
+             * @brief Key a pair was matched by
+             */
+            enum class MatchKey
+            {
+                Email,   ///< Normalized email addresses are equal
+                Username ///< Logipad name equals the Keycloak username
+            };
+
+            /**
+             * @struct Match
+             * @brief Matched pair, as indices into the inputs
+             */
+            struct Match
+            {
+                std::size_t user = 0;    ///< Index of the Logipad user
+                std::size_t account = 0; ///< Index of the Keycloak account
+                MatchKey key = MatchKey::Email;
+            };
+
+            /**
+             * @struct Result
+             * @brief Outcome of a reconciliation
+             */
+            struct Result
+            {
+                std::vector<Match> matched;            ///< Pairs, ordered by user index
+                std::vector<std::size_t> usersOnly;    ///< Users without account, ascending
+                std::vector<std::size_t> accountsOnly; ///< Accounts without user, ascending
+            };
+
+            /**
+             * @brief Construct a new AccountMatcher
+             * @param threads Worker threads for build and probe; 0 uses all hardware threads
+             */
+            explicit AccountMatcher(unsigned threads = 0);
+
+            /**
+             * @brief Get the fields match() reads from Logipad users
+             * @return email and name
+             */
+            static UserFieldMask fields();
+
+            /**
+             * @brief Normalize an email address for matching
+             * @param email Address as stored
+             * @return Address without surrounding white space, in lower case
+             */
+            static std::string normalizeEmail(std::string_view email);
+
+            /**
+             * @brief Match users to accounts
+             * @param users Logipad users
+             * @param accounts Keycloak accounts
+             * @param result Receives the matched and unmatched sets
+             */
+            void match(const std::vector<LogipadClient::User> &users, const std::vector<auth::KeycloakClient::Account> &accounts, Result &result) const;
+
+            /**
+             * @brief Match lazily decoded users to accounts
+             * @param users Logipad users; only email and name are decoded
+             * @param accounts Keycloak accounts
+             * @param result Receives the matched and unmatched sets
+             */
+            void match(const LazyUsers &users, const std::vector<auth::KeycloakClient::Account> &accounts, Result &result) const;
+
+        private:
+            unsigned m_threads;
+
+            template <typename Source>
+            void run(const Source &users, std::size_t count, const std::vector<auth::KeycloakClient::Account> &accounts, Result &result) const;
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,163 @@
+/**
+ * @file LPActivityHistory.hpp
+ * @brief Append-only, delta-encoded history of user activity
+ * @details This file declares the ActivityHistory class. Each recorded directory
+ *          refresh is compared with the last known state of every user, and only the
+ *          changes to the activity timestamps and the is_active flag are kept: in
+ *          memory as one varint-encoded series per GUID, on disk as one appended batch
+ *          per refresh. Full snapshot copies are never stored.
+ *
+ * @section Format
+ * The file starts with the magic "LPACT001", followed by batches:
+ * - u32 batch length (bytes after this field), u64 observation time, varint user count
+ * - per user: varint user id; ids equal to the number of known users introduce a new
+ *   user and are followed by the u32-length-prefixed GUID
+ * - varint change count, then per change a field byte (bit 7 set: timestamp cleared)
+ *   and, unless cleared, the zigzag varint delta to the previous value (timestamps in
+ *   epoch seconds, previous value 0 if missing) or 0/1 for is_active
+ *
+ * An incomplete last batch (interrupted write) is cut off when the file is opened.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class UserTable;
+
+        /**
+         * @class ActivityHistory
+         * @brief Time series of activity changes per user
+         */
+        class ActivityHistory
+        {
+        public:
+            /**
+             * @struct Event
+             * @brief One recorded change
+             */
+            struct Event
+            {
+                std::int64_t observed = 0;          ///< Time of the refresh that saw the change
+                UserField field = UserField::IsActive; ///< Changed field
+                std::optional<std::int64_t> value;  ///< New timestamp (nullopt if cleared), or 0/1 for is_active
+            };
+
+            /**
+             * @brief Get the fields record() reads
+             * @return guid, is_active and the activity timestamps
+             */
+            static UserFieldMask fields();
+
+            /**
+             * @brief Open a history file and load its contents
+             * @param path File path; created if missing. Without open() the history is kept in memory only.
+             * @return true on success
+             */
+            bool open(const std::string &path);
+
+            /**
+             * @brief Record a refresh
+             * @param table Refreshed users, containing at least fields()
+             * @param observed Time of the refresh in seconds since the Unix epoch; not earlier than the previous one
+             * @return true on success; with a file open, the changes are appended to it
+             * @details Users missing from the table keep their last state. A GUID listed
+             *          more than once is recorded from its last row.
+             */
+            bool record(const UserTable &table, std::int64_t observed);
+
+            /**
+             * @brief Get the activity of a user over a time range
+             * @param guid User GUID
+             * @param from Start of the range (inclusive)
+             * @param to End of the range (inclusive)
+             * @param events Receives the changes in recording order; a timestamp change falls
+             *               into the range by its new value, other changes by their observation time
+             * @return true if the user is known
+             */
+            bool history(const std::string &guid, std::int64_t from, std::int64_t to, std::vector<Event> &events) const;
+
+            /**
+             * @brief Find users whose is_active flag changed within a time range
+             * @param active true for activations, false for deactivations
+             * @param from Start of the range of observation times (inclusive)
+             * @param to End of the range (inclusive)
+             * @param guids Receives the GUIDs in observation order
+             */
+            void transitions(bool active, std::int64_t from, std::int64_t to, std::vector<std::string> &guids) const;
+
+            /**
+             * @brief Get the number of known users
+             * @return User count
+             */
+            std::size_t users() const { return m_users.size(); }
+
+            /**
+             * @brief Get the size of the encoded series
+             * @return Bytes of all in-memory series
+             */
+            std::size_t bytes() const;
+
+            /**
+             * @brief Get the number of changes stored by the last record()
+             * @return Change count
+             */
+            std::size_t getLastChangeCount() const { return m_lastChangeCount; }
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+            /**
+             * @struct Change
+             * @brief Decoded change of one field
+             */
+            struct Change
+            {
+                std::uint8_t field = 0;  ///< Index into the tracked fields
+                bool cleared = false;    ///< Timestamp became missing
+                std::int64_t value = 0;  ///< New value
+            };
+
+        private:
+            /// Number of tracked fields (activity timestamps plus is_active)
+            static constexpr std::size_t kTracked = 6;
+
+            struct UserState
+            {
+                std::string guid;
+                std::string series;            ///< Encoded change groups
+                std::int64_t lastObserved = 0; ///< Observation time of the last group
+                std::int64_t values[kTracked]; ///< Current values; timestamps missing as INT64_MIN
+            };
+
+            std::string m_path;
+            std::vector<UserState> m_users;
+            std::unordered_map<std::string, std::uint32_t> m_index;
+            std::vector<std::pair<std::int64_t, std::uint32_t>> m_transitions[2]; ///< Deactivations, activations
+            std::int64_t m_lastObserved = INT64_MIN;
+            std::size_t m_lastChangeCount = 0;
+            std::string m_lastError;
+
+            std::uint32_t addUser(const std::string &guid);
+            void apply(std::uint32_t user, std::int64_t observed, const std::vector<Change> &changes);
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,124 @@
+/**
+ * @file LPActivitySketches.hpp
+ * @brief Distinct-active-user sketches per tenant, activity and day
+ * @details This file declares the ActivitySketches class. Every recorded directory
+ *          snapshot adds the GUIDs of its users to one HyperLogLog sketch per tenant,
+ *          activity kind and UTC day on which the user was active. Daily, weekly or
+ *          monthly active users over any date range are then estimated by merging the
+ *          sketches of the range, without keeping the user lists themselves.
+ *
+ * Snapshots carry only the latest timestamp per activity, so recording at least one
+ * snapshot per day captures every active day.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <LPHyperLogLog.hpp>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class UserTable;
+
+        /**
+         * @class ActivitySketches
+         * @brief Store of mergeable active-user sketches
+         */
+        class ActivitySketches
+        {
+        public:
+            /**
+             * @brief Kind of activity a sketch counts
+             */
+            enum class Activity : std::uint8_t
+            {
+                Any,      ///< Login, general activity or any service
+                Document, ///< Document service
+                Eform,    ///< eForm service
+                Briefing  ///< Briefing service
+            };
+
+            /**
+             * @brief Get the UTC day of a timestamp
+             * @param seconds Seconds since the Unix epoch
+             * @return Days since 1970-01-01
+             */
+            static std::int64_t dayOf(std::int64_t seconds);
+
+            /**
+             * @brief Get the fields record() reads
+             * @return guid and the activity timestamps
+             */
+            static UserFieldMask fields();
+
+            /**
+             * @brief Record the activity of a snapshot
+             * @param tenant Tenant the snapshot belongs to
+             * @param table Snapshot containing at least fields()
+             * @return true on success, false if a column is missing
+             * @details Recording the same snapshot twice does not change any estimate.
+             */
+            bool record(const std::string &tenant, const UserTable &table);
+
+            /**
+             * @brief Estimate the distinct active users over a range of days
+             * @param tenant Tenant to query; empty for all tenants
+             * @param activity Activity kind
+             * @param firstDay First day of the range (see dayOf())
+             * @param lastDay Last day of the range, inclusive
+             * @return Estimated number of distinct users active in the range
+             */
+            double estimate(const std::string &tenant, Activity activity, std::int64_t firstDay, std::int64_t lastDay) const;
+
+            /**
+             * @brief Drop sketches of old days
+             * @param firstDay Sketches of earlier days are removed
+             * @return Number of removed sketches
+             */
+            std::size_t prune(std::int64_t firstDay);
+
+            /**
+             * @brief Get the number of stored sketches
+             * @return Sketch count
+             */
+            std::size_t size() const { return m_sketches.size(); }
+
+            /**
+             * @brief Save the sketches to a file
+             * @param path File path; written to a temporary file and renamed
+             * @return true on success
+             */
+            bool save(const std::string &path) const;
+
+            /**
+             * @brief Load sketches saved by save(), replacing the current ones
+             * @param path File path
+             * @return true on success
+             */
+            bool load(const std::string &path);
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            using Key = std::tuple<std::string, Activity, std::int64_t>; ///< Tenant, activity, day
+
+            std::map<Key, io::HyperLogLog> m_sketches;
+            mutable std::string m_lastError;
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,157 @@
+/**
+ * @file LPBinaryIO.hpp
+ * @brief Little-endian helpers for the binary file formats of the project
+ * @details This file provides the primitives shared by the on-disk formats (cassettes,
+ *          response cache, exports): fixed-width little-endian integers, LEB128
+ *          varints, u32-length-prefixed strings and a bounds-checked reader, plus the
+ *          FNV-1a hash used for keys.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace logipad
+{
+    namespace io
+    {
+
+        /**
+         * @brief Append a little-endian u32
+         * @param out Output buffer
+         * @param value Value to append
+         */
+        inline void putU32(std::string &out, std::uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        /**
+         * @brief Append a little-endian u64
+         * @param out Output buffer
+         * @param value Value to append
+         */
+        inline void putU64(std::string &out, std::uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        /**
+         * @brief Append an unsigned LEB128 varint
+         * @param out Output buffer
+         * @param value Value to append; takes 1 byte below 128, at most 10 bytes
+         */
+        inline void putVarint(std::string &out, std::uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        /**
+         * @brief Append a u32-length-prefixed string
+         * @param out Output buffer
+         * @param value String to append
+         */
+        inline void putString(std::string &out, std::string_view value)
+        {
+            putU32(out, static_cast<std::uint32_t>(value.size()));
+            out.append(value.data(), value.size());
+        }
+
+        /**
+         * @struct Reader
+         * @brief Bounds-checked little-endian reader over a loaded buffer
+         * @details Reading past the end clears ok and yields zero values; callers check ok
+         *          once after reading a whole record.
+         */
+        struct Reader
+        {
+            const std::string &data;
+            std::size_t pos = 0;
+            bool ok = true;
+
+            std::uint64_t getInt(int bytes)
+            {
+                if (!ok || data.size() - pos < static_cast<std::size_t>(bytes))
+                {
+                    ok = false;
+                    return 0;
+                }
+                std::uint64_t value = 0;
+                for (int i = 0; i < bytes; ++i)
+                {
+                    value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[pos++])) << (8 * i);
+                }
+                return value;
+            }
+
+            std::uint32_t getU32() { return static_cast<std::uint32_t>(getInt(4)); }
+            std::uint64_t getU64() { return getInt(8); }
+
+            std::uint64_t getVarint()
+            {
+                std::uint64_t value = 0;
+                for (int shift = 0; ok && shift < 64; shift += 7)
+                {
+                    if (pos >= data.size())
+                    {
+                        break;
+                    }
+                    auto byte = static_cast<unsigned char>(data[pos++]);
+                    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                    {
+                        return value;
+                    }
+                }
+                ok = false;
+                return 0;
+            }
+
+            std::string getString()
+            {
+                std::uint32_t size = getU32();
+                if (!ok || data.size() - pos < size)
+                {
+                    ok = false;
+                    return {};
+                }
+                std::string value = data.substr(pos, size);
+                pos += size;
+                return value;
+            }
+        };
+
+        /**
+         * @brief FNV-1a hash
+         * @param data Bytes to hash
+         * @return 64-bit hash; used for lookup keys, not for integrity
+         */
+        inline std::uint64_t fnv1a(std::string_view data)
+        {
+            std::uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char c : data)
+            {
+                hash ^= c;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+    } // namespace io
+} // namespace logipad
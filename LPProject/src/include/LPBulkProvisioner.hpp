@@ -0,0 +1,170 @@
+/**
+ * @file LPBulkProvisioner.hpp
+ * @brief Journaled, resumable creation of many Keycloak users
+ * @details This file declares the BulkProvisioner class. It creates the users of a
+ *          roster one after another through KeycloakClient::createUser() and keeps a
+ *          ProvisioningJournal of every attempt, so an interrupted run (crash, network
+ *          loss, revoked credentials) can be resumed without repeating finished entries.
+ *
+ * Entries are processed in groups. The intents of a group are made durable, together
+ * with the outcomes of the previous group, by a single fsync before the first request
+ * of the group is sent. After a crash, at most one group has intents without outcomes;
+ * a resumed run sends those requests again and takes HTTP 409 as proof that the
+ * earlier attempt succeeded.
+ *
+ * Transient failures (no response, 408, 429, 5xx) are retried according to a
+ * net::RetryPolicy. Entries that fail for good are written to a DeadLetterQueue and can
+ * be re-driven later with redrive(), which replays only those entries.
+ *
+ * Both run() and redrive() can be stopped through Options::call: its token is checked
+ * between entries, aborts the request in flight and interrupts the backoff between
+ * retries, so a cancelled job releases its connection at once. A stopped run is resumed
+ * like an interrupted one.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <LPCancellation.hpp>
+#include <LPDeadLetters.hpp>
+#include <LPKeyCloakClient.hpp>
+#include <LPProvisioningJournal.hpp>
+#include <LPRetryPolicy.hpp>
+
+namespace logipad
+{
+    namespace auth
+    {
+
+        /**
+         * @class BulkProvisioner
+         * @brief Creates a roster of users with a write-ahead journal
+         */
+        class BulkProvisioner
+        {
+        public:
+            /**
+             * @struct Options
+             * @brief Run settings
+             */
+            struct Options
+            {
+                std::string journalPath;                   ///< Journal file (required by run())
+                bool resume = false;                       ///< Continue the run recorded in the journal instead of starting over
+                std::size_t groupSize = 32;                ///< Entries per group commit
+                std::string deadLetterPath;                ///< Dead-letter file (required by redrive(); empty: none for run())
+                std::size_t redriveBatchSize = 100;        ///< Letters per checkpoint of the dead-letter file in redrive()
+                net::RetryPolicy retry;                    ///< Retries of transient failures
+                net::CallContext call;                     ///< Deadline and cancellation of the whole run
+                std::chrono::milliseconds entryTimeout{0}; ///< Deadline for one entry including its retries (0: none)
+            };
+
+            /**
+             * @struct Summary
+             * @brief Result of a run
+             */
+            struct Summary
+            {
+                std::size_t created = 0;  ///< Users created by this run
+                std::size_t existed = 0;  ///< Users found to exist already (HTTP 409)
+                std::size_t failed = 0;   ///< Entries rejected locally or by Keycloak in this run
+                std::size_t finished = 0; ///< Entries skipped because an earlier run finished them (always 0 for redrive())
+            };
+
+            /**
+             * @brief Construct a new BulkProvisioner
+             * @param client Keycloak client used for the requests; must outlive this object
+             * @param options Run settings
+             */
+            BulkProvisioner(KeycloakClient &client, const Options &options);
+
+            /**
+             * @brief Create the users of a roster
+             * @param roster Users to create; must be the same roster when resuming
+             * @param realm Target realm
+             * @param summary Receives the figures of the run
+             * @return true if every entry is finished
+             * @return false if the run stopped early: the journal cannot be written, the
+             *         roster does not match the journal, Keycloak is unreachable or
+             *         rejects the credentials, or Options::call was cancelled or ran past
+             *         its deadline (see getLastError()). Resume the run later.
+             * @details Entries that fail local validation (RosterValidator) are journaled as
+             *          failed without a request. A 401 response is retried once after
+             *          authenticating again, transient failures according to Options::retry.
+             *          Failed entries are also added to the dead-letter file if one is set;
+             *          entries still failing transiently after all retries stop the run.
+             */
+            bool run(const std::vector<KeycloakClient::UserInfo> &roster, const std::string &realm, Summary &summary);
+
+            /**
+             * @brief Create the users of the dead-letter file again
+             * @param roster Roster the letters came from; supplies the passwords, which the
+             *               dead-letter file does not store
+             * @param summary Receives the figures of the re-drive
+             * @return true if every letter was processed (failed ones are kept in the file)
+             * @return false if the dead-letter file cannot be read or written, Keycloak is
+             *         unreachable or rejects the credentials, or Options::call was stopped
+             *         (see getLastError()); letters not processed stay unchanged
+             * @details Each letter is replaced by the roster user of the same username (a
+             *          letter without one fails validation), validated again and sent in
+             *          batches of Options::redriveBatchSize with the same retries as run().
+             *          Created and already existing users are removed from the file, failed
+             *          ones stay with their new error class, status and accumulated attempts.
+             *          The file is replaced atomically after every batch, so an interrupted
+             *          re-drive repeats at most one batch.
+             */
+            bool redrive(const std::vector<KeycloakClient::UserInfo> &roster, Summary &summary);
+
+            /**
+             * @brief Get the journaled state of the roster entries
+             * @return Entries by roster index after the last run
+             */
+            const std::vector<ProvisioningJournal::Entry> &entries() const { return m_journal.entries(); }
+
+            /**
+             * @brief Read a roster from a CSV file
+             * @param path CSV file with a header line naming the columns username, email,
+             *             firstName, lastName and password (any order, case-insensitive);
+             *             fields may be double-quoted
+             * @param roster Receives the users
+             * @param error Receives the error message on failure
+             * @return true on success, false if the file cannot be read or lacks a column
+             */
+            static bool loadRoster(const std::string &path, std::vector<KeycloakClient::UserInfo> &roster, std::string &error);
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            /**
+             * @struct Attempt
+             * @brief Outcome of a creation with retries
+             */
+            struct Attempt
+            {
+                bool created = false; ///< User created
+                int status = 0;       ///< HTTP status of the last request, 0 if none
+                int requests = 0;     ///< Requests sent
+                std::string error;    ///< Error message of the last request
+            };
+
+            Attempt create(const KeycloakClient::UserInfo &user, const std::string &realm);
+            bool deadLetter(const KeycloakClient::UserInfo &user, const std::string &realm, const Attempt &attempt, bool sent);
+
+            KeycloakClient &m_client;
+            Options m_options;
+            ProvisioningJournal m_journal;
+            DeadLetterQueue m_deadLetters;
+            std::string m_lastError;
+        };
+
+    } // namespace auth
+} // namespace logipad
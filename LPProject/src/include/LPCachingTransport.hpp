@@ -0,0 +1,137 @@
+/**
+ * @file LPCachingTransport.hpp
+ * @brief On-disk HTTP response cache with conditional revalidation
+ * @details This file contains the declaration of the ResponseCache class and the
+ *          CachingTransport decorator. Successful GET responses carrying an ETag or
+ *          Last-Modified validator are stored on disk. Later GETs of the same resource
+ *          are sent as conditional requests (If-None-Match / If-Modified-Since); when
+ *          the server answers 304 Not Modified, the cached response is returned in its
+ *          place, so an unchanged resource costs a single small round trip.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <LPTransport.hpp>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @brief Header added to responses served from the cache after a 304
+         * @details Its value is "revalidated". Clients may use it to reuse results they
+         *          already derived from the identical body.
+         */
+        constexpr const char *kCacheStatusHeader = "X-LP-Cache";
+
+        /**
+         * @class ResponseCache
+         * @brief Directory of cached responses shared by all transports of a run
+         * @details One file per resource, named after a hash of endpoint and path.
+         *          Request headers are not part of the key and never stored. Entries are
+         *          written to a temporary file and renamed, so concurrent readers never
+         *          see partial entries. On POSIX systems the directory is private to the
+         *          owner (0700) and entries are created with mode 0600.
+         * @warning Cached bodies contain tenant data; do not point the cache at a shared directory.
+         */
+        class ResponseCache
+        {
+        public:
+            /**
+             * @struct Entry
+             * @brief Cached response with its validators
+             */
+            struct Entry
+            {
+                std::string etag;         ///< ETag validator, empty if none
+                std::string lastModified; ///< Last-Modified validator, empty if none
+                int status = 200;         ///< Status of the cached response
+                httplib::Headers headers; ///< Headers of the cached response
+                std::string body;         ///< Body of the cached response
+            };
+
+            /**
+             * @brief Construct a new ResponseCache
+             * @param directory Cache directory; created by open() if missing
+             */
+            explicit ResponseCache(const std::string &directory);
+
+            /**
+             * @brief Create the cache directory
+             * @return true if the directory exists or was created
+             * @return false otherwise (check getLastError() for details)
+             */
+            bool open();
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            std::string getLastError() const { return m_lastError; }
+
+            /**
+             * @brief Look up a cached response
+             * @param endpoint Endpoint of the resource ("host:port")
+             * @param path Request path including the query string
+             * @param entry Receives the entry if found
+             * @return true if a valid entry exists
+             */
+            bool lookup(const std::string &endpoint, const std::string &path, Entry &entry) const;
+
+            /**
+             * @brief Store a response
+             * @param endpoint Endpoint of the resource ("host:port")
+             * @param path Request path including the query string
+             * @param response Response to store; ignored unless it carries a validator
+             * @return true if the response was stored
+             */
+            bool store(const std::string &endpoint, const std::string &path, const httplib::Response &response);
+
+        private:
+            std::string m_directory;
+            std::string m_lastError;
+
+            std::string fileFor(const std::string &key) const;
+        };
+
+        /**
+         * @class CachingTransport
+         * @brief Transport decorator answering GETs through a ResponseCache
+         * @details Non-GET requests are forwarded unchanged.
+         */
+        class CachingTransport : public Transport
+        {
+        public:
+            /**
+             * @brief Construct a new CachingTransport
+             * @param cache Cache shared by all transports of the run
+             * @param endpoint Endpoint served by this transport ("host:port")
+             * @param inner Wrapped transport
+             */
+            CachingTransport(std::shared_ptr<ResponseCache> cache, const std::string &endpoint, std::unique_ptr<Transport> inner);
+
+            httplib::Result send(const Request &request) override;
+            void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout) override;
+            std::string endpoint() const override { return m_endpoint; }
+
+        private:
+            std::shared_ptr<ResponseCache> m_cache;
+            std::string m_endpoint;
+            std::unique_ptr<Transport> m_inner;
+        };
+
+        /**
+         * @brief Wrap a transport factory with a response cache
+         * @param cache Opened cache
+         * @param inner Factory for the wrapped transports
+         * @return TransportFactory producing CachingTransport objects
+         */
+        TransportFactory cachingTransportFactory(std::shared_ptr<ResponseCache> cache, TransportFactory inner = httpTransportFactory());
+
+    } // namespace net
+} // namespace logipad
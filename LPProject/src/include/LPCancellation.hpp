@@ -0,0 +1,161 @@
+/**
+ * @file LPCancellation.hpp
+ * @brief Per-call deadlines and cooperative cancellation
+ * @details This file declares the Deadline and CancellationToken classes and the
+ *          CallContext that carries both through client operations into the transport.
+ *          Every Request holds the CallContext of the operation it belongs to:
+ *          HttpTransport clamps its connection and read timeouts to the remaining time
+ *          and aborts the transfer when the token is cancelled, so connections are
+ *          released right away instead of waiting out the fixed timeouts. Paging loops,
+ *          retries and bulk jobs check the context between steps.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @class Deadline
+         * @brief Point in time by which an operation must be finished
+         * @details A default-constructed Deadline is unset and never expires.
+         */
+        class Deadline
+        {
+        public:
+            using Clock = std::chrono::steady_clock; ///< Clock of the deadline
+
+            /**
+             * @brief Get a deadline some time from now
+             * @param timeout Time from now; zero or negative yields an unset deadline
+             * @return Deadline
+             */
+            static Deadline after(std::chrono::milliseconds timeout);
+
+            /**
+             * @brief Check whether the deadline is set
+             * @return true if the deadline can expire
+             */
+            bool isSet() const { return m_at.has_value(); }
+
+            /**
+             * @brief Check whether the deadline has passed
+             * @return true if set and passed
+             */
+            bool expired() const { return m_at && Clock::now() >= *m_at; }
+
+            /**
+             * @brief Get the time left
+             * @return Time until the deadline, zero if expired, milliseconds::max() if unset
+             */
+            std::chrono::milliseconds remaining() const;
+
+            /**
+             * @brief Get the earlier of two deadlines
+             * @param other Deadline to compare with
+             * @return The deadline that expires first; unset only if both are unset
+             */
+            Deadline earliest(const Deadline &other) const;
+
+        private:
+            std::optional<Clock::time_point> m_at;
+        };
+
+        /**
+         * @class CancellationToken
+         * @brief Shared flag that asks running operations to stop
+         * @details Copies share the same state, so a job hands copies to all of its
+         *          operations and cancels them at once. Cancellation is cooperative:
+         *          operations check isCancelled() between steps, sleep with waitFor() and
+         *          register a callback with onCancel() to abort blocking calls. All members
+         *          are thread-safe.
+         */
+        class CancellationToken
+        {
+        public:
+            /**
+             * @brief Construct a new, not yet cancelled token
+             */
+            CancellationToken();
+
+            /**
+             * @brief Cancel the token
+             * @details Runs the registered callbacks on the calling thread and wakes up
+             *          waitFor(). Later calls have no effect.
+             */
+            void cancel() const;
+
+            /**
+             * @brief Check whether the token is cancelled
+             * @return true after cancel()
+             */
+            bool isCancelled() const;
+
+            /**
+             * @brief Sleep unless cancelled
+             * @param duration Time to sleep
+             * @return true if the full time passed, false if the token was cancelled
+             */
+            bool waitFor(std::chrono::milliseconds duration) const;
+
+            /**
+             * @brief Register a callback run on cancellation
+             * @param callback Callback; runs right away if the token is already cancelled
+             * @return Id for removeCallback()
+             * @warning Callbacks must not register or remove callbacks of the same token.
+             */
+            std::size_t onCancel(std::function<void()> callback) const;
+
+            /**
+             * @brief Remove a callback
+             * @param id Id returned by onCancel()
+             * @details Waits until the callback is finished if it is running on another thread.
+             */
+            void removeCallback(std::size_t id) const;
+
+            /**
+             * @brief Create a token cancelled together with this one
+             * @return New token that can also be cancelled on its own, without affecting this one
+             */
+            CancellationToken child() const;
+
+        private:
+            struct State;
+            std::shared_ptr<State> m_state;
+        };
+
+        /**
+         * @struct CallContext
+         * @brief Deadline and cancellation of one client operation
+         */
+        struct CallContext
+        {
+            Deadline deadline;        ///< Deadline of the operation (default: none)
+            CancellationToken cancel; ///< Token cancelling the operation
+
+            /**
+             * @brief Check whether the operation should stop
+             * @return true if cancelled or past the deadline
+             */
+            bool stopped() const { return cancel.isCancelled() || deadline.expired(); }
+
+            /**
+             * @brief Describe why the operation stopped
+             * @return "Cancelled" or "Deadline exceeded"
+             */
+            std::string stopReason() const { return cancel.isCancelled() ? "Cancelled" : "Deadline exceeded"; }
+        };
+
+    } // namespace net
+} // namespace logipad
@@ -0,0 +1,180 @@
+/**
+ * @file LPCassetteTransport.hpp
+ * @brief Record/replay transport decorator for deterministic runs
+ * @details This file contains the declaration of the Cassette class and the
+ *          CassetteTransport decorator. In record mode every exchange made by the
+ *          clients is appended to a compact binary cassette file; in replay mode the
+ *          recorded responses are served from that file without any network access,
+ *          either with their original timing or as fast as possible.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <LPTransport.hpp>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @class Cassette
+         * @brief File of recorded HTTP exchanges shared by all transports of a run
+         * @details Exchanges are keyed by endpoint, method, path and a hash of the request
+         *          body. Request headers and bodies are never written to the file, so bearer
+         *          tokens and passwords sent by the clients are not persisted. Response bodies
+         *          are stored verbatim, which includes access tokens returned by Keycloak.
+         * @warning Treat cassette files as secrets.
+         */
+        class Cassette
+        {
+        public:
+            /**
+             * @brief Cassette operating mode
+             */
+            enum class Mode
+            {
+                Record, ///< Forward requests to the network and append exchanges to the file
+                Replay  ///< Serve responses from the file, never touching the network
+            };
+
+            /**
+             * @brief Replay timing
+             */
+            enum class Timing
+            {
+                Original,        ///< Delay each replayed response by its recorded duration
+                AsFastAsPossible ///< Return replayed responses immediately
+            };
+
+            /**
+             * @brief Construct a new Cassette
+             * @param path Path of the cassette file
+             * @param mode Record or replay mode
+             * @param timing Replay timing (ignored in record mode)
+             * @details The file is not touched until open() is called.
+             */
+            Cassette(const std::string &path, Mode mode, Timing timing = Timing::Original);
+
+            /**
+             * @brief Destructor
+             */
+            ~Cassette();
+
+            /**
+             * @brief Open the cassette file
+             * @return true if the file was opened (record) or loaded (replay) successfully
+             * @return false on I/O or format errors (check getLastError() for details)
+             * @details In record mode the file is truncated and, on POSIX systems, created
+             *          with mode 0600. In replay mode the whole file is loaded into memory.
+             */
+            bool open();
+
+            /**
+             * @brief Get the operating mode
+             * @return Mode the cassette was constructed with
+             */
+            Mode getMode() const { return m_mode; }
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            std::string getLastError() const;
+
+            /**
+             * @brief Append an exchange to the cassette file
+             * @param endpoint Endpoint the request was sent to ("host:port")
+             * @param request Request that was sent
+             * @param result Result returned by the wrapped transport
+             * @param elapsed Time between sending the request and receiving the result
+             * @return true if the exchange was written
+             * @return false if the cassette is not open for recording or the write failed
+             *         (check getLastError() for details); recording stops after a failed write
+             * @details The record is flushed immediately so an interrupted run keeps
+             *          every exchange completed so far.
+             */
+            bool record(
+                const std::string &endpoint,
+                const Request &request,
+                const httplib::Result &result,
+                std::chrono::microseconds elapsed);
+
+            /**
+             * @brief Replay the next recorded exchange matching a request
+             * @param endpoint Endpoint the request is sent to ("host:port")
+             * @param request Request to answer
+             * @return Recorded result, or an httplib::Error::Connection result if nothing matches
+             * @details Matching exchanges are served in recording order. Once exhausted the
+             *          last exchange keeps being replayed, so an experiment can repeat a
+             *          recorded call any number of times.
+             */
+            httplib::Result replay(const std::string &endpoint, const Request &request);
+
+        private:
+            struct Exchange
+            {
+                httplib::Error error = httplib::Error::Success;
+                int status = -1;
+                httplib::Headers headers;
+                std::string body;
+                std::chrono::microseconds elapsed{0};
+            };
+
+            std::string m_path;
+            Mode m_mode;
+            Timing m_timing;
+            std::string m_lastError;
+
+            mutable std::mutex m_mutex;
+            std::FILE *m_out = nullptr;
+            std::map<std::string, std::deque<Exchange>> m_exchanges;
+
+            static std::string makeKey(const std::string &endpoint, const Request &request);
+        };
+
+        /**
+         * @class CassetteTransport
+         * @brief Transport decorator recording to or replaying from a Cassette
+         */
+        class CassetteTransport : public Transport
+        {
+        public:
+            /**
+             * @brief Construct a new CassetteTransport
+             * @param cassette Cassette shared by all transports of the run
+             * @param endpoint Endpoint served by this transport ("host:port")
+             * @param inner Wrapped transport; only used in record mode and may be null in replay mode
+             */
+            CassetteTransport(std::shared_ptr<Cassette> cassette, const std::string &endpoint, std::unique_ptr<Transport> inner);
+
+            httplib::Result send(const Request &request) override;
+            void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout) override;
+            std::string endpoint() const override { return m_endpoint; }
+
+        private:
+            std::shared_ptr<Cassette> m_cassette;
+            std::string m_endpoint;
+            std::unique_ptr<Transport> m_inner;
+        };
+
+        /**
+         * @brief Wrap a transport factory with a cassette
+         * @param cassette Opened cassette
+         * @param inner Factory for the real transports (only used in record mode)
+         * @return TransportFactory producing CassetteTransport objects
+         */
+        TransportFactory cassetteTransportFactory(std::shared_ptr<Cassette> cassette, TransportFactory inner = httpTransportFactory());
+
+    } // namespace net
+} // namespace logipad
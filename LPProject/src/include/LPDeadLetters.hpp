@@ -0,0 +1,133 @@
+/**
+ * @file LPDeadLetters.hpp
+ * @brief Dead-letter file of failed provisioning operations
+ * @details This file declares the DeadLetterQueue class. Users that could not be
+ *          created are kept in a newline-delimited JSON file, one object per user with
+ *          the error class, HTTP status, error message, number of attempts and the
+ *          KeycloakClient::UserInfo payload without the password, so they can be
+ *          inspected and re-driven later without rerunning the whole roster. The
+ *          password is taken from the roster again when a letter is re-driven.
+ *
+ * @section Format
+ * Every line is an object such as
+ * `{"time":1735689600,"realm":"Logipad","class":"rejected","status":400,"error":"...",
+ * "attempts":1,"user":{"username":"...","email":"...","firstName":"...","lastName":"...",
+ * "enabled":true,"emailVerified":true}}`.
+ *
+ * The file holds personal data and is created readable by its owner only (mode 0600).
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <LPKeyCloakClient.hpp>
+
+namespace logipad
+{
+    namespace auth
+    {
+
+        /**
+         * @class DeadLetterQueue
+         * @brief Failed user creations kept for a later re-drive
+         */
+        class DeadLetterQueue
+        {
+        public:
+            /**
+             * @brief Cause of a failure
+             */
+            enum class ErrorClass
+            {
+                Validation, ///< Rejected locally before any request ("validation")
+                Rejected,   ///< Rejected by Keycloak with a 4xx status ("rejected")
+                Throttled,  ///< Still rate limited or timed out (408, 429) after all retries ("throttled")
+                Server,     ///< Still failing with 5xx after all retries ("server")
+                Network,    ///< No response after all retries ("network")
+                Auth        ///< Credentials rejected or missing privileges, 401 or 403 ("auth")
+            };
+
+            /**
+             * @struct Letter
+             * @brief One failed user
+             */
+            struct Letter
+            {
+                std::int64_t time = 0;                        ///< Time of the last failure in seconds since the Unix epoch
+                std::string realm;                            ///< Target realm
+                ErrorClass errorClass = ErrorClass::Rejected; ///< Cause of the last failure
+                int status = 0;                               ///< HTTP status of the last failure, 0 if none
+                std::string error;                            ///< Error message of the last failure
+                int attempts = 0;                             ///< Requests sent so far over all runs
+                KeycloakClient::UserInfo user;                ///< Payload to create; the password is never stored
+            };
+
+            /**
+             * @brief Classify a failed request
+             * @param status HTTP status, 0 if no response was received
+             * @param sent false if the user was rejected before a request was sent
+             * @return Error class
+             */
+            static ErrorClass classify(int status, bool sent);
+
+            /**
+             * @brief Get the name of an error class
+             * @param errorClass Error class
+             * @return Name used in the file (e.g., "rejected")
+             */
+            static const char *errorClassName(ErrorClass errorClass);
+
+            /**
+             * @brief Open a dead-letter file
+             * @param path File path; a missing file is an empty queue
+             * @return true on success, false if the file cannot be read or a line other
+             *         than an interrupted last one is malformed (see getLastError())
+             * @details Letters for the same realm and username are merged; the last one wins.
+             */
+            bool open(const std::string &path);
+
+            /**
+             * @brief Append a letter to the file
+             * @param letter Failed user
+             * @return true on success, false if the file cannot be written
+             */
+            bool add(const Letter &letter);
+
+            /**
+             * @brief Replace the file content
+             * @param letters Letters to keep
+             * @return true on success, false if the file cannot be written
+             * @details Writes and syncs a temporary file and renames it over the old one, so
+             *          the file holds either the old or the new letters, even after a crash.
+             */
+            bool replace(const std::vector<Letter> &letters);
+
+            /**
+             * @brief Get the letters
+             * @return Letters in the order their users first failed
+             */
+            const std::vector<Letter> &letters() const { return m_letters; }
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            void remember(const Letter &letter);
+
+            std::string m_path;
+            std::vector<Letter> m_letters;
+            std::unordered_map<std::string, std::size_t> m_index; ///< Position in m_letters by realm and username
+            std::string m_lastError;
+        };
+
+    } // namespace auth
+} // namespace logipad
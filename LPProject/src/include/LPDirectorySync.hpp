@@ -0,0 +1,139 @@
+/**
+ * @file LPDirectorySync.hpp
+ * @brief Incrementally synchronized copy of a tenant's user directory
+ * @details This file declares the DirectorySync class. It keeps a local copy of all
+ *          users of one identity API host together with a high-water mark of their
+ *          modified_at timestamps. Refreshes only request users modified since the
+ *          mark and merge them into the copy. The copy can be saved to and restored
+ *          from a snapshot file so the mark survives restarts.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <LPLogipadClient.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        /**
+         * @class DirectorySync
+         * @brief Local user directory of one tenant kept up to date with delta requests
+         * @details The first refresh downloads the whole directory. Later refreshes send
+         *          modified_since with the current watermark; if the API rejects the
+         *          filter (HTTP 400), a full download is done instead and used from then
+         *          on. Users are matched by GUID. Delta refreshes cannot see deleted
+         *          users; call fullSync() periodically if that matters.
+         */
+        class DirectorySync
+        {
+        public:
+            /**
+             * @brief Construct a new DirectorySync
+             * @param client Authenticated client used for the requests; must outlive this object
+             * @param apiHost API hostname of the tenant (e.g., "identity.demo.prod.logipad.net")
+             * @param apiPort API port (typically 443 for HTTPS)
+             */
+            DirectorySync(LogipadClient &client, const std::string &apiHost, int apiPort = 443);
+
+            /**
+             * @brief Bring the directory up to date
+             * @param call Deadline and cancellation of the refresh
+             * @return true if the directory was refreshed successfully
+             * @return false if the request failed or was cancelled; the directory is left unchanged
+             * @details Does a full sync if there is no watermark yet or the API cannot
+             *          filter by modification time, a delta sync otherwise.
+             */
+            bool refresh(const net::CallContext &call = {});
+
+            /**
+             * @brief Replace the directory with a full download
+             * @param call Deadline and cancellation of the download
+             * @return true on success, false if the request failed or was cancelled
+             * @details If the response is byte-identical to the previous full download
+             *          (same XXH64 digest) and no delta has been merged since, parsing
+             *          and rebuilding the directory are skipped.
+             */
+            bool fullSync(const net::CallContext &call = {});
+
+            /**
+             * @brief Get the cached users
+             * @return Users in the order they were first seen
+             */
+            const std::vector<LogipadClient::User> &users() const { return m_users; }
+
+            /**
+             * @brief Look up a user by GUID
+             * @param guid GUID of the user
+             * @return Pointer to the cached user, or nullptr if unknown
+             */
+            const LogipadClient::User *find(const std::string &guid) const;
+
+            /**
+             * @brief Get the high-water mark
+             * @return Largest modified_at seen, empty before the first sync
+             */
+            const std::string &getWatermark() const { return m_watermark; }
+
+            /**
+             * @brief Get the number of users changed by the last refresh
+             * @return Number of users added or updated
+             */
+            std::size_t getLastChangeCount() const { return m_lastChangeCount; }
+
+            /**
+             * @brief Get the users changed by the last refresh
+             * @return Positions in users() of the users added or updated; after a full
+             *         download that replaced the directory, every position
+             */
+            const std::vector<std::size_t> &getLastChanges() const { return m_lastChanges; }
+
+            /**
+             * @brief Write the directory and watermark to a snapshot file
+             * @param path Snapshot file path
+             * @return true on success, false if the file cannot be written
+             */
+            bool save(const std::string &path) const;
+
+            /**
+             * @brief Restore the directory and watermark from a snapshot file
+             * @param path Snapshot file path
+             * @return true on success
+             * @return false if the file cannot be read, is malformed or belongs to another tenant
+             */
+            bool load(const std::string &path);
+
+            /**
+             * @brief Get the last error message
+             * @return Error message of the last failed operation
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            void merge(std::vector<LogipadClient::User> &delta);
+            void advanceWatermark(const LogipadClient::User &user);
+
+            LogipadClient &m_client;
+            std::string m_apiHost;
+            int m_apiPort;
+
+            std::vector<LogipadClient::User> m_users;
+            std::unordered_map<std::string, std::size_t> m_index; ///< Position in m_users by GUID
+            std::string m_watermark;
+            std::uint64_t m_digest = 0; ///< Digest of the full download the directory equals, 0 if none
+            std::size_t m_lastChangeCount = 0;
+            std::vector<std::size_t> m_lastChanges;
+            bool m_deltaUnsupported = false; ///< API rejected modified_since before
+            mutable std::string m_lastError;
+        };
+
+    } // namespace client
+} // namespace logipad
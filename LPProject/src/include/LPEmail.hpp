@@ -0,0 +1,185 @@
+/**
+ * @file LPEmail.hpp
+ * @brief Email normalization and duplicate detection
+ * @details This file declares the EmailNormalizer and DuplicateDetector classes.
+ *          EmailNormalizer trims and ASCII-case-folds addresses, 16 bytes at a time
+ *          with SSE2 where available, and optionally applies provider rules.
+ *          DuplicateDetector finds provisioning entries whose email or username
+ *          collides within the batch or with already known tenant directories, so
+ *          rosters can be cleaned locally before Keycloak rejects entries with 409.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <LPKeyCloakClient.hpp>
+#include <LPLogipadClient.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class LazyUsers;
+
+        /**
+         * @brief Convert ASCII letters to lower case in place
+         * @param data Bytes to convert; non-ASCII bytes (UTF-8 sequences) are left unchanged
+         * @param size Number of bytes
+         */
+        void foldAsciiLower(char *data, std::size_t size);
+
+        /**
+         * @class EmailNormalizer
+         * @brief Canonical form of email addresses for comparison
+         */
+        class EmailNormalizer
+        {
+        public:
+            /**
+             * @struct Options
+             * @brief Normalization rules beyond trimming and case folding
+             */
+            struct Options
+            {
+                bool stripPlusTags = false; ///< Drop "+tag" suffixes of the local part for every domain
+                bool providerRules = false; ///< Gmail: drop dots and "+tag" of the local part, googlemail.com becomes gmail.com
+            };
+
+            /**
+             * @brief Construct a new EmailNormalizer
+             * @param options Normalization rules
+             */
+            explicit EmailNormalizer(const Options &options);
+
+            /**
+             * @brief Construct an EmailNormalizer that only trims and folds case
+             */
+            EmailNormalizer();
+
+            /**
+             * @brief Normalize an address
+             * @param email Address as entered
+             * @param out Receives the normalized address (the buffer is reused)
+             * @details Surrounding white space is removed and ASCII letters are folded to
+             *          lower case. Provider rules apply only to addresses containing '@'.
+             */
+            void normalize(std::string_view email, std::string &out) const;
+
+            /**
+             * @brief Normalize an address
+             * @param email Address as entered
+             * @return Normalized address
+             */
+            std::string normalize(std::string_view email) const;
+
+        private:
+            Options m_options;
+        };
+
+        /**
+         * @class DuplicateDetector
+         * @brief Finds email and username collisions in provisioning batches
+         * @details Known directories and checked batches are kept as 64-bit hashes of the
+         *          normalized keys (xxh64); with a few million keys, the chance of a false
+         *          report is below one in a billion.
+         */
+        class DuplicateDetector
+        {
+        public:
+            /**
+             * @brief Colliding key
+             */
+            enum class Key
+            {
+                Email,   ///< Normalized email address
+                Username ///< Username, case-insensitive
+            };
+
+            /**
+             * @struct Duplicate
+             * @brief Batch entry whose key is already taken
+             */
+            struct Duplicate
+            {
+                std::size_t index = 0;  ///< Index of the entry in the checked batch
+                Key key = Key::Email;   ///< Colliding key
+                std::string value;      ///< Normalized key value
+                std::string owner;      ///< Tenant holding the key, empty if taken earlier in the same batch
+                std::size_t row = 0;    ///< Row of the holder in its tenant directory or in the batch
+            };
+
+            /**
+             * @brief Construct a new DuplicateDetector
+             * @param options Email normalization rules
+             */
+            explicit DuplicateDetector(const EmailNormalizer::Options &options = EmailNormalizer::Options());
+
+            /**
+             * @brief Register the users of a tenant directory
+             * @param tenant Tenant name reported for collisions
+             * @param users Existing users; email and name are read
+             */
+            void addDirectory(const std::string &tenant, const std::vector<LogipadClient::User> &users);
+
+            /**
+             * @brief Register the users of a lazily decoded tenant directory
+             * @param tenant Tenant name reported for collisions
+             * @param users Existing users; only email and name are decoded
+             */
+            void addDirectory(const std::string &tenant, const LazyUsers &users);
+
+            /**
+             * @brief Check a provisioning batch
+             * @param batch Users to be created
+             * @param duplicates Receives the colliding entries in batch order; an entry may be
+             *                   reported once per key
+             * @details Only looks keys up; the detector is not modified.
+             */
+            void check(const std::vector<auth::KeycloakClient::UserInfo> &batch, std::vector<Duplicate> &duplicates) const;
+
+            /**
+             * @brief Register the entries of a checked batch that passed
+             * @param tenant Tenant name reported for later collisions
+             * @param batch Batch given to check()
+             * @param duplicates Result of check() for the batch
+             * @details Entries reported in duplicates are skipped with all of their keys, so
+             *          later batches are only checked against users that can be created.
+             */
+            void commit(const std::string &tenant, const std::vector<auth::KeycloakClient::UserInfo> &batch, const std::vector<Duplicate> &duplicates);
+
+            /**
+             * @brief Get the number of registered keys
+             * @return Email and username keys
+             */
+            std::size_t size() const { return m_keys.size(); }
+
+        private:
+            struct Holder
+            {
+                std::uint32_t owner; ///< Index into m_owners
+                std::uint32_t row;
+            };
+
+            struct Identity
+            {
+                std::size_t operator()(std::uint64_t hash) const { return static_cast<std::size_t>(hash); }
+            };
+
+            EmailNormalizer m_normalizer;
+            std::vector<std::string> m_owners;
+            std::unordered_map<std::uint64_t, Holder, Identity> m_keys;
+
+            template <typename Source>
+            void add(const std::string &tenant, const Source &users, std::size_t count);
+        };
+
+    } // namespace client
+} // namespace logipad
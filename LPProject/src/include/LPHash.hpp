@@ -0,0 +1,31 @@
+/**
+ * @file LPHash.hpp
+ * @brief Fast non-cryptographic hashing of response payloads
+ * @details This file declares xxh64(), an implementation of the XXH64 algorithm
+ *          (xxHash, 64-bit variant). It hashes several gigabytes per second and is
+ *          used to recognise unchanged payloads without parsing them.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace logipad
+{
+    namespace io
+    {
+
+        /**
+         * @brief Compute the XXH64 digest of a buffer
+         * @param data Bytes to hash
+         * @param seed Hash seed
+         * @return 64-bit digest, identical to the reference XXH64 implementation
+         * @note Not suitable where collisions could be provoked deliberately.
+         */
+        std::uint64_t xxh64(std::string_view data, std::uint64_t seed = 0);
+
+    } // namespace io
+} // namespace logipad
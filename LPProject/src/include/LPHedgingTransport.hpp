@@ -0,0 +1,169 @@
+/**
+ * @file LPHedgingTransport.hpp
+ * @brief Hedged GET requests for lower tail latency
+ * @details This file contains the declaration of the LatencyTracker class and the
+ *          HedgingTransport decorator. A GET that has not been answered within a
+ *          percentile of the latencies recently observed for its endpoint is sent a
+ *          second time over another connection. The first response that is not a
+ *          server error (5xx) wins; the other attempt is cancelled, which shuts its socket down. Only idempotent requests
+ *          (GET) are hedged, so sending one twice is harmless.
+ *
+ * With the default 95th percentile, about one request in twenty is sent twice, which
+ * removes most of the latency of the slowest few requests for a few percent of extra load.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <LPTransport.hpp>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @class LatencyTracker
+         * @brief Recent response latencies per endpoint, shared by all transports of a run
+         * @details Keeps a sliding window of latencies per endpoint and derives the delay
+         *          after which a request is hedged. Clients create a new transport for
+         *          every call, so the statistics live here rather than in the transport.
+         *          All members are thread-safe.
+         */
+        class LatencyTracker
+        {
+        public:
+            /**
+             * @struct Options
+             * @brief Hedging settings
+             */
+            struct Options
+            {
+                double percentile = 95.0;                     ///< Percentile of the observed latency after which a request is hedged
+                std::size_t window = 256;                     ///< Latencies kept per endpoint
+                std::size_t minSamples = 16;                  ///< Latencies needed before the percentile is used
+                std::chrono::milliseconds initialDelay{1000}; ///< Hedge delay while fewer than minSamples are known
+                std::chrono::milliseconds minDelay{5};        ///< Lower bound of the hedge delay
+            };
+
+            /**
+             * @brief Construct a new LatencyTracker
+             * @param options Hedging settings
+             */
+            explicit LatencyTracker(const Options &options);
+
+            /**
+             * @brief Record the latency of an answered request
+             * @param endpoint Endpoint of the request ("host:port")
+             * @param latency Time until the caller received a response that is not a server error
+             */
+            void record(const std::string &endpoint, std::chrono::milliseconds latency);
+
+            /**
+             * @brief Get the time after which a request is hedged
+             * @param endpoint Endpoint of the request ("host:port")
+             * @return Options::percentile of the recorded latencies, at least Options::minDelay;
+             *         Options::initialDelay while fewer than Options::minSamples are recorded
+             */
+            std::chrono::milliseconds hedgeDelay(const std::string &endpoint) const;
+
+            /**
+             * @brief Count a hedged request
+             * @param won true if the second attempt answered first
+             */
+            void countHedge(bool won);
+
+            /**
+             * @brief Get the number of hedged requests
+             * @return Requests for which a second attempt was sent
+             */
+            std::size_t getHedgedCount() const { return m_hedged; }
+
+            /**
+             * @brief Get the number of requests answered by the second attempt
+             * @return Hedged requests won by the second attempt
+             */
+            std::size_t getHedgeWins() const { return m_wins; }
+
+        private:
+            /**
+             * @struct Window
+             * @brief Ring buffer of the latest latencies of one endpoint
+             */
+            struct Window
+            {
+                std::vector<std::chrono::milliseconds> samples;
+                std::size_t next = 0; ///< Slot overwritten next once the buffer is full
+            };
+
+            Options m_options;
+            mutable std::mutex m_mutex;
+            std::unordered_map<std::string, Window> m_windows;
+            std::atomic<std::size_t> m_hedged{0};
+            std::atomic<std::size_t> m_wins{0};
+        };
+
+        /**
+         * @class HedgingTransport
+         * @brief Transport decorator hedging GET requests
+         * @details The first attempt runs on the calling thread. A helper thread waits
+         *          for LatencyTracker::hedgeDelay() and, if the first attempt is still
+         *          running, sends the second attempt over a separate transport created
+         *          on first use. Whichever attempt first receives a response that is not a
+         *          server error cancels the other through its child token. If an attempt
+         *          fails or answers 5xx, the other one is awaited. Other methods are
+         *          forwarded unchanged.
+         *
+         * The helper thread is started for every GET that may be hedged and joined before
+         * send() returns. Clients create a transport per call, so a worker kept by the
+         * transport would not outlive the call either; thread creation costs microseconds,
+         * far less than the round trip it guards.
+         */
+        class HedgingTransport : public Transport
+        {
+        public:
+            /**
+             * @brief Construct a new HedgingTransport
+             * @param tracker Latency statistics shared by all transports of the run
+             * @param host Server hostname
+             * @param port Server port
+             * @param inner Factory for the transports of the two attempts
+             */
+            HedgingTransport(std::shared_ptr<LatencyTracker> tracker, const std::string &host, int port, TransportFactory inner);
+
+            httplib::Result send(const Request &request) override;
+            void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout) override;
+            std::string endpoint() const override { return m_endpoint; }
+
+        private:
+            std::shared_ptr<LatencyTracker> m_tracker;
+            std::string m_host;
+            int m_port;
+            std::string m_endpoint;
+            TransportFactory m_inner;
+            std::unique_ptr<Transport> m_primary;
+            std::unique_ptr<Transport> m_secondary; ///< Transport of second attempts, created on first use
+            bool m_timeoutsSet = false;
+            std::chrono::milliseconds m_connectTimeout{0};
+            std::chrono::milliseconds m_readTimeout{0};
+        };
+
+        /**
+         * @brief Wrap a transport factory with request hedging
+         * @param tracker Latency statistics shared by all transports of the run
+         * @param inner Factory for the wrapped transports
+         * @return TransportFactory producing HedgingTransport objects
+         */
+        TransportFactory hedgingTransportFactory(std::shared_ptr<LatencyTracker> tracker, TransportFactory inner = httpTransportFactory());
+
+    } // namespace net
+} // namespace logipad
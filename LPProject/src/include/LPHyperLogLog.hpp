@@ -0,0 +1,88 @@
+/**
+ * @file LPHyperLogLog.hpp
+ * @brief HyperLogLog cardinality sketch
+ * @details This file declares the HyperLogLog class, which estimates the number of
+ *          distinct items added to it in a fixed 4 KiB of state (standard error about
+ *          1.6 %). Sketches of disjoint or overlapping sets merge losslessly, so the
+ *          distinct count of a union is answered from the sketches alone.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <LPBinaryIO.hpp>
+
+namespace logipad
+{
+    namespace io
+    {
+
+        /**
+         * @class HyperLogLog
+         * @brief Mergeable distinct-count sketch (Flajolet et al., 64-bit hashes)
+         */
+        class HyperLogLog
+        {
+        public:
+            /// Index bits of the hash; 2^kPrecision registers
+            static constexpr unsigned kPrecision = 12;
+            /// Number of registers
+            static constexpr std::size_t kRegisters = std::size_t(1) << kPrecision;
+
+            /**
+             * @brief Add an item
+             * @param item Item to count (hashed with xxh64)
+             */
+            void add(std::string_view item);
+
+            /**
+             * @brief Add an item by its 64-bit hash
+             * @param hash Well-mixed hash of the item
+             */
+            void addHash(std::uint64_t hash);
+
+            /**
+             * @brief Merge another sketch into this one
+             * @param other Sketch to merge; afterwards this sketch counts the union
+             */
+            void merge(const HyperLogLog &other);
+
+            /**
+             * @brief Estimate the number of distinct items
+             * @return Estimated cardinality, using linear counting for small sets
+             */
+            double estimate() const;
+
+            /**
+             * @brief Check whether nothing has been added
+             * @return true if every register is zero
+             */
+            bool empty() const;
+
+            /**
+             * @brief Append the sketch to a buffer
+             * @param out Buffer to append to
+             * @details Sparse sketches are written as varint (index delta, rank) pairs, so
+             *          a sketch of a few hundred users takes well under a kilobyte.
+             */
+            void serialize(std::string &out) const;
+
+            /**
+             * @brief Read a sketch written by serialize()
+             * @param in Reader positioned at the sketch
+             * @return true on success; false clears in.ok on malformed data
+             */
+            bool deserialize(Reader &in);
+
+        private:
+            std::array<std::uint8_t, kRegisters> m_registers{};
+        };
+
+    } // namespace io
+} // namespace logipad
@@ -0,0 +1,124 @@
+/**
+ * @file LPJsonBackend.hpp
+ * @brief Compile-time selectable JSON parsing backends
+ * @details This file declares the JSON backend policies used to parse the
+ *          identity API user list and Keycloak token responses. The nlohmann
+ *          backend is always available; the simdjson on-demand backend is compiled
+ *          in when the project is configured with -DLP_USE_SIMDJSON=ON.
+ *          logipad::json::Backend names the policy selected at build time.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <LPLogipadClient.hpp>
+#include <LPJsonScan.hpp>
+
+/**
+ * @namespace logipad::json
+ * @brief JSON parsing backends
+ */
+
+namespace logipad
+{
+    namespace json
+    {
+
+        /**
+         * @struct NlohmannBackend
+         * @brief JSON backend based on nlohmann::json DOM parsing
+         */
+        struct NlohmannBackend
+        {
+            static constexpr const char *name = "nlohmann"; ///< Backend name for diagnostics
+
+            /**
+             * @brief Parse a user list response
+             * @param body Response body, either an array of users or an object with a "users" array
+             * @param users Vector the parsed users are appended to; unchanged on failure
+             * @param error Receives the error message on failure
+             * @param fields Fields to decode; members outside the mask are skipped
+             * @return true if the body was parsed successfully
+             * @return false if the body is not valid JSON or followed by other data, an array
+             *         element is not an object, or a selected field has an unexpected type
+             * @details Any other top-level shape is accepted and yields no users. Fields outside
+             *          the mask are left empty; the boolean fields keep their defaults.
+             */
+            static bool parseUsers(
+                const std::string &body,
+                std::vector<client::LogipadClient::User> &users,
+                std::string &error,
+                const client::UserFieldMask &fields = client::UserFieldMask::all());
+
+            /**
+             * @brief Parse a single user object located inside a larger buffer
+             * @param body Buffer holding the user object
+             * @param element Byte range of the user object within body (see scanUserArray())
+             * @param user Receives the parsed user
+             * @param error Receives the error message on failure
+             * @param fields Fields to decode; members outside the mask are skipped
+             * @return true if the object was parsed successfully
+             * @return false if the element is not valid JSON, not an object, or a selected field has
+             *         an unexpected type
+             * @note Safe to call concurrently from several threads on the same body.
+             */
+            static bool parseUser(
+                const std::string &body,
+                Range element,
+                client::LogipadClient::User &user,
+                std::string &error,
+                const client::UserFieldMask &fields = client::UserFieldMask::all());
+
+            /**
+             * @brief Parse an OpenID Connect token response
+             * @param body Response body of the token endpoint
+             * @param accessToken Receives the value of "access_token"
+             * @param error Receives the error message on failure
+             * @return true if the access token was found
+             * @return false if the body is not valid JSON or contains no access token
+             */
+            static bool parseAccessToken(const std::string &body, std::string &accessToken, std::string &error);
+        };
+
+#ifdef LP_USE_SIMDJSON
+        /**
+         * @struct SimdjsonBackend
+         * @brief JSON backend based on the simdjson on-demand API
+         * @details Fields are decoded straight from the input while iterating, without
+         *          building a DOM. The parser is kept per thread so its buffers are reused
+         *          across calls. Bodies are parsed in place when the string capacity already
+         *          provides simdjson's padding, otherwise a padded copy is made.
+         */
+        struct SimdjsonBackend
+        {
+            static constexpr const char *name = "simdjson"; ///< Backend name for diagnostics
+
+            /// @copydoc NlohmannBackend::parseUsers
+            static bool parseUsers(
+                const std::string &body,
+                std::vector<client::LogipadClient::User> &users,
+                std::string &error,
+                const client::UserFieldMask &fields = client::UserFieldMask::all());
+
+            /// @copydoc NlohmannBackend::parseUser
+            static bool parseUser(
+                const std::string &body,
+                Range element,
+                client::LogipadClient::User &user,
+                std::string &error,
+                const client::UserFieldMask &fields = client::UserFieldMask::all());
+
+            /// @copydoc NlohmannBackend::parseAccessToken
+            static bool parseAccessToken(const std::string &body, std::string &accessToken, std::string &error);
+        };
+
+        using Backend = SimdjsonBackend; ///< Backend selected at build time
+#else
+        using Backend = NlohmannBackend; ///< Backend selected at build time
+#endif
+
+    } // namespace json
+} // namespace logipad
@@ -0,0 +1,137 @@
+/**
+ * @file LPJsonScan.hpp
+ * @brief Lightweight structural JSON scanner
+ * @details This file declares helpers that locate JSON values inside a buffer
+ *          without decoding them. They only track strings (including escapes) and
+ *          bracket nesting, which is enough to find element boundaries of large
+ *          arrays cheaply. Values found this way are validated later by a real parser.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logipad
+{
+    namespace json
+    {
+
+        /**
+         * @struct Range
+         * @brief Half-open byte range [begin, end) inside a JSON buffer
+         */
+        struct Range
+        {
+            std::size_t begin = 0; ///< Offset of the first byte
+            std::size_t end = 0;   ///< Offset one past the last byte
+        };
+
+        /**
+         * @brief Value returned by the skip helpers when the input ends prematurely
+         */
+        constexpr std::size_t kScanError = std::string_view::npos;
+
+        /**
+         * @brief Skip JSON whitespace
+         * @param text JSON buffer
+         * @param pos Start offset
+         * @return Offset of the first non-whitespace byte (text.size() if none)
+         */
+        std::size_t skipWhitespace(std::string_view text, std::size_t pos);
+
+        /**
+         * @brief Skip a JSON string
+         * @param text JSON buffer
+         * @param pos Offset of the opening quote
+         * @return Offset one past the closing quote, or kScanError if the string is unterminated
+         */
+        std::size_t skipString(std::string_view text, std::size_t pos);
+
+        /**
+         * @brief Skip a JSON value of any type
+         * @param text JSON buffer
+         * @param pos Offset of the first byte of the value
+         * @return Offset one past the value, or kScanError if the value is truncated
+         * @details Objects and arrays are skipped by bracket counting; scalars end at the
+         *          next structural character or whitespace.
+         */
+        std::size_t skipValue(std::string_view text, std::size_t pos);
+
+        /**
+         * @brief Locate the array holding the users of a user list response
+         * @param text Response body, either an array of users or an object with a "users" array
+         * @param error Receives the error message on failure
+         * @return Offset of the opening '[' of the user array, text.size() if the body has
+         *         another shape (and therefore no users), or kScanError if it is malformed
+         */
+        std::size_t findUserArray(std::string_view text, std::string &error);
+
+        /**
+         * @brief Visit every element of a JSON array
+         * @param text JSON buffer
+         * @param arrayPos Offset of the opening '['
+         * @param visit Called with the offset of each element; returns the offset one past
+         *              the element, or kScanError to abort
+         * @param error Receives the error message on failure
+         * @return true if the whole array was visited, false on malformed input or abort
+         */
+        bool forEachElement(
+            std::string_view text,
+            std::size_t arrayPos,
+            const std::function<std::size_t(std::size_t pos)> &visit,
+            std::string &error);
+
+        /**
+         * @brief Visit every user of a user list response
+         * @param text Response body, either an array of users or an object with a "users" array
+         * @param visit Called with the offset of each element of the user array; returns the
+         *              offset one past the element, or kScanError to abort
+         * @param error Receives the error message on failure
+         * @return true if every user was visited and only whitespace follows the body
+         * @return false on malformed input, trailing data or abort
+         * @details Combines findUserArray() and forEachElement(). Any other top-level value
+         *          yields no users, as in the JSON backends.
+         */
+        bool forEachUser(std::string_view text, const std::function<std::size_t(std::size_t pos)> &visit, std::string &error);
+
+        /**
+         * @brief Visit every member of a JSON object
+         * @param text JSON buffer
+         * @param objectPos Offset of the opening '{'
+         * @param visit Called with the raw (still escaped) key and the value range of each
+         *              member; returns false to abort
+         * @return Offset one past the closing '}', or kScanError on malformed input or abort
+         */
+        std::size_t forEachMember(
+            std::string_view text,
+            std::size_t objectPos,
+            const std::function<bool(std::string_view key, Range value)> &visit);
+
+        /**
+         * @brief Decode the escape sequences of a JSON string
+         * @param raw String content between the quotes, still escaped
+         * @param out Receives the decoded UTF-8 string
+         * @return true on success, false on invalid escape sequences
+         */
+        bool unescapeString(std::string_view raw, std::string &out);
+
+        /**
+         * @brief Find the element ranges of a user list response
+         * @param text Response body, either an array of users or an object with a "users" array
+         * @param elements Receives one Range per array element, in input order
+         * @param error Receives the error message on failure
+         * @return true if the body was scanned successfully
+         * @return false if the structure is malformed or non-whitespace follows the body
+         * @details Accepts the same shapes as the JSON backends: any other top-level value
+         *          yields no elements.
+         */
+        bool scanUserArray(std::string_view text, std::vector<Range> &elements, std::string &error);
+
+    } // namespace json
+} // namespace logipad
@@ -11,11 +11,15 @@
 
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <memory>
 #include <map>
+#include <vector>
 #include <httplib.h>
 #include <nlohmann/json.hpp>
+#include <LPCancellation.hpp>
+#include <LPTransport.hpp>
 
 /**
  * @namespace logipad::auth
@@ -63,6 +67,20 @@ namespace logipad
                 nlohmann::json toJson() const;
             };
 
+            /**
+             * @struct Account
+             * @brief Brief representation of an existing Keycloak user
+             */
+            struct Account
+            {
+                std::string id;        ///< Keycloak user ID
+                std::string username;  ///< Username (Keycloak stores usernames in lower case)
+                std::string email;     ///< Email address, empty if not set
+                std::string firstName; ///< First name, empty if not set
+                std::string lastName;  ///< Last name, empty if not set
+                bool enabled = true;   ///< Whether the account is enabled
+            };
+
             /**
              * @brief Construct a new LPKeyCloakClient object
              * @param host Keycloak server hostname (e.g., "keycloak-cloud.logipad.net")
@@ -73,7 +91,8 @@ namespace logipad
              * @param password Password for authentication
              * @details Creates a new Keycloak client instance and initializes the HTTPS client
              *          connection. Authentication must be performed separately using authenticate().
-             * @note The SSL client is initialized with connection and read timeouts of 10 seconds.
+             * @note The transport uses connection and read timeouts of 10 seconds until
+             *       setTimeouts() is called.
              */
             KeycloakClient(
                 const std::string &host = "keycloak-cloud.logipad.net",
@@ -90,6 +109,7 @@ namespace logipad
 
             /**
              * @brief Authenticate with Keycloak and obtain access token
+             * @param call Deadline and cancellation of the request
              * @return true if authentication succeeded and access token was obtained
              * @return false if authentication failed (check getLastError() for details)
              * @details Performs password grant authentication using the configured credentials.
@@ -98,22 +118,41 @@ namespace logipad
              * @see getAccessToken()
              * @see getLastError()
              */
-            bool authenticate();
+            bool authenticate(const net::CallContext &call = {});
 
             /**
              * @brief Create a new user in Keycloak
              * @param userInfo User information structure containing user details
              * @param realm Keycloak realm where the user should be created
+             * @param call Deadline and cancellation of the operation, including a needed authentication
              * @return true if user was created successfully (HTTP 201)
              * @return false if creation failed (check getLastError() for details)
              * @details Creates a new user in the specified Keycloak realm using the Admin REST API.
+             *          Only username and email are required here; BulkProvisioner checks whole
+             *          rosters with RosterValidator before creating them.
              *          The method automatically authenticates if no valid token is present.
-             * @note Returns false with status 409 if a user with the same username already exists.
+             * @note Returns false with status 409 if a user with the same username already exists,
+             *       and with status 0 if the call was cancelled or its deadline passed.
+             *       A 401 response discards the access token, so the next call authenticates again.
              * @warning Requires admin privileges in the specified realm.
              * @see authenticate()
              * @see getLastError()
              */
-            bool createUser(const UserInfo &userInfo, const std::string &realm);
+            bool createUser(const UserInfo &userInfo, const std::string &realm, const net::CallContext &call = {});
+
+            /**
+             * @brief List all users of a realm
+             * @param accounts Receives the accounts in the order returned by Keycloak
+             * @param realm Keycloak realm to list
+             * @param pageSize Accounts requested per page (Keycloak's "max" parameter); must be positive
+             * @param call Deadline and cancellation of the whole listing, checked before every page
+             * @return true if every page was retrieved
+             * @return false on request or parse errors (check getLastError() for details)
+             * @details Pages through /admin/realms/{realm}/users with the brief representation
+             *          until a short page is returned.
+             * @warning Requires the view-users role in the specified realm.
+             */
+            bool listUsers(std::vector<Account> &accounts, const std::string &realm, int pageSize = 500, const net::CallContext &call = {});
 
             /**
              * @brief Get the current access token
@@ -133,6 +172,12 @@ namespace logipad
              */
             std::string getLastError() const { return m_lastError; }
 
+            /**
+             * @brief Get the HTTP status of the last request
+             * @return Status code, or 0 if no response was received or the request was not sent
+             */
+            int getLastStatus() const { return m_lastStatus; }
+
             /**
              * @brief Set authentication credentials
              * @param username Username for authentication
@@ -140,6 +185,23 @@ namespace logipad
              */
             void setCredentials(const std::string &username, const std::string &password);
 
+            /**
+             * @brief Set the connection and read timeouts of the transport
+             * @param connectTimeout Maximum time to establish a connection
+             * @param readTimeout Maximum time to wait for response data
+             * @details Upper bounds for every request; a call deadline may shorten them.
+             */
+            void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout);
+
+            /**
+             * @brief Replace the factory used to create the HTTP transport
+             * @param factory Transport factory (e.g., a cassette decorator)
+             * @details Recreates the transport for the configured host and port and
+             *          re-applies the timeouts.
+             * @see net::cassetteTransportFactory()
+             */
+            void setTransportFactory(net::TransportFactory factory);
+
         private:
             std::string m_host;
             int m_port;
@@ -149,8 +211,12 @@ namespace logipad
             std::string m_password;
             std::string m_accessToken;
             std::string m_lastError;
+            int m_lastStatus = 0;
+            std::chrono::milliseconds m_connectTimeout{std::chrono::seconds(10)};
+            std::chrono::milliseconds m_readTimeout{std::chrono::seconds(10)};
 
-            std::unique_ptr<httplib::SSLClient> m_client;
+            net::TransportFactory m_transportFactory;
+            std::unique_ptr<net::Transport> m_client;
 
             /**
              * @brief Get authorization headers with Bearer token
@@ -164,13 +230,14 @@ namespace logipad
 
             /**
              * @brief Ensure client is authenticated, re-authenticate if necessary
+             * @param call Deadline and cancellation of the calling operation
              * @return true if client has a valid access token (or successfully authenticated)
              * @return false if authentication failed
              * @details Checks if an access token exists. If not, attempts to authenticate
              *          using the stored credentials. Used internally before making API calls.
              * @see authenticate()
              */
-            bool ensureAuthenticated();
+            bool ensureAuthenticated(const net::CallContext &call);
         };
 
     } // namespace auth
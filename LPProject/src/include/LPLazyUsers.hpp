@@ -0,0 +1,167 @@
+/**
+ * @file LPLazyUsers.hpp
+ * @brief Lazily decoded user list over the retained response buffer
+ * @details This file contains the declaration of the LazyUsers class. Instead of
+ *          decoding every field of every user up front, LazyUsers keeps the raw
+ *          response body and records the location of each field in one structural
+ *          pass. Fields are decoded only when accessed: strings without escape
+ *          sequences are returned as zero-copy views into the buffer, strings with
+ *          escapes are decoded once and cached.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <LPLogipadClient.hpp>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        /**
+         * @class LazyUsers
+         * @brief User list whose fields are decoded on first access
+         * @details Views returned by operator[] stay valid until the container is
+         *          reloaded, cleared or destroyed. Concurrent reads are safe.
+         */
+        class LazyUsers
+        {
+        public:
+            /**
+             * @class View
+             * @brief Lightweight handle to one user of a LazyUsers container
+             */
+            class View
+            {
+            public:
+                /**
+                 * @brief Get a field
+                 * @param field Field to read
+                 * @return Field value, or no value if the field is missing or null; boolean
+                 *         fields yield "true" or "false"
+                 */
+                std::optional<std::string_view> get(UserField field) const;
+
+                /**
+                 * @brief Get the user GUID
+                 * @return GUID, empty if the user has none
+                 */
+                std::string_view guid() const { return get(UserField::Guid).value_or(std::string_view()); }
+
+                /**
+                 * @brief Get the display name
+                 * @return Name, or no value if missing or null
+                 */
+                std::optional<std::string_view> name() const { return get(UserField::Name); }
+
+                /**
+                 * @brief Get the email address
+                 * @return Email address, or no value if missing or null
+                 */
+                std::optional<std::string_view> email() const { return get(UserField::Email); }
+
+                /**
+                 * @brief Check whether the user account is active
+                 * @return Value of is_active, true if the field is missing
+                 */
+                bool isActive() const;
+
+                /**
+                 * @brief Check whether the user is reportable
+                 * @return Value of is_reportable, false if the field is missing
+                 */
+                bool isReportable() const;
+
+                /**
+                 * @brief Decode all fields into a regular User
+                 * @return Fully materialized user record
+                 */
+                LogipadClient::User toUser() const;
+
+            private:
+                friend class LazyUsers;
+                View(const LazyUsers *owner, std::size_t index) : m_owner(owner), m_index(index) {}
+
+                const LazyUsers *m_owner;
+                std::size_t m_index;
+            };
+
+            /**
+             * @brief Load a user list response
+             * @param body Response body; the container takes ownership of the buffer
+             * @param error Receives the error message on failure
+             * @param fields Fields to index; members outside the mask are skipped
+             * @return true if the body was indexed successfully
+             * @return false if the body is malformed or followed by other data, or a selected
+             *         field has an unexpected type (a null guid included) or an invalid escape
+             * @details Accepts and rejects the same bodies as the JSON backends do with the
+             *          same field mask. Any previously loaded data is discarded, invalidating
+             *          existing views.
+             */
+            bool load(std::string body, std::string &error, const UserFieldMask &fields = UserFieldMask::all());
+
+            /**
+             * @brief Discard all users and the retained buffer
+             */
+            void clear();
+
+            /**
+             * @brief Get the number of users
+             * @return Number of users in the container
+             */
+            std::size_t size() const { return m_count; }
+
+            /**
+             * @brief Check whether the container is empty
+             * @return true if no users are loaded
+             */
+            bool empty() const { return m_count == 0; }
+
+            /**
+             * @brief Access a user
+             * @param index Index of the user, in response order
+             * @return View of the user
+             */
+            View operator[](std::size_t index) const { return View(this, index); }
+
+        private:
+            enum class SlotKind : std::uint8_t
+            {
+                Missing,
+                Null,
+                String,
+                EscapedString,
+                True,
+                False
+            };
+
+            struct Slot
+            {
+                std::uint32_t offset = 0; ///< Offset of the string content (after the quote)
+                std::uint32_t length = 0; ///< Length of the raw string content
+                SlotKind kind = SlotKind::Missing;
+            };
+
+            std::string m_body;
+            std::vector<Slot> m_slots; ///< kUserFieldCount slots per user
+            std::size_t m_count = 0;
+
+            mutable std::mutex m_decodedMutex;
+            mutable std::unordered_map<std::size_t, std::string> m_decoded; ///< Decoded escaped strings by slot index
+
+            const Slot &slot(std::size_t index, UserField field) const { return m_slots[index * kUserFieldCount + static_cast<std::size_t>(field)]; }
+            std::optional<std::string_view> stringValue(std::size_t index, UserField field) const;
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -10,10 +10,16 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <httplib.h>
+#include <LPCancellation.hpp>
 #include <LPKeyCloakClient.hpp>
+#include <LPTransport.hpp>
+#include <LPUserFields.hpp>
+#include <LPUserQuery.hpp>
 #include <optional>
 #include <vector>
 #include <nlohmann/json.hpp>
@@ -28,6 +34,8 @@ namespace logipad
     namespace client
     {
 
+        class LazyUsers;
+
         /**
          * @class LogipadClient
          * @brief Client for authenticating with Keycloak and managing Logipad users
@@ -78,6 +86,21 @@ namespace logipad
                  *          Optional fields are omitted if they don't have a value.
                  */
                 nlohmann::json toJson() const;
+
+                /**
+                 * @brief Read a field generically
+                 * @param field Field to read
+                 * @return Field value; boolean fields yield "true" or "false", missing
+                 *         optional fields yield no value
+                 */
+                std::optional<std::string_view> get(UserField field) const;
+
+                /**
+                 * @brief Get the member holding an optional string field
+                 * @param field Field to look up
+                 * @return Pointer to the member, or nullptr for guid and the boolean fields
+                 */
+                static std::optional<std::string> User::*optionalMember(UserField field);
             };
 
             /**
@@ -114,9 +137,10 @@ namespace logipad
 
             /**
              * @brief Authenticate and obtain access token
+             * @param call Deadline and cancellation of the request
              * @return true if authentication succeeded, false otherwise
              */
-            bool authenticate();
+            bool authenticate(const net::CallContext &call = {});
 
             /**
              * @brief Get the current access token
@@ -135,23 +159,165 @@ namespace logipad
              * @param users Reference to Users struct to populate with retrieved users
              * @param apiHost API hostname (e.g., "identity.demo.prod.logipad.net")
              * @param apiPort API port (typically 443 for HTTPS)
+             * @param fields Fields to retrieve (default: all fields)
+             * @param call Deadline and cancellation of the request
              * @return true if request succeeded and users were retrieved successfully
              * @return false if request failed, not authenticated, or JSON parsing failed
+             *         (check getLastError() for details)
              * @details Makes a GET request to the /users endpoint with Bearer token authentication.
              *          The users vector is cleared before populating with new data. Handles both
              *          array responses and object responses with nested "users" array.
+             *          A projection is sent as "fields" query parameter and also applied while
+             *          parsing; fields outside it are left empty (booleans keep their defaults).
              * @note Requires prior authentication using authenticate().
              * @warning The users parameter is cleared before population - existing data is lost.
              * @see authenticate()
              */
-            bool getAllUsers(Users &users, const std::string &apiHost, int apiPort);
+            bool getAllUsers(Users &users, const std::string &apiHost, int apiPort, const UserFieldMask &fields = UserFieldMask::all(),
+                             const net::CallContext &call = {});
+
+            /**
+             * @brief Retrieve all users without decoding them up front
+             * @param users LazyUsers container that takes ownership of the response body
+             * @param apiHost API hostname (e.g., "identity.demo.prod.logipad.net")
+             * @param apiPort API port (typically 443 for HTTPS)
+             * @param fields Fields to retrieve (default: all fields)
+             * @param call Deadline and cancellation of the request
+             * @return true if request succeeded and the response was indexed successfully
+             * @return false if request failed, not authenticated, or the response is malformed
+             *         (check getLastError() for details)
+             * @details Same request as the eager overload, but fields are only decoded when a
+             *          consumer reads them. Prefer this when only a few fields are needed.
+             * @warning The users parameter is cleared before population - existing data is lost.
+             * @see LazyUsers
+             */
+            bool getAllUsers(LazyUsers &users, const std::string &apiHost, int apiPort, const UserFieldMask &fields = UserFieldMask::all(),
+                             const net::CallContext &call = {});
+
+            /**
+             * @brief Retrieve all users unless the response is unchanged
+             * @param users Users of the previous call with the same digest; replaced if the
+             *              response changed
+             * @param digest Digest of the response users was built from (0 if none);
+             *               updated to the digest of the new response
+             * @param apiHost API hostname (e.g., "identity.demo.prod.logipad.net")
+             * @param apiPort API port (typically 443 for HTTPS)
+             * @param fields Fields to retrieve (default: all fields)
+             * @param call Deadline and cancellation of the request
+             * @return true if the request succeeded and users is up to date
+             * @return false if request failed, not authenticated, or JSON parsing failed
+             * @details Hashes the raw response body with XXH64 first. If the digest equals
+             *          the given one, the body is identical to the one users was built from,
+             *          so parsing is skipped and users is left untouched. Callers compare
+             *          the digest before and after the call to learn whether anything
+             *          changed. Useful for polling, where most responses are identical.
+             * @see io::xxh64()
+             */
+            bool refreshUsers(Users &users, std::uint64_t &digest, const std::string &apiHost, int apiPort, const UserFieldMask &fields = UserFieldMask::all(),
+                              const net::CallContext &call = {});
+
+            /**
+             * @brief Retrieve the users matching a query
+             * @param users Reference to Users struct to populate with the matching users
+             * @param query Filters, projection and paging of the request
+             * @param apiHost API hostname (e.g., "identity.demo.prod.logipad.net")
+             * @param apiPort API port (typically 443 for HTTPS)
+             * @param call Deadline and cancellation of the whole query, checked before every page
+             * @return true if every page was retrieved and parsed successfully
+             * @return false if a request failed, not authenticated, JSON parsing failed, paging
+             *         made no progress, or the call was cancelled or ran past its deadline
+             *         (check getLastError() for details)
+             * @details Filters are evaluated by the identity API, so narrow lookups only
+             *          transfer the matching users. With a page size set, all pages are
+             *          fetched in order; the next page is requested while the current one
+             *          is parsed. Both offset paging and cursor paging ("next_cursor" in
+             *          the response object) are supported.
+             * @note Requires prior authentication using authenticate().
+             * @warning The users parameter is cleared before population - existing data is lost.
+             * @see UserQuery
+             */
+            bool queryUsers(Users &users, const UserQuery &query, const std::string &apiHost, int apiPort, const net::CallContext &call = {});
+
+            /**
+             * @brief Set the connection and read timeouts of all transports
+             * @param connectTimeout Maximum time to establish a connection (default: 10 seconds)
+             * @param readTimeout Maximum time to wait for response data (default: 60 seconds)
+             * @details Upper bounds for every request; a call deadline may shorten them.
+             */
+            void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout);
+
+            /**
+             * @brief Replace the factory used to create HTTP transports
+             * @param factory Transport factory (e.g., a cassette decorator)
+             * @details Recreates the Keycloak transport and is used for every API host
+             *          transport created afterwards.
+             * @see net::cassetteTransportFactory()
+             */
+            void setTransportFactory(net::TransportFactory factory);
+
+            /**
+             * @brief Set the number of threads used to parse large user lists
+             * @param threads Number of parser threads; 0 uses all hardware threads, 1 (default)
+             *                parses on the calling thread only
+             * @details Responses of at least one megabyte are parsed in parallel chunks when
+             *          more than one thread is configured. The order of the users is preserved.
+             * @see json::ParallelUserParser
+             */
+            void setParseThreads(unsigned threads) { m_parseThreads = threads; }
+
+            /**
+             * @brief Get the HTTP status of the last user request
+             * @return Status code, or 0 if no response was received
+             */
+            int getLastStatus() const { return m_lastStatus; }
+
+            /**
+             * @brief Get the last error message
+             * @return Error message of the last failed call, empty if none was recorded
+             */
+            std::string getLastError() const { return m_lastError; }
 
         private:
+            /**
+             * @brief Fetch the raw response body of one /users request
+             * @param body Receives the response body on success
+             * @param apiClient Transport for the API host
+             * @param query Request to send
+             * @param call Deadline and cancellation of the request
+             * @return true if authenticated and the request returned HTTP 200
+             */
+            bool fetchUsers(std::string &body, net::Transport &apiClient, const UserQuery &query, const net::CallContext &call);
+
+            /**
+             * @brief Create a transport with the configured timeouts
+             * @param host Server hostname
+             * @param port Server port
+             * @return New transport from the transport factory
+             */
+            std::unique_ptr<net::Transport> createTransport(const std::string &host, int port) const;
+
+            /**
+             * @brief Parse a user list body and append the users
+             * @param body Response body
+             * @param users Vector the users are appended to
+             * @param fields Fields to decode
+             * @param error Receives the error message on failure
+             * @return true on success, false if the body is malformed
+             */
+            bool parseUsers(const std::string &body, std::vector<User> &users, const UserFieldMask &fields, std::string &error) const;
+
             std::string m_username;
             std::string m_password;
             std::string m_accessToken;
+            unsigned m_parseThreads = 1;
+            int m_lastStatus = 0;
+            std::string m_lastError;
+            bool m_projectionUnsupported = false; ///< API rejected the "fields" parameter before
+            std::chrono::milliseconds m_connectTimeout{std::chrono::seconds(10)};
+            std::chrono::milliseconds m_readTimeout{std::chrono::seconds(60)};
 
-            std::unique_ptr<httplib::SSLClient> m_httplibClient;
+            net::TransportFactory m_transportFactory;
+            std::unique_ptr<net::Transport> m_transport;
             std::unique_ptr<auth::KeycloakClient> m_keycloakClient;
         };
 
@@ -0,0 +1,66 @@
+/**
+ * @file LPParallelUserParser.hpp
+ * @brief Multi-threaded parsing of very large user list responses
+ * @details This file declares the ParallelUserParser class. It scans the top-level
+ *          user array once to find element boundaries and then parses contiguous
+ *          chunks of elements on worker threads with the JSON backend selected at
+ *          build time. Every worker writes into its own slice of a pre-sized result
+ *          vector, so the output order always matches the input order.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <LPLogipadClient.hpp>
+
+namespace logipad
+{
+    namespace json
+    {
+
+        /**
+         * @class ParallelUserParser
+         * @brief Parses user arrays on several threads while preserving element order
+         */
+        class ParallelUserParser
+        {
+        public:
+            /**
+             * @brief Construct a new ParallelUserParser
+             * @param threads Number of worker threads; 0 uses std::thread::hardware_concurrency()
+             */
+            explicit ParallelUserParser(unsigned threads = 0);
+
+            /**
+             * @brief Parse a user list response
+             * @param body Response body, either an array of users or an object with a "users" array
+             * @param users Vector the parsed users are appended to, in input order
+             * @param error Receives the first error message on failure
+             * @param fields Fields to decode; members outside the mask are skipped
+             * @return true if every element was parsed successfully
+             * @return false if the structure or any element is malformed
+             * @details Small arrays are parsed on the calling thread only.
+             * @throws std::system_error if a worker thread cannot be started; the started
+             *         workers are joined first and users is left unchanged
+             */
+            bool parse(
+                const std::string &body,
+                std::vector<client::LogipadClient::User> &users,
+                std::string &error,
+                const client::UserFieldMask &fields = client::UserFieldMask::all()) const;
+
+            /**
+             * @brief Get the number of worker threads
+             * @return Number of threads used for large arrays
+             */
+            unsigned getThreads() const { return m_threads; }
+
+        private:
+            unsigned m_threads;
+        };
+
+    } // namespace json
+} // namespace logipad
@@ -0,0 +1,127 @@
+/**
+ * @file LPPrefixIndex.hpp
+ * @brief Prefix autocomplete over usernames, three-letter codes and full names
+ * @details This file declares the PrefixIndex class, which answers typeahead lookups
+ *          against a cached directory without scanning the users. Keys are folded like
+ *          search texts (see UserSearchIndex::fold()) and kept in a front-coded
+ *          dictionary: sorted keys in buckets of 16, each bucket starting with a full
+ *          key and storing only the differing suffix of the following ones. A lookup
+ *          binary-searches the bucket heads and decodes a handful of keys, so the
+ *          first completions are found in microseconds.
+ *
+ * The dictionary is immutable; directory refreshes are applied incrementally as a
+ * small sorted overlay of new keys plus a mark on each replaced user. Once the overlay
+ * grows beyond an eighth of the dictionary, the dictionary is rebuilt.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <LPLogipadClient.hpp>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class LazyUsers;
+
+        /**
+         * @class PrefixIndex
+         * @brief Front-coded completion dictionary of a user directory
+         */
+        class PrefixIndex
+        {
+        public:
+            /**
+             * @struct Completion
+             * @brief User whose key starts with the typed prefix
+             */
+            struct Completion
+            {
+                std::size_t user = 0;              ///< Position of the user in the indexed directory
+                UserField field = UserField::Name; ///< Field whose value completes the prefix
+            };
+
+            /**
+             * @brief Get the fields the index reads
+             * @return name, three_lc and full_name
+             */
+            static UserFieldMask fields();
+
+            /**
+             * @brief Build the index of a directory
+             * @param users Users; name, three_lc and full_name are read
+             */
+            void build(const std::vector<LogipadClient::User> &users);
+
+            /**
+             * @brief Build the index of a lazily decoded directory
+             * @param users Users; only name, three_lc and full_name are decoded
+             */
+            void build(const LazyUsers &users);
+
+            /**
+             * @brief Apply a directory refresh
+             * @param users Directory after the refresh (e.g., DirectorySync::users())
+             * @param changed Positions of the users added or replaced by the refresh
+             *                (e.g., DirectorySync::getLastChanges())
+             * @details Positions of unchanged users must be the same as before. Falls back
+             *          to build() if the directory shrank or most users changed.
+             */
+            void update(const std::vector<LogipadClient::User> &users, const std::vector<std::size_t> &changed);
+
+            /**
+             * @brief Find completions of a prefix
+             * @param prefix Typed text; folded like the keys
+             * @param completions Receives at most limit users in ascending key order; a
+             *                    user matching with several fields is reported once
+             * @param limit Maximum number of completions
+             */
+            void complete(std::string_view prefix, std::vector<Completion> &completions, std::size_t limit = 10) const;
+
+            /**
+             * @brief Get the number of entries
+             * @return User keys in the dictionary and the overlay, including replaced ones
+             */
+            std::size_t size() const { return m_postings.size() + m_overlaySize; }
+
+            /**
+             * @brief Get the size of the front-coded dictionary
+             * @return Bytes of encoded keys
+             */
+            std::size_t bytes() const { return m_dictionary.size(); }
+
+        private:
+            // Postings hold the user position and the field slot
+            static constexpr std::uint32_t kSlotBits = 2;
+
+            std::string m_dictionary;            ///< Front-coded keys
+            std::vector<std::uint32_t> m_buckets; ///< Offset of every bucket in m_dictionary
+            std::size_t m_keyCount = 0;
+            std::vector<std::uint32_t> m_postingStart; ///< Per key, the first posting; one extra end entry
+            std::vector<std::uint32_t> m_postings;
+            std::vector<std::uint8_t> m_replaced; ///< Per user, dictionary postings are outdated
+
+            std::map<std::string, std::vector<std::uint32_t>, std::less<>> m_overlay;
+            std::unordered_map<std::uint32_t, std::vector<std::string>> m_overlayKeys; ///< Overlay keys per user
+            std::size_t m_overlaySize = 0;
+
+            template <typename Source>
+            void load(const Source &users, std::size_t count);
+
+            template <typename Visitor>
+            void forEachKey(std::size_t bucket, Visitor &&visit) const;
+        };
+
+    } // namespace client
+} // namespace logipad
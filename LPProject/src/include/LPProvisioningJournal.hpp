@@ -0,0 +1,159 @@
+/**
+ * @file LPProvisioningJournal.hpp
+ * @brief Write-ahead journal of bulk user provisioning
+ * @details This file declares the ProvisioningJournal class. A bulk provisioning run
+ *          records, for every roster entry, the intent to create the user before the
+ *          request is sent and the outcome after the response. Records are appended
+ *          to a buffer and made durable together by commit(), which writes the buffer
+ *          and calls fsync once (group commit).
+ *
+ * @section Format
+ * The file starts with the magic "LPJRN001", followed by records:
+ * - u32 body length, u32 checksum (low half of the FNV-1a hash of the body), body
+ * - body: kind byte, then
+ *   - Begin (1): u64 roster fingerprint, varint roster size, u32-length-prefixed realm
+ *   - Intent (2): varint roster index
+ *   - Outcome (3): varint roster index, result byte, varint HTTP status,
+ *     u32-length-prefixed message
+ *
+ * An incomplete or corrupt tail (interrupted write) is cut off when the file is opened.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <LPKeyCloakClient.hpp>
+
+namespace logipad
+{
+    namespace auth
+    {
+
+        /**
+         * @class ProvisioningJournal
+         * @brief Append-only log of provisioning intents and outcomes
+         */
+        class ProvisioningJournal
+        {
+        public:
+            /**
+             * @brief State of a roster entry
+             */
+            enum class State : std::uint8_t
+            {
+                None,     ///< Not attempted
+                Intended, ///< Request may have been sent, outcome unknown
+                Created,  ///< User created (HTTP 201)
+                Existed,  ///< User already existed (HTTP 409)
+                Failed    ///< Rejected locally or by Keycloak
+            };
+
+            /**
+             * @struct Entry
+             * @brief Journaled state of one roster entry
+             */
+            struct Entry
+            {
+                State state = State::None; ///< Latest recorded state
+                int status = 0;            ///< HTTP status of the outcome, 0 if none was received
+                std::string message;       ///< Error message of a failed outcome
+            };
+
+            ProvisioningJournal() = default;
+            ProvisioningJournal(const ProvisioningJournal &) = delete;
+            ProvisioningJournal &operator=(const ProvisioningJournal &) = delete;
+
+            /**
+             * @brief Destructor; commits pending records and closes the file
+             */
+            ~ProvisioningJournal();
+
+            /**
+             * @brief Open a journal
+             * @param path Journal file path
+             * @param truncate Start a new journal even if the file exists
+             * @return true on success, false if the file cannot be read, created or is
+             *         not a journal (see getLastError())
+             * @details An existing journal is replayed into entries().
+             */
+            bool open(const std::string &path, bool truncate);
+
+            /**
+             * @brief Bind the journal to a roster
+             * @param fingerprint Fingerprint of the roster (see fingerprint())
+             * @param size Number of roster entries
+             * @param realm Target realm
+             * @return true if the journal is new or was written for the same roster and
+             *         realm, false otherwise (see getLastError())
+             */
+            bool begin(std::uint64_t fingerprint, std::size_t size, const std::string &realm);
+
+            /**
+             * @brief Record that a user is about to be created
+             * @param index Roster index
+             */
+            void intent(std::size_t index);
+
+            /**
+             * @brief Record the outcome of a create request
+             * @param index Roster index
+             * @param state Created, Existed or Failed
+             * @param status HTTP status, 0 if none was received
+             * @param message Error message, empty on success
+             */
+            void outcome(std::size_t index, State state, int status, const std::string &message);
+
+            /**
+             * @brief Write the pending records and sync them to disk
+             * @return true on success, false if writing or syncing failed (see getLastError())
+             */
+            bool commit();
+
+            /**
+             * @brief Get the journaled state of every roster entry
+             * @return Entries by roster index, including pending records
+             */
+            const std::vector<Entry> &entries() const { return m_entries; }
+
+            /**
+             * @brief Get the number of records not yet committed
+             * @return Pending records
+             */
+            std::size_t pending() const { return m_pending; }
+
+            /**
+             * @brief Fingerprint a roster
+             * @param roster Users to be created
+             * @return XXH64 of the usernames and emails in roster order
+             */
+            static std::uint64_t fingerprint(const std::vector<KeycloakClient::UserInfo> &roster);
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            void append(const std::string &body);
+            bool replay(const std::string &body);
+
+            std::string m_path;
+            std::FILE *m_file = nullptr;
+            std::string m_buffer; ///< Encoded records not yet written
+            std::size_t m_pending = 0;
+            bool m_begun = false;
+            std::uint64_t m_fingerprint = 0;
+            std::string m_realm;
+            std::vector<Entry> m_entries;
+            std::string m_lastError;
+        };
+
+    } // namespace auth
+} // namespace logipad
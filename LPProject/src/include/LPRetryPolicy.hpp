@@ -0,0 +1,49 @@
+/**
+ * @file LPRetryPolicy.hpp
+ * @brief Retry policy with exponential backoff for transient request failures
+ * @details This file declares the RetryPolicy struct. It decides which HTTP outcomes
+ *          are worth retrying (no response, 408, 429 and 5xx) and how long to wait
+ *          before each retry: the delay doubles per attempt up to a cap, and half of
+ *          it is randomized so that many clients do not retry in lockstep.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <chrono>
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @struct RetryPolicy
+         * @brief Number of attempts and backoff between them
+         */
+        struct RetryPolicy
+        {
+            int maxAttempts = 3;                         ///< Attempts including the first one; 1 disables retries
+            std::chrono::milliseconds initialDelay{500}; ///< Delay before the first retry
+            double multiplier = 2.0;                     ///< Growth of the delay per retry
+            std::chrono::milliseconds maxDelay{30000};   ///< Upper bound of the delay
+            bool jitter = true;                          ///< Randomize the upper half of every delay
+
+            /**
+             * @brief Get the delay before a retry
+             * @param attempt Number of the attempt that just failed (1 for the first)
+             * @return Time to wait before the next attempt
+             */
+            std::chrono::milliseconds delay(int attempt) const;
+
+            /**
+             * @brief Check whether an outcome is transient
+             * @param status HTTP status, 0 if no response was received
+             * @return true for 0, 408, 429 and 5xx
+             */
+            static bool isRetryable(int status);
+        };
+
+    } // namespace net
+} // namespace logipad
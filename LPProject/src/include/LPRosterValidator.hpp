@@ -0,0 +1,125 @@
+/**
+ * @file LPRosterValidator.hpp
+ * @brief Local validation of provisioning rosters
+ * @details This file declares the RosterValidator class. It checks every
+ *          KeycloakClient::UserInfo of a roster without any network access, in
+ *          parallel, and returns all problems at once: username characters and
+ *          length, email syntax, required names and password, and duplicate emails or
+ *          usernames within the roster (optionally also against known tenant
+ *          directories).
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <LPKeyCloakClient.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+        class DuplicateDetector;
+    } // namespace client
+
+    namespace auth
+    {
+
+        /**
+         * @class RosterValidator
+         * @brief Pre-validates users before they are created in Keycloak
+         */
+        class RosterValidator
+        {
+        public:
+            /**
+             * @brief UserInfo member an issue refers to
+             */
+            enum class Field
+            {
+                Username,
+                Email,
+                FirstName,
+                LastName,
+                Password
+            };
+
+            /**
+             * @struct Issue
+             * @brief One validation error
+             */
+            struct Issue
+            {
+                std::size_t row = 0;            ///< Index of the user in the roster
+                Field field = Field::Username;  ///< Offending member
+                std::string message;            ///< Human-readable description
+            };
+
+            /**
+             * @struct Options
+             * @brief Validation limits
+             */
+            struct Options
+            {
+                std::size_t maxUsernameLength = 255; ///< Keycloak's column limit
+                std::size_t maxNameLength = 255;     ///< Limit of first and last name
+                std::size_t minPasswordLength = 1;   ///< Shortest accepted initial password
+                unsigned threads = 0;                ///< Checking threads; 0 uses all hardware threads
+            };
+
+            /**
+             * @brief Construct a new RosterValidator
+             * @param options Validation limits
+             */
+            explicit RosterValidator(const Options &options);
+
+            /**
+             * @brief Construct a RosterValidator with default limits
+             */
+            RosterValidator();
+
+            /**
+             * @brief Validate a roster
+             * @param roster Users to be created
+             * @param issues Receives all issues, ordered by row and field
+             * @param known Optional detector holding existing tenant directories; collisions with
+             *              them are reported as well
+             * @return true if no issue was found
+             */
+            bool validate(const std::vector<KeycloakClient::UserInfo> &roster, std::vector<Issue> &issues, const client::DuplicateDetector *known = nullptr) const;
+
+            /**
+             * @brief Validate a single user (no duplicate check)
+             * @param user User to be created
+             * @param issues Receives the issues of the user (row 0)
+             * @return true if no issue was found
+             */
+            bool validate(const KeycloakClient::UserInfo &user, std::vector<Issue> &issues) const;
+
+            /**
+             * @brief Check the syntax of an email address
+             * @param email Address to check
+             * @return true for a dot-atom local part (at most 64 bytes) and a host name domain
+             *         with at least two labels and an alphabetic top-level label
+             */
+            static bool isValidEmail(std::string_view email);
+
+            /**
+             * @brief Get the name of a field
+             * @param field Field
+             * @return UserInfo member name (e.g., "firstName")
+             */
+            static const char *fieldName(Field field);
+
+        private:
+            Options m_options;
+
+            void check(const KeycloakClient::UserInfo &user, std::size_t row, std::vector<Issue> &issues) const;
+        };
+
+    } // namespace auth
+} // namespace logipad
@@ -0,0 +1,182 @@
+/**
+ * @file LPTransport.hpp
+ * @brief HTTP transport abstraction shared by all Logipad clients
+ * @details This file contains the declaration of the Transport interface and its
+ *          default HTTPS implementation. Both KeycloakClient and LogipadClient send
+ *          every request through a Transport, so decorators (for example recording
+ *          or replaying exchanges) can be stacked without touching the clients.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <httplib.h>
+#include <LPCancellation.hpp>
+
+/**
+ * @namespace logipad::net
+ * @brief HTTP transport layer and transport decorators
+ */
+
+namespace logipad
+{
+    namespace net
+    {
+
+        /**
+         * @struct Request
+         * @brief Transport-neutral description of a single HTTP request
+         * @details Holds everything a Transport needs to perform the request. The
+         *          static helpers mirror the httplib calls the clients used before
+         *          the transport layer existed.
+         */
+        struct Request
+        {
+            std::string method;       ///< HTTP method ("GET", "POST", ...)
+            std::string path;         ///< Request path including the query string
+            httplib::Headers headers; ///< Request headers
+            std::string body;         ///< Request body, empty for GET requests
+            std::string contentType;  ///< Content type of the body, empty if there is no body
+            CallContext context;      ///< Deadline and cancellation of the operation the request belongs to
+
+            /**
+             * @brief Build a GET request
+             * @param path Request path including the query string
+             * @param headers Request headers
+             * @return Request with method "GET"
+             */
+            static Request get(const std::string &path, const httplib::Headers &headers = {});
+
+            /**
+             * @brief Build a POST request with a raw body
+             * @param path Request path
+             * @param headers Request headers
+             * @param body Request body
+             * @param contentType Content type of the body (e.g., "application/json")
+             * @return Request with method "POST"
+             */
+            static Request post(
+                const std::string &path,
+                const httplib::Headers &headers,
+                const std::string &body,
+                const std::string &contentType);
+
+            /**
+             * @brief Build a form-encoded POST request
+             * @param path Request path
+             * @param params Form parameters, encoded as application/x-www-form-urlencoded
+             * @return Request with method "POST"
+             * @details Equivalent to httplib's Post(path, params) overload.
+             */
+            static Request postForm(const std::string &path, const httplib::Params &params);
+        };
+
+        /**
+         * @class Transport
+         * @brief Abstract HTTP transport bound to one host and port
+         * @details A Transport performs requests against a single endpoint and returns
+         *          the httplib::Result, so client code can inspect responses exactly as
+         *          it did with a plain httplib client.
+         * @warning A Transport performs one request at a time and must not be used from
+         *          several threads concurrently: send() applies the timeouts of each
+         *          request to the shared connection. Concurrent requests need a transport
+         *          each, as HedgingTransport does for its second attempt.
+         */
+        class Transport
+        {
+        public:
+            /**
+             * @brief Virtual destructor
+             */
+            virtual ~Transport() = default;
+
+            /**
+             * @brief Perform a request
+             * @param request Request to send
+             * @return httplib::Result holding the response, or the error if none was received
+             * @details Implementations answer httplib::Error::Canceled without a response if
+             *          Request::context is stopped before or while the request is performed.
+             */
+            virtual httplib::Result send(const Request &request) = 0;
+
+            /**
+             * @brief Set connection and read timeouts for subsequent requests
+             * @param connectTimeout Maximum time to establish the connection
+             * @param readTimeout Maximum time to wait for response data
+             */
+            virtual void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout) = 0;
+
+            /**
+             * @brief Get the endpoint this transport talks to
+             * @return Endpoint in the form "host:port"
+             */
+            virtual std::string endpoint() const = 0;
+        };
+
+        /**
+         * @brief Get the content codings this build can decompress
+         * @return Value for the Accept-Encoding header (e.g. "br, gzip, deflate"), empty if
+         *         httplib was built without zlib and brotli support
+         */
+        std::string acceptEncoding();
+
+        /**
+         * @class HttpTransport
+         * @brief Default Transport backed by httplib::SSLClient
+         * @details Requests advertise acceptEncoding() unless the caller sets
+         *          Accept-Encoding itself. Compressed responses are decompressed by httplib
+         *          chunk by chunk while they are received, so the body handed to the
+         *          parsers is always plain JSON.
+         *
+         * The configured timeouts are clamped to the time left until the deadline of the
+         * request. Cancelling its token shuts the socket down from the cancelling thread,
+         * so a blocked send() returns at once.
+         */
+        class HttpTransport : public Transport
+        {
+        public:
+            /**
+             * @brief Construct a new HttpTransport
+             * @param host Server hostname
+             * @param port Server port (typically 443 for HTTPS)
+             */
+            HttpTransport(const std::string &host, int port);
+
+            /**
+             * @brief Destructor
+             */
+            ~HttpTransport() override;
+
+            httplib::Result send(const Request &request) override;
+            void setTimeouts(std::chrono::milliseconds connectTimeout, std::chrono::milliseconds readTimeout) override;
+            std::string endpoint() const override;
+
+        private:
+            std::string m_host;
+            int m_port;
+            std::unique_ptr<httplib::SSLClient> m_client;
+            std::string m_acceptEncoding;
+            std::chrono::milliseconds m_connectTimeout;
+            std::chrono::milliseconds m_readTimeout;
+        };
+
+        /**
+         * @brief Factory creating a Transport for a host and port
+         * @details Clients create all their transports through a factory, which is the
+         *          extension point used to install transport decorators.
+         */
+        using TransportFactory = std::function<std::unique_ptr<Transport>(const std::string &host, int port)>;
+
+        /**
+         * @brief Get the default factory creating HttpTransport instances
+         * @return TransportFactory producing HttpTransport objects
+         */
+        TransportFactory httpTransportFactory();
+
+    } // namespace net
+} // namespace logipad
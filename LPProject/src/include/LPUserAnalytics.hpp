@@ -0,0 +1,129 @@
+/**
+ * @file LPUserAnalytics.hpp
+ * @brief Inactive-user and license analytics over a columnar user table
+ * @details This file declares the UserAnalytics class. It computes, in a single
+ *          pass over the epoch columns of a UserTable, how many users have been
+ *          inactive for longer than a set of thresholds, how many users were active
+ *          per service (document, eForm, briefing) and the same figures broken down
+ *          by department. Users whose is_reportable flag is false are left out of
+ *          every figure, as they are for license counting.
+ *
+ * A user's last activity is the latest of last_login_at, last_activity_at and the
+ * three per-service activity timestamps. Users without any of them count as never
+ * seen and are inactive for every threshold.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class UserTable;
+
+        /**
+         * @class UserAnalytics
+         * @brief Computes activity and license figures for a tenant
+         */
+        class UserAnalytics
+        {
+        public:
+            /// Number of per-service activity fields (document, eForm, briefing)
+            static constexpr std::size_t kServiceCount = 3;
+
+            /**
+             * @struct Options
+             * @brief Analysis settings
+             */
+            struct Options
+            {
+                std::vector<std::int64_t> thresholds = {30 * 86400, 90 * 86400, 180 * 86400, 365 * 86400}; ///< Inactivity thresholds in seconds
+                std::int64_t serviceWindow = 30 * 86400; ///< A service counts a user as active if used within this many seconds
+                bool byDepartment = true;                ///< Compute the per-department breakdown
+            };
+
+            /**
+             * @struct Counts
+             * @brief Figures for one group of reportable users
+             */
+            struct Counts
+            {
+                std::size_t users = 0;                       ///< Reportable users
+                std::size_t active = 0;                      ///< Users with is_active set (license holders)
+                std::size_t neverSeen = 0;                   ///< Users without any activity timestamp
+                std::vector<std::size_t> inactive;           ///< Users inactive longer than each threshold
+                std::array<std::size_t, kServiceCount> serviceActive{}; ///< Users active per service within the window
+            };
+
+            /**
+             * @struct Report
+             * @brief Result of an analysis
+             */
+            struct Report
+            {
+                std::int64_t now = 0;                               ///< Reference time in seconds since the Unix epoch
+                std::vector<std::int64_t> thresholds;              ///< Thresholds of Counts::inactive
+                std::size_t excluded = 0;                           ///< Users skipped because they are not reportable
+                Counts total;                                       ///< Figures over all reportable users
+                std::vector<std::pair<std::string, Counts>> departments; ///< Figures per department, sorted by name; "" collects users without department
+            };
+
+            /**
+             * @brief Construct a new UserAnalytics
+             * @param options Analysis settings
+             */
+            explicit UserAnalytics(const Options &options);
+
+            /**
+             * @brief Get the fields the analysis reads
+             * @return Activity timestamps, is_active, is_reportable and department
+             */
+            static UserFieldMask fields();
+
+            /**
+             * @brief Analyze a table
+             * @param table Table containing at least fields()
+             * @param report Receives the figures
+             * @param now Reference time in seconds since the Unix epoch
+             * @return true on success, false if a column is missing (see getLastError())
+             */
+            bool analyze(const UserTable &table, Report &report, std::int64_t now) const;
+
+            /**
+             * @brief Analyze a table relative to the current time
+             * @param table Table containing at least fields()
+             * @param report Receives the figures
+             * @return true on success, false if a column is missing (see getLastError())
+             */
+            bool analyze(const UserTable &table, Report &report) const;
+
+            /**
+             * @brief Format a report as a fixed-width text table
+             * @param report Report to format
+             * @return One header line and one line per group (total first, then departments)
+             */
+            static std::string format(const Report &report);
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            Options m_options;
+            mutable std::string m_lastError;
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,134 @@
+/**
+ * @file LPUserExporter.hpp
+ * @brief Streaming export of user directories to CSV, NDJSON and a binary row format
+ * @details This file declares the UserExporter class. Users are formatted in chunks
+ *          of rows, optionally on several threads and optionally gzip-compressed per
+ *          chunk, and the chunks are written in input order through one large
+ *          buffered file stream. The exported fields follow the User::toJson() field
+ *          set, restricted by a UserFieldMask.
+ *
+ * @section Formats
+ * - CSV: header row with the JSON field names, RFC 4180 quoting, missing fields empty
+ * - NDJSON: one JSON object per line, with the same members as User::toJson()
+ * - Binary: magic "LPUSR001", u32 field count, field names (u32-length-prefixed),
+ *   then per user a u32 bitmap over the exported fields (present strings, or the
+ *   value of boolean fields) followed by every present string as LEB128 length
+ *   and bytes; all integers little-endian
+ *
+ * With gzip enabled each chunk is an independent gzip member; concatenated members
+ * form a valid gzip file (RFC 1952) that gunzip and zlib read as one stream.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <LPLogipadClient.hpp>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class LazyUsers;
+
+        /**
+         * @enum ExportFormat
+         * @brief Output formats of UserExporter
+         */
+        enum class ExportFormat
+        {
+            Csv,    ///< Comma-separated values with header row
+            NdJson, ///< Newline-delimited JSON
+            Binary  ///< Compact binary rows
+        };
+
+        /**
+         * @brief Look up an export format by name
+         * @param name "csv", "ndjson" or "binary"
+         * @param format Receives the format
+         * @return true if the name is known
+         */
+        bool exportFormatFromName(std::string_view name, ExportFormat &format);
+
+        /**
+         * @class UserExporter
+         * @brief Writes user lists in one of the export formats
+         */
+        class UserExporter
+        {
+        public:
+            /**
+             * @struct Options
+             * @brief Export settings
+             */
+            struct Options
+            {
+                ExportFormat format = ExportFormat::Csv;     ///< Output format
+                UserFieldMask fields = UserFieldMask::all(); ///< Exported fields, in UserField order
+                bool gzip = false;                           ///< Compress the output (requires zlib)
+                unsigned threads = 1;                        ///< Formatting threads; 0 uses all hardware threads
+                std::size_t rowsPerChunk = 4096;             ///< Rows formatted (and compressed) as one unit
+            };
+
+            /**
+             * @brief Construct a new UserExporter
+             * @param options Export settings
+             */
+            explicit UserExporter(const Options &options);
+
+            /**
+             * @brief Check whether gzip output is available in this build
+             * @return true if httplib was built with zlib support
+             */
+            static bool gzipSupported();
+
+            /**
+             * @brief Export users to a file
+             * @param users Users to export
+             * @param path Output file path; "-" writes to standard output
+             * @return true on success
+             * @return false on I/O errors or if gzip is requested but unsupported
+             */
+            bool exportToFile(const std::vector<LogipadClient::User> &users, const std::string &path);
+
+            /**
+             * @brief Export lazily decoded users to a file
+             * @param users Users to export; only the exported fields are decoded
+             * @param path Output file path; "-" writes to standard output
+             * @return true on success
+             * @return false on I/O errors or if gzip is requested but unsupported
+             */
+            bool exportToFile(const LazyUsers &users, const std::string &path);
+
+            /**
+             * @brief Get the number of bytes written by the last export
+             * @return Bytes written, after compression
+             */
+            std::size_t getBytesWritten() const { return m_bytesWritten; }
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            Options m_options;
+            std::size_t m_bytesWritten = 0;
+            std::string m_lastError;
+
+            template <typename Source>
+            bool run(const Source &users, const std::string &path);
+
+            std::string header() const;
+            bool compress(std::string &chunk) const;
+        };
+
+    } // namespace client
+} // namespace logipad
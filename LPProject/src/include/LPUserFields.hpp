@@ -0,0 +1,174 @@
+/**
+ * @file LPUserFields.hpp
+ * @brief Enumeration of the fields of a Logipad user record
+ * @details This file declares the UserField enumeration together with helpers to
+ *          convert between fields and their JSON names. It is used wherever user
+ *          fields are addressed generically instead of through the User members.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        /**
+         * @enum UserField
+         * @brief Fields of LogipadClient::User in declaration order
+         */
+        enum class UserField : std::uint8_t
+        {
+            Guid,                        ///< "guid"
+            CreatedAt,                   ///< "created_at"
+            CreatedBy,                   ///< "created_by"
+            ModifiedAt,                  ///< "modified_at"
+            ModifiedBy,                  ///< "modified_by"
+            LastLoginAt,                 ///< "last_login_at"
+            LastActivityAt,              ///< "last_activity_at"
+            LastDocumentServiceActivity, ///< "last_document_service_activity"
+            LastEformServiceActivity,    ///< "last_eform_service_activity"
+            LastBriefingServiceActivity, ///< "last_briefing_service_activity"
+            Name,                        ///< "name"
+            Type,                        ///< "type"
+            FullName,                    ///< "full_name"
+            Email,                       ///< "email"
+            ThreeLc,                     ///< "three_lc"
+            Department,                  ///< "department"
+            Description,                 ///< "description"
+            IsActive,                    ///< "is_active"
+            IsReportable                 ///< "is_reportable"
+        };
+
+        /**
+         * @brief Number of values in UserField
+         */
+        constexpr std::size_t kUserFieldCount = 19;
+
+        /**
+         * @brief Get the JSON name of a field
+         * @param field User field
+         * @return JSON key as used by the identity API (e.g., "last_login_at")
+         */
+        const char *userFieldName(UserField field);
+
+        /**
+         * @brief Look up a field by its JSON name
+         * @param name JSON key (e.g., "email")
+         * @param field Receives the field if found
+         * @return true if name denotes a user field, false otherwise
+         */
+        bool userFieldFromName(std::string_view name, UserField &field);
+
+        /**
+         * @brief Check whether a field holds a boolean
+         * @param field User field
+         * @return true for is_active and is_reportable, false for string fields
+         */
+        inline bool isBooleanField(UserField field)
+        {
+            return field == UserField::IsActive || field == UserField::IsReportable;
+        }
+
+        /**
+         * @class UserFieldMask
+         * @brief Set of user fields to retrieve
+         * @details Used to project user retrieval onto the fields a consumer needs. Fields
+         *          outside the mask are skipped while parsing and never materialized.
+         */
+        class UserFieldMask
+        {
+        public:
+            /**
+             * @brief Construct an empty mask
+             */
+            UserFieldMask() = default;
+
+            /**
+             * @brief Construct a mask from a list of fields
+             * @param fields Fields to include (e.g., {UserField::Guid, UserField::Email})
+             */
+            UserFieldMask(std::initializer_list<UserField> fields)
+            {
+                for (UserField field : fields)
+                {
+                    add(field);
+                }
+            }
+
+            /**
+             * @brief Get a mask containing every field
+             * @return Mask selecting all fields
+             */
+            static UserFieldMask all()
+            {
+                UserFieldMask mask;
+                mask.m_bits = (1u << kUserFieldCount) - 1;
+                return mask;
+            }
+
+            /**
+             * @brief Parse a comma-separated list of JSON field names
+             * @param names List such as "guid,email,last_login_at"
+             * @param mask Receives the parsed mask
+             * @return true on success, false if a name is not a user field
+             */
+            static bool fromNames(std::string_view names, UserFieldMask &mask);
+
+            /**
+             * @brief Add a field to the mask
+             * @param field Field to add
+             * @return Reference to this mask
+             */
+            UserFieldMask &add(UserField field)
+            {
+                m_bits |= 1u << static_cast<unsigned>(field);
+                return *this;
+            }
+
+            /**
+             * @brief Check whether a field is selected
+             * @param field Field to check
+             * @return true if the field is part of the mask
+             */
+            bool contains(UserField field) const { return (m_bits >> static_cast<unsigned>(field)) & 1u; }
+
+            /**
+             * @brief Check whether every field is selected
+             * @return true if the mask selects all fields
+             */
+            bool isAll() const { return m_bits == all().m_bits; }
+
+            /**
+             * @brief Check whether no field is selected
+             * @return true if the mask is empty
+             */
+            bool empty() const { return m_bits == 0; }
+
+            /**
+             * @brief Format the mask as a comma-separated list of JSON field names
+             * @return Field list in UserField order (e.g., "guid,email,last_login_at")
+             */
+            std::string toNames() const;
+
+            /**
+             * @brief List the selected fields
+             * @return Selected fields in UserField order
+             */
+            std::vector<UserField> toFields() const;
+
+        private:
+            std::uint32_t m_bits = 0;
+        };
+
+    } // namespace client
+} // namespace logipad
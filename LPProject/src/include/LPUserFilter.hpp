@@ -0,0 +1,164 @@
+/**
+ * @file LPUserFilter.hpp
+ * @brief Compiled filter expressions over a columnar user table
+ * @details This file declares the UserFilter class. A filter expression is parsed
+ *          once into a flat postfix program of column predicates and boolean
+ *          operators, which is then evaluated over a UserTable in batches of rows.
+ *          The same compiled filter can be applied to the tables of many tenants.
+ *
+ * @section Syntax
+ * @code
+ * expr       := and ( "||" and )*
+ * and        := unary ( "&&" unary )*
+ * unary      := "!" unary | "(" expr ")" | operand [ op operand ]
+ * op         := "==" | "!=" | "<" | "<=" | ">" | ">="
+ * operand    := field | "string" | true | false | now [ ("+"|"-") duration ]*
+ * duration   := number ( "s" | "m" | "h" | "d" | "w" )
+ * @endcode
+ *
+ * - A boolean field on its own tests for true (`is_active`, `!is_reportable`)
+ * - Any other field on its own tests for presence (`last_login_at`)
+ * - Text fields compare byte-wise against string literals
+ * - Timestamp fields compare as points in time against `now`-relative values,
+ *   ISO 8601 string literals or other timestamp fields
+ * - A comparison involving a missing value is false for every operator, including `!=`
+ *
+ * Example: `is_active && department == "Flight Ops" && last_login_at < now-90d`
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class UserTable;
+
+        /**
+         * @class UserFilter
+         * @brief Filter expression compiled into a predicate program
+         */
+        class UserFilter
+        {
+        public:
+            /// Rows evaluated per batch
+            static constexpr std::size_t kBatchRows = 1024;
+
+            /**
+             * @brief Compile a filter expression
+             * @param expression Expression text (see file description for the syntax)
+             * @return true on success, false on syntax or type errors (see getLastError())
+             */
+            bool compile(std::string_view expression);
+
+            /**
+             * @brief Get the fields the filter reads
+             * @return Referenced fields, suitable as request projection and table columns
+             */
+            const UserFieldMask &fields() const { return m_fields; }
+
+            /**
+             * @brief Select the matching rows of a table
+             * @param table Table containing at least fields()
+             * @param rows Receives the matching row indices in ascending order
+             * @param now Reference time for `now` in seconds since the Unix epoch
+             * @return true on success, false if no filter is compiled or a column is missing
+             */
+            bool evaluate(const UserTable &table, std::vector<std::uint32_t> &rows, std::int64_t now) const;
+
+            /**
+             * @brief Select the matching rows of a table relative to the current time
+             * @param table Table containing at least fields()
+             * @param rows Receives the matching row indices in ascending order
+             * @return true on success, false if no filter is compiled or a column is missing
+             */
+            bool evaluate(const UserTable &table, std::vector<std::uint32_t> &rows) const;
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+            /**
+             * @brief Comparison operator of a predicate
+             */
+            enum class Compare
+            {
+                Eq,
+                Ne,
+                Lt,
+                Le,
+                Gt,
+                Ge
+            };
+
+            /**
+             * @struct Term
+             * @brief Column predicate of a compiled filter
+             */
+            struct Term
+            {
+                /**
+                 * @brief Predicate kind
+                 */
+                enum class Kind
+                {
+                    Flag,     ///< Boolean field equals flag
+                    Present,  ///< Field is present
+                    Text,     ///< Text field compared with text
+                    Time,     ///< Timestamp field compared with a point in time
+                    TimeField ///< Timestamp field compared with another timestamp field
+                };
+
+                Kind kind = Kind::Present;
+                UserField field = UserField::Guid;
+                UserField other = UserField::Guid; ///< Right-hand field of TimeField
+                Compare op = Compare::Eq;
+                std::string text;       ///< Right-hand value of Text
+                std::int64_t value = 0; ///< Right-hand seconds of Time
+                bool relative = false;  ///< value is an offset from now
+                bool flag = true;       ///< Expected value of Flag
+            };
+
+            /**
+             * @struct Instruction
+             * @brief Step of the postfix program
+             */
+            struct Instruction
+            {
+                /**
+                 * @brief Operation
+                 */
+                enum class Op
+                {
+                    Term, ///< Push the row mask of terms[term]
+                    And,  ///< Pop two masks, push their conjunction
+                    Or,   ///< Pop two masks, push their disjunction
+                    Not   ///< Invert the top mask
+                };
+
+                Op op = Op::Term;
+                std::size_t term = 0;
+            };
+
+        private:
+            std::vector<Term> m_terms;
+            std::vector<Instruction> m_program;
+            std::size_t m_depth = 0; ///< Maximum mask stack depth
+            UserFieldMask m_fields;
+            mutable std::string m_lastError;
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,114 @@
+/**
+ * @file LPUserListing.hpp
+ * @brief Fast tabular console listing of users
+ * @details This file declares the UserListing class used by the list-users command.
+ *          The whole table is rendered into one large buffer that is written in a
+ *          few big writes instead of flushing after every line, so listing a large
+ *          tenant is limited by terminal or pipe bandwidth only.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <LPLogipadClient.hpp>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class LazyUsers;
+        class UserTable;
+
+        /**
+         * @class UserListing
+         * @brief Renders users as a fixed-width or tab-separated table
+         */
+        class UserListing
+        {
+        public:
+            /**
+             * @brief Table layout
+             */
+            enum class Layout
+            {
+                Fixed, ///< Columns padded to their widest value, separated by two spaces
+                Tsv    ///< Tab-separated; tabs and line breaks inside values are escaped
+            };
+
+            /**
+             * @struct Options
+             * @brief Listing settings
+             */
+            struct Options
+            {
+                std::vector<UserField> columns = {UserField::Guid, UserField::Name, UserField::Email}; ///< Columns in output order
+                Layout layout = Layout::Fixed;   ///< Table layout
+                std::optional<UserField> sortBy; ///< Sort field; input order if unset
+                bool descending = false;         ///< Reverse the sort order
+                bool header = true;              ///< Print a header row with the field names
+            };
+
+            /**
+             * @brief Construct a new UserListing
+             * @param options Listing settings
+             */
+            explicit UserListing(const Options &options);
+
+            /**
+             * @brief Parse a comma-separated column list
+             * @param names JSON field names (e.g., "guid,email,last_login_at")
+             * @param columns Receives the columns in the given order
+             * @return true if all names are known fields
+             */
+            static bool columnsFromNames(std::string_view names, std::vector<UserField> &columns);
+
+            /**
+             * @brief Get the fields the listing reads
+             * @return Columns plus the sort field, suitable as request projection
+             */
+            UserFieldMask fields() const;
+
+            /**
+             * @brief Write a user list
+             * @param users Users to list
+             * @param out Output stream (e.g., stdout)
+             * @return true on success, false if writing failed
+             */
+            bool write(const std::vector<LogipadClient::User> &users, std::FILE *out) const;
+
+            /**
+             * @brief Write a lazily decoded user list
+             * @param users Users to list; only the listed fields are decoded
+             * @param out Output stream (e.g., stdout)
+             * @return true on success, false if writing failed
+             */
+            bool write(const LazyUsers &users, std::FILE *out) const;
+
+            /**
+             * @brief Write selected rows of a columnar table
+             * @param users Table containing at least fields()
+             * @param rows Row indices to list (e.g., the result of a UserFilter)
+             * @param out Output stream (e.g., stdout)
+             * @return true on success, false if writing failed
+             */
+            bool write(const UserTable &users, const std::vector<std::uint32_t> &rows, std::FILE *out) const;
+
+        private:
+            Options m_options;
+
+            template <typename Source>
+            bool render(const Source &users, std::size_t count, std::FILE *out) const;
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,130 @@
+/**
+ * @file LPUserQuery.hpp
+ * @brief Builder for filtered and paged user list requests
+ * @details This file declares the UserQuery class. A query describes which users the
+ *          identity API should return (server-side filters), which fields to include
+ *          and how to page through the result. It renders to the request path of the
+ *          /users endpoint; LogipadClient::queryUsers() executes it.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        /**
+         * @class UserQuery
+         * @brief Fluent description of a /users request
+         * @details Setters return the query itself so they can be chained:
+         * @code
+         * auto query = UserQuery().active(true).department("Flight Ops").pageSize(500);
+         * @endcode
+         *          Filters that are not set are not sent. Without a page size the whole
+         *          result is requested at once.
+         */
+        class UserQuery
+        {
+        public:
+            /**
+             * @brief Only return users with the given is_active flag
+             * @param active Required value of is_active
+             * @return Reference to this query
+             */
+            UserQuery &active(bool active);
+
+            /**
+             * @brief Only return users modified at or after a point in time
+             * @param timestamp ISO 8601 timestamp, as used by the modified_at field
+             * @return Reference to this query
+             */
+            UserQuery &modifiedSince(const std::string &timestamp);
+
+            /**
+             * @brief Only return users of a department
+             * @param department Department name
+             * @return Reference to this query
+             */
+            UserQuery &department(const std::string &department);
+
+            /**
+             * @brief Only return users of a type
+             * @param type User type
+             * @return Reference to this query
+             */
+            UserQuery &type(const std::string &type);
+
+            /**
+             * @brief Restrict the returned fields
+             * @param fields Projection sent as "fields" parameter
+             * @return Reference to this query
+             */
+            UserQuery &fields(const UserFieldMask &fields);
+
+            /**
+             * @brief Enable paging
+             * @param limit Maximum number of users per request; 0 disables paging
+             * @return Reference to this query
+             */
+            UserQuery &pageSize(std::size_t limit);
+
+            /**
+             * @brief Start at an offset into the result
+             * @param offset Number of users to skip
+             * @return Reference to this query
+             */
+            UserQuery &offset(std::size_t offset);
+
+            /**
+             * @brief Continue from a server-issued cursor
+             * @param cursor Value of "next_cursor" from a previous page; replaces the offset
+             * @return Reference to this query
+             */
+            UserQuery &cursor(const std::string &cursor);
+
+            /**
+             * @brief Get the field projection
+             * @return Selected fields
+             */
+            const UserFieldMask &getFields() const { return m_fields; }
+
+            /**
+             * @brief Get the page size
+             * @return Users per request, 0 if paging is disabled
+             */
+            std::size_t getPageSize() const { return m_limit; }
+
+            /**
+             * @brief Get the offset
+             * @return Number of users skipped
+             */
+            std::size_t getOffset() const { return m_offset; }
+
+            /**
+             * @brief Render the request path
+             * @param withFields Whether to include the "fields" parameter
+             * @return Path of the /users endpoint including the encoded query string
+             */
+            std::string toPath(bool withFields = true) const;
+
+        private:
+            std::optional<bool> m_active;
+            std::optional<std::string> m_modifiedSince;
+            std::optional<std::string> m_department;
+            std::optional<std::string> m_type;
+            std::optional<std::string> m_cursor;
+            UserFieldMask m_fields = UserFieldMask::all();
+            std::size_t m_limit = 0;
+            std::size_t m_offset = 0;
+        };
+
+    } // namespace client
+} // namespace logipad
@@ -0,0 +1,170 @@
+/**
+ * @file LPUserSearch.hpp
+ * @brief Fuzzy user search by name and email
+ * @details This file declares the UserSearchIndex class, a trigram index over the
+ *          name, full_name and email fields of cached tenant directories. Texts are
+ *          folded before indexing: ASCII letters become lower case, Latin diacritics
+ *          are removed ("Kovács" and "KOVACS" both become "kovacs") and punctuation
+ *          separates words, so "kovacs@logi" finds "p.kovacs@logipad.net".
+ *
+ * Every trigram has a posting list of the users containing it, stored as compressed
+ * bitmaps: users are numbered across all tenants, and each block of 65536 numbers is
+ * kept either as a sorted array of 16-bit offsets or, once dense, as a bitset. A
+ * query only touches the postings of its own trigrams, so it takes milliseconds even
+ * over hundreds of thousands of users.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <LPLogipadClient.hpp>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class LazyUsers;
+
+        /**
+         * @class UserSearchIndex
+         * @brief Trigram index for fuzzy search over several tenant directories
+         * @details Searches may run concurrently; adding directories may not.
+         */
+        class UserSearchIndex
+        {
+        public:
+            /**
+             * @struct Options
+             * @brief Search settings
+             */
+            struct Options
+            {
+                double minSimilarity = 0.5; ///< Share of query trigrams a field must contain to be a hit
+            };
+
+            /**
+             * @struct Hit
+             * @brief User found by a search
+             */
+            struct Hit
+            {
+                std::string tenant;             ///< Tenant the user belongs to
+                std::size_t row = 0;            ///< Row of the user in the directory added for the tenant
+                UserField field = UserField::Name; ///< Best matching field
+                double similarity = 0;          ///< Share of query trigrams found in the field
+                bool exact = false;             ///< The field contains the folded query as a whole
+            };
+
+            /**
+             * @brief Construct a new UserSearchIndex
+             * @param options Search settings
+             */
+            explicit UserSearchIndex(const Options &options);
+
+            /**
+             * @brief Construct a UserSearchIndex with default settings
+             */
+            UserSearchIndex();
+
+            /**
+             * @brief Get the fields the index reads
+             * @return name, full_name and email
+             */
+            static UserFieldMask fields();
+
+            /**
+             * @brief Fold a text for searching
+             * @param text UTF-8 text
+             * @param out Receives the folded text (the buffer is reused)
+             * @details ASCII letters are lowered, Latin-1 and Latin Extended-A letters are
+             *          replaced by their base letters (ß becomes "ss"), combining marks are
+             *          dropped and runs of other ASCII characters become a single space.
+             *          Other characters are kept unchanged.
+             */
+            static void fold(std::string_view text, std::string &out);
+
+            /**
+             * @brief Index the users of a tenant directory
+             * @param tenant Tenant reported in hits
+             * @param users Users; name, full_name and email are read
+             */
+            void add(const std::string &tenant, const std::vector<LogipadClient::User> &users);
+
+            /**
+             * @brief Index the users of a lazily decoded tenant directory
+             * @param tenant Tenant reported in hits
+             * @param users Users; only name, full_name and email are decoded
+             */
+            void add(const std::string &tenant, const LazyUsers &users);
+
+            /**
+             * @brief Search all indexed tenants
+             * @param query Name or email fragment; after folding, one or two characters
+             *              match the start of a word, longer queries match anywhere
+             * @param hits Receives at most limit hits, exact hits first, then by descending
+             *             similarity and ascending field length
+             * @param limit Maximum number of hits
+             * @return true on success, false if the query has no letter or digit
+             *         (see getLastError())
+             */
+            bool search(std::string_view query, std::vector<Hit> &hits, std::size_t limit = 20) const;
+
+            /**
+             * @brief Get the number of indexed users
+             * @return Users over all tenants
+             */
+            std::size_t size() const { return m_docs.size(); }
+
+            /**
+             * @brief Get the number of distinct trigrams
+             * @return Posting lists in the index
+             */
+            std::size_t trigrams() const { return m_postings.size(); }
+
+            /**
+             * @brief Get the last error message
+             * @return Error message string
+             */
+            const std::string &getLastError() const { return m_lastError; }
+
+        private:
+            // Users of one 65536-number block: sorted offsets, or a bitset once dense
+            struct Container
+            {
+                std::uint16_t block = 0;
+                std::vector<std::uint16_t> offsets;
+                std::vector<std::uint64_t> bits;
+            };
+
+            struct Doc
+            {
+                std::uint32_t tenant; ///< Index into m_tenants
+                std::uint32_t row;
+                std::uint32_t text;   ///< Offset of the first field in m_text
+            };
+
+            Options m_options;
+            std::vector<std::string> m_tenants;
+            std::vector<Doc> m_docs;
+            std::string m_text; ///< Folded fields, space-padded, one after another per user
+            std::vector<std::uint32_t> m_ends; ///< End offset in m_text of every field of every user
+            std::unordered_map<std::uint32_t, std::vector<Container>> m_postings;
+            mutable std::string m_lastError;
+
+            template <typename Source>
+            void load(const std::string &tenant, const Source &users, std::size_t count);
+
+            std::string_view field(std::size_t doc, std::size_t index) const;
+        };
+
+    } // namespace client
+} // namespace logipad
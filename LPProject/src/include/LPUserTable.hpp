@@ -0,0 +1,158 @@
+/**
+ * @file LPUserTable.hpp
+ * @brief Columnar representation of a user directory
+ * @details This file declares the UserTable class. Each user field is stored as its
+ *          own column: text fields dictionary-encoded (one integer code per user and
+ *          one copy of every distinct value), timestamp fields additionally as epoch
+ *          seconds, and boolean fields as one byte per user. Scans over a column touch
+ *          contiguous memory only, which is what the query engine and the analytics
+ *          operate on.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <LPLogipadClient.hpp>
+#include <LPUserFields.hpp>
+
+namespace logipad
+{
+    namespace client
+    {
+
+        class LazyUsers;
+
+        /**
+         * @brief Check whether a field holds a timestamp
+         * @param field Field to check
+         * @return true for created_at, modified_at and the last_* activity fields
+         */
+        bool isTimestampField(UserField field);
+
+        /**
+         * @brief Parse an ISO 8601 timestamp
+         * @param text Timestamp such as "2025-06-28T08:00:00Z", "2025-06-28T08:00:00.123+02:00"
+         *             or a plain date "2025-06-28" (midnight UTC)
+         * @param seconds Receives the seconds since the Unix epoch (UTC); fractions are dropped
+         * @return true if the text is a valid timestamp
+         */
+        bool parseTimestamp(std::string_view text, std::int64_t &seconds);
+
+        /**
+         * @class UserTable
+         * @brief Column-oriented, immutable snapshot of a user list
+         * @details Only the fields selected when building are stored. Rows keep the order
+         *          of the source list.
+         */
+        class UserTable
+        {
+        public:
+            /// Epoch value of missing or unparsable timestamps
+            static constexpr std::int64_t kNoTime = std::numeric_limits<std::int64_t>::min();
+
+            /**
+             * @struct TextColumn
+             * @brief Dictionary-encoded text column
+             * @details Code 0 means the field is missing; dictionary[0] is an empty placeholder.
+             */
+            struct TextColumn
+            {
+                std::vector<std::uint32_t> codes;   ///< Dictionary code per row
+                std::vector<std::string> dictionary; ///< Distinct values by code
+            };
+
+            /**
+             * @brief Build the table from decoded users
+             * @param users Source users
+             * @param fields Fields to store (default: all fields)
+             */
+            void build(const std::vector<LogipadClient::User> &users, const UserFieldMask &fields = UserFieldMask::all());
+
+            /**
+             * @brief Build the table from lazily decoded users
+             * @param users Source users; only the selected fields are decoded
+             * @param fields Fields to store (default: all fields)
+             */
+            void build(const LazyUsers &users, const UserFieldMask &fields = UserFieldMask::all());
+
+            /**
+             * @brief Get the number of rows
+             * @return Number of users
+             */
+            std::size_t size() const { return m_rows; }
+
+            /**
+             * @brief Get the stored fields
+             * @return Fields selected when building
+             */
+            const UserFieldMask &fields() const { return m_fields; }
+
+            /**
+             * @brief Get a text column
+             * @param field Any non-boolean field
+             * @return Column, or nullptr if the field is boolean or was not stored
+             */
+            const TextColumn *text(UserField field) const;
+
+            /**
+             * @brief Get a timestamp column
+             * @param field Timestamp field
+             * @return Epoch seconds per row (kNoTime if missing), or nullptr if not stored
+             */
+            const std::vector<std::int64_t> *times(UserField field) const;
+
+            /**
+             * @brief Get a boolean column
+             * @param field is_active or is_reportable
+             * @return One byte (0 or 1) per row, or nullptr if not stored
+             */
+            const std::vector<std::uint8_t> *flags(UserField field) const;
+
+            /**
+             * @brief Read a cell
+             * @param field Field to read
+             * @param row Row index
+             * @return Value as in the API; booleans yield "true" or "false"
+             */
+            std::optional<std::string_view> get(UserField field, std::size_t row) const;
+
+            /**
+             * @brief Access a row
+             * @param row Row index
+             * @return Lightweight row view providing get(UserField)
+             * @details Lets the table be used wherever a user list is formatted.
+             */
+            class Row
+            {
+            public:
+                Row(const UserTable *table, std::size_t row) : m_table(table), m_row(row) {}
+                std::optional<std::string_view> get(UserField field) const { return m_table->get(field, m_row); }
+
+            private:
+                const UserTable *m_table;
+                std::size_t m_row;
+            };
+
+            Row operator[](std::size_t row) const { return Row(this, row); }
+
+        private:
+            std::size_t m_rows = 0;
+            UserFieldMask m_fields;
+            std::vector<TextColumn> m_text;                 ///< Indexed by UserField
+            std::vector<std::vector<std::int64_t>> m_times; ///< Indexed by UserField
+            std::vector<std::vector<std::uint8_t>> m_flags; ///< Indexed by UserField
+
+            template <typename Source>
+            void load(const Source &users, std::size_t count, const UserFieldMask &fields);
+        };
+
+    } // namespace client
+} // namespace logipad
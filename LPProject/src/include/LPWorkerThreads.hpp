@@ -0,0 +1,35 @@
+/**
+ * @file LPWorkerThreads.hpp
+ * @brief Running independent tasks on short-lived worker threads
+ * @details This file declares runTasks(), which the parallel loops of the project use
+ *          instead of starting and joining std::thread objects themselves. It makes sure
+ *          that no joinable thread is ever destroyed: if the system cannot start another
+ *          thread, the remaining tasks run on the calling thread.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace logipad
+{
+    namespace core
+    {
+
+        /**
+         * @brief Run tasks on worker threads and the calling thread
+         * @param count Number of tasks
+         * @param task Called once with every index in [0, count); must not throw when
+         *             run on a worker thread
+         * @details Task 0 runs on the calling thread, every other task on a thread of its
+         *          own. If a thread cannot be started, its task and all later ones run on
+         *          the calling thread after task 0. All started threads are joined before
+         *          returning, also if a task on the calling thread throws.
+         */
+        void runTasks(std::size_t count, const std::function<void(std::size_t)> &task);
+
+    } // namespace core
+} // namespace logipad
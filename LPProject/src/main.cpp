@@ -11,25 +11,175 @@
  * @section Usage
  * The application performs the following operations:
  * 1. Authenticates with Keycloak using logipad::auth::KeycloakClient
- * 2. Creates a test user in Keycloak
+ * 2. Creates a test user in Keycloak (steps 1 and 2 are skipped with `--export`)
  * 3. Authenticates with Keycloak using logipad::client::LogipadClient
- * 4. Retrieves all users from the Logipad identity service
+ * 4. Retrieves all users from the Logipad identity service and lists or exports them
+ *
+ * @section Commands
+ * - `list-users` (default) prints the users as a table on standard output
+ * - `reconcile-accounts` matches Logipad users to the Keycloak accounts of the realm (by email,
+ *   then username) and prints the unmatched users and accounts
+ * - `license-report` prints inactive-user and per-service activity figures of reportable users, per department
+ * - `find-users <query>` fuzzy-searches the users by name, full name and email fragments, ignoring case
+ *   and diacritics (e.g. `find-users kovacs`)
+ * - `complete-users <prefix>` prints the first users whose name, three-letter code or full name
+ *   starts with the prefix
+ * - `provision <roster.csv>` creates the Keycloak users of a CSV roster (columns username, email,
+ *   firstName, lastName, password) with a write-ahead journal; transient failures are retried,
+ *   users that still fail are written to a dead-letter file
+ * - `redrive <roster.csv>` creates the users of the roster's dead-letter file again in batches and
+ *   keeps only those that still fail; passwords are taken from the roster
+ *
+ * @section Options
+ * - `--record <file>` records every HTTP exchange of both clients to a cassette file
+ * - `--replay <file>` replays a cassette file with the original timing, without network access
+ * - `--fast` replays the cassette as fast as possible (use together with `--replay`)
+ * - `--cache <dir>` keeps GET responses in an on-disk cache and revalidates them with conditional requests
+ * - `--hedge <percentile>` sends a second attempt of a GET that has not been answered within this
+ *   percentile of the observed latency (e.g. `--hedge 95`); the first response wins
+ * - `--export <file>` exports all users instead of listing them (`-` for standard output, `.gz` suffix compresses)
+ * - `--format <csv|ndjson|binary>` selects the export format (default: csv)
+ * - `--columns <fields>` comma-separated columns for list-users (default: guid,name,email)
+ * - `--layout <fixed|tsv>` table layout for list-users (default: fixed)
+ * - `--sort <field>` sorts the listing by a field; `--desc` reverses the order
+ * - `--sketches <file>` with license-report: adds the snapshot to a file of daily active-user
+ *   sketches and prints distinct active users of the last 1, 7 and 30 days per activity
+ * - `--history <file>` with license-report: appends the activity changes since the last run to a
+ *   history file and prints the users deactivated within the last 7 days
+ * - `--journal <file>` with provision: journal file (default: the roster path with ".journal" appended)
+ * - `--resume` with provision: continue the run recorded in the journal instead of starting over
+ * - `--dead-letters <file>` with provision and redrive: dead-letter file (default: the roster path with ".dead" appended)
+ * - `--deadline <seconds>` with provision and redrive: stop the run after this time (resume it later)
+ * - `--entry-timeout <seconds>` with provision and redrive: give up on a user after this time, retries included
+ * - `--filter <expr>` lists only users matching a filter expression,
+ *   e.g. `is_active && department == "Flight Ops" && last_login_at < now-90d`
+ *
+ * Ctrl+C during provision or redrive cancels the run: the request in flight is aborted and
+ * the journal and dead-letter file stay consistent.
  *
  * @note This is a demonstration/example application showcasing the client libraries.
  */
 
+#include <chrono>
+#include <csignal>
+#include <filesystem>
 #include <iostream>
+#include <thread>
 #include <LPHelperObject.hpp>
 #include <LPLogipadClient.hpp>
+#include <LPLazyUsers.hpp>
 #include <LPKeyCloakClient.hpp>
+#include <LPCassetteTransport.hpp>
+#include <LPCachingTransport.hpp>
+#include <LPHedgingTransport.hpp>
+#include <LPBulkProvisioner.hpp>
+#include <LPUserExporter.hpp>
+#include <LPUserListing.hpp>
+#include <LPAccountMatcher.hpp>
+#include <LPActivityHistory.hpp>
+#include <LPActivitySketches.hpp>
+#include <LPUserAnalytics.hpp>
+#include <LPPrefixIndex.hpp>
+#include <LPUserFilter.hpp>
+#include <LPUserSearch.hpp>
+#include <LPUserTable.hpp>
 #include <Version.hpp>
 #include <httplib.h>
 #include <nlohmann/json.hpp> // For JSON parsing
 
 // Using declarations for cleaner code
+using logipad::auth::BulkProvisioner;
 using logipad::auth::KeycloakClient;
+using logipad::client::AccountMatcher;
+using logipad::client::ActivityHistory;
+using logipad::client::ActivitySketches;
+using logipad::client::LazyUsers;
 using logipad::client::LogipadClient;
+using logipad::client::PrefixIndex;
+using logipad::client::ExportFormat;
+using logipad::client::UserAnalytics;
+using logipad::client::UserExporter;
+using logipad::client::UserField;
+using logipad::client::UserFieldMask;
+using logipad::client::UserFilter;
+using logipad::client::UserListing;
+using logipad::client::UserSearchIndex;
+using logipad::client::UserTable;
 using logipad::core::HelperObject;
+using logipad::net::Cassette;
+using logipad::net::LatencyTracker;
+using logipad::net::ResponseCache;
+
+namespace
+{
+    volatile std::sig_atomic_t interrupted = 0;
+
+    // SIGINT handler; only sets the flag polled by watchInterrupt()
+    void onInterrupt(int)
+    {
+        interrupted = 1;
+    }
+
+    /**
+     * @brief Cancel a token on Ctrl+C
+     * @param token Token to cancel
+     * @return Thread polling for the signal until it is destroyed
+     * @details Cancelling runs callbacks that are not async-signal-safe, so it happens on
+     *          this thread instead of in the signal handler.
+     */
+    std::jthread watchInterrupt(logipad::net::CancellationToken token)
+    {
+        std::signal(SIGINT, onInterrupt);
+        return std::jthread([token](std::stop_token stop)
+                            {
+                                while (!stop.stop_requested())
+                                {
+                                    if (interrupted)
+                                    {
+                                        std::cerr << "Interrupted, stopping..." << std::endl;
+                                        token.cancel();
+                                        return;
+                                    }
+                                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                                } });
+    }
+
+    /**
+     * @brief Report a failed cassette recording when the run ends
+     * @details Recording errors do not fail the requests, so they are only reported
+     *          once the run returns or throws.
+     */
+    struct CassetteReport
+    {
+        std::shared_ptr<Cassette> cassette;
+
+        ~CassetteReport()
+        {
+            if (cassette && cassette->getMode() == Cassette::Mode::Record && !cassette->getLastError().empty())
+            {
+                std::cerr << cassette->getLastError() << std::endl;
+            }
+        }
+    };
+
+    // Parse a positive number of seconds
+    std::chrono::milliseconds parseSeconds(const std::string &arg, const std::string &value)
+    {
+        double seconds = 0;
+        try
+        {
+            seconds = std::stod(value);
+        }
+        catch (const std::exception &)
+        {
+        }
+        if (!(seconds > 0))
+        {
+            throw std::runtime_error("Invalid number of seconds for " + arg + ": " + value);
+        }
+        return std::chrono::milliseconds(static_cast<std::int64_t>(seconds * 1000));
+    }
+} // namespace
 
 /**
  * @brief Protected main function that executes application logic
@@ -42,20 +192,222 @@ using logipad::core::HelperObject;
  *          - User creation in Keycloak
  *          - Logipad client authentication using logipad::client::LogipadClient
  *          - User retrieval from Logipad identity service
- * @note Command-line arguments are currently unused but reserved for future functionality.
+ * @throws std::runtime_error on invalid arguments or if the cassette or cache cannot be opened
  */
 int protected_main(int argc, char *argv[])
 {
-    (void)argc; // Reserved for future command-line argument processing
-    (void)argv; // Reserved for future command-line argument processing
-
-    // Example for Argument Processing
-    // For now, we are not using any arguments, so we are not processing them.
-    // if (argc < 2) {
-    //    throw std::runtime_error("No input argument provided");
-    //}
-    // std::cout << "Program argument: " << argv[1] << std::endl;
-    //
+    // Argument processing
+    std::string recordPath;
+    std::string replayPath;
+    std::string cachePath;
+    std::string exportPath;
+    ExportFormat exportFormat = ExportFormat::Csv;
+    UserListing::Options listing;
+    UserFilter filter;
+    bool filtered = false;
+    bool licenseReport = false;
+    bool reconcile = false;
+    std::string searchQuery;
+    std::string completePrefix;
+    std::string rosterPath;
+    std::string redriveRosterPath;
+    BulkProvisioner::Options provisioning;
+    std::string sketchPath;
+    std::string historyPath;
+    bool replayFast = false;
+    double hedgePercentile = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "list-users")
+        {
+            // Default command
+        }
+        else if (arg == "license-report")
+        {
+            licenseReport = true;
+        }
+        else if (arg == "reconcile-accounts")
+        {
+            reconcile = true;
+        }
+        else if (arg == "find-users" && i + 1 < argc)
+        {
+            searchQuery = argv[++i];
+        }
+        else if (arg == "complete-users" && i + 1 < argc)
+        {
+            completePrefix = argv[++i];
+        }
+        else if (arg == "provision" && i + 1 < argc)
+        {
+            rosterPath = argv[++i];
+        }
+        else if (arg == "redrive" && i + 1 < argc)
+        {
+            redriveRosterPath = argv[++i];
+        }
+        else if (arg == "--dead-letters" && i + 1 < argc)
+        {
+            provisioning.deadLetterPath = argv[++i];
+        }
+        else if (arg == "--journal" && i + 1 < argc)
+        {
+            provisioning.journalPath = argv[++i];
+        }
+        else if (arg == "--resume")
+        {
+            provisioning.resume = true;
+        }
+        else if (arg == "--deadline" && i + 1 < argc)
+        {
+            provisioning.call.deadline = logipad::net::Deadline::after(parseSeconds(arg, argv[++i]));
+        }
+        else if (arg == "--entry-timeout" && i + 1 < argc)
+        {
+            provisioning.entryTimeout = parseSeconds(arg, argv[++i]);
+        }
+        else if (arg == "--columns" && i + 1 < argc)
+        {
+            std::string names = argv[++i];
+            if (!UserListing::columnsFromNames(names, listing.columns) || listing.columns.empty())
+            {
+                throw std::runtime_error("Invalid column list: " + names);
+            }
+        }
+        else if (arg == "--layout" && i + 1 < argc)
+        {
+            std::string layout = argv[++i];
+            if (layout != "fixed" && layout != "tsv")
+            {
+                throw std::runtime_error("Unknown layout: " + layout);
+            }
+            listing.layout = layout == "tsv" ? UserListing::Layout::Tsv : UserListing::Layout::Fixed;
+        }
+        else if (arg == "--sort" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            UserField field;
+            if (!logipad::client::userFieldFromName(name, field))
+            {
+                throw std::runtime_error("Unknown sort field: " + name);
+            }
+            listing.sortBy = field;
+        }
+        else if (arg == "--filter" && i + 1 < argc)
+        {
+            if (!filter.compile(argv[++i]))
+            {
+                throw std::runtime_error("Invalid filter: " + filter.getLastError());
+            }
+            filtered = true;
+        }
+        else if (arg == "--sketches" && i + 1 < argc)
+        {
+            sketchPath = argv[++i];
+        }
+        else if (arg == "--history" && i + 1 < argc)
+        {
+            historyPath = argv[++i];
+        }
+        else if (arg == "--desc")
+        {
+            listing.descending = true;
+        }
+        else if ((arg == "--record" || arg == "--replay") && i + 1 < argc)
+        {
+            (arg == "--record" ? recordPath : replayPath) = argv[++i];
+        }
+        else if (arg == "--cache" && i + 1 < argc)
+        {
+            cachePath = argv[++i];
+        }
+        else if (arg == "--hedge" && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            try
+            {
+                hedgePercentile = std::stod(value);
+            }
+            catch (const std::exception &)
+            {
+                hedgePercentile = 0;
+            }
+            if (!(hedgePercentile > 0 && hedgePercentile < 100))
+            {
+                throw std::runtime_error("Invalid hedge percentile: " + value);
+            }
+        }
+        else if (arg == "--export" && i + 1 < argc)
+        {
+            exportPath = argv[++i];
+        }
+        else if (arg == "--format" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if (!logipad::client::exportFormatFromName(name, exportFormat))
+            {
+                throw std::runtime_error("Unknown export format: " + name);
+            }
+        }
+        else if (arg == "--fast")
+        {
+            replayFast = true;
+        }
+        else
+        {
+            throw std::runtime_error("Invalid argument: " + arg);
+        }
+    }
+
+    if (!recordPath.empty() && !replayPath.empty())
+    {
+        throw std::runtime_error("--record and --replay are mutually exclusive");
+    }
+
+    // Optional cassette shared by both clients
+    std::shared_ptr<Cassette> cassette;
+    if (!recordPath.empty())
+    {
+        cassette = std::make_shared<Cassette>(recordPath, Cassette::Mode::Record);
+    }
+    else if (!replayPath.empty())
+    {
+        cassette = std::make_shared<Cassette>(
+            replayPath,
+            Cassette::Mode::Replay,
+            replayFast ? Cassette::Timing::AsFastAsPossible : Cassette::Timing::Original);
+    }
+    if (cassette && !cassette->open())
+    {
+        throw std::runtime_error(cassette->getLastError());
+    }
+    CassetteReport cassetteReport{cassette};
+
+    // Transports shared by both clients: optional response cache on top of the cassette, which
+    // records one exchange per request even if the network request below it was hedged
+    logipad::net::TransportFactory transportFactory = logipad::net::httpTransportFactory();
+    if (hedgePercentile > 0)
+    {
+        LatencyTracker::Options hedging;
+        hedging.percentile = hedgePercentile;
+        transportFactory = logipad::net::hedgingTransportFactory(std::make_shared<LatencyTracker>(hedging), transportFactory);
+    }
+    if (cassette)
+    {
+        transportFactory = logipad::net::cassetteTransportFactory(cassette, transportFactory);
+    }
+    if (!cachePath.empty())
+    {
+        auto cache = std::make_shared<ResponseCache>(cachePath);
+        if (!cache->open())
+        {
+            throw std::runtime_error(cache->getLastError());
+        }
+        transportFactory = logipad::net::cachingTransportFactory(cache, transportFactory);
+    }
+    bool customTransport = cassette || !cachePath.empty() || hedgePercentile > 0;
+
     // Define the realm
     const std::string &realm = "Logipad";
 
@@ -67,24 +419,100 @@ int protected_main(int argc, char *argv[])
         "dd-admin",
         "xROv+Js$L2\\&RyCuexk$A5Kn" // if the password contains a backslash, it must be escaped!!
     );
+    if (customTransport)
+    {
+        lpkcclient.setTransportFactory(transportFactory);
+    }
 
-    // Authenticate
-    if (lpkcclient.authenticate())
+    if (!rosterPath.empty())
     {
+        // provision: create the roster's users, journaling every attempt
+        std::vector<KeycloakClient::UserInfo> roster;
+        std::string error;
+        if (!BulkProvisioner::loadRoster(rosterPath, roster, error))
+        {
+            throw std::runtime_error(error);
+        }
+        if (provisioning.journalPath.empty())
+        {
+            provisioning.journalPath = rosterPath + ".journal";
+        }
+        if (provisioning.deadLetterPath.empty())
+        {
+            provisioning.deadLetterPath = rosterPath + ".dead";
+        }
+        BulkProvisioner provisioner(lpkcclient, provisioning);
+        BulkProvisioner::Summary summary;
+        auto watcher = watchInterrupt(provisioning.call.cancel);
+        bool complete = provisioner.run(roster, realm, summary);
+        std::cout << "Created: " << summary.created << ", already existing: " << summary.existed << ", failed: " << summary.failed
+                  << ", finished earlier: " << summary.finished << std::endl;
+        const auto &entries = provisioner.entries();
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            if (entries[i].state == logipad::auth::ProvisioningJournal::State::Failed)
+            {
+                std::cout << "  " << roster[i].username << ": " << entries[i].message << std::endl;
+            }
+        }
+        if (!complete)
+        {
+            throw std::runtime_error(provisioner.getLastError() + " (rerun with --resume)");
+        }
+        if (summary.failed > 0)
+        {
+            std::cout << "Failed users were written to " << provisioning.deadLetterPath << std::endl;
+        }
+        return 0;
+    }
 
-        std::cout << "Access Token: " << lpkcclient.getAccessToken() << std::endl;
-        if (lpkcclient.createUser(KeycloakClient::UserInfo("aaaaa", "testuser@test.com", "Test", "User", "testpassword"), realm))
+    if (!redriveRosterPath.empty())
+    {
+        // redrive: create the users of the roster's dead-letter file again
+        std::vector<KeycloakClient::UserInfo> roster;
+        std::string error;
+        if (!BulkProvisioner::loadRoster(redriveRosterPath, roster, error))
         {
-            std::cout << "User created successfully" << std::endl;
+            throw std::runtime_error(error);
         }
-        else
+        if (provisioning.deadLetterPath.empty())
+        {
+            provisioning.deadLetterPath = redriveRosterPath + ".dead";
+        }
+        BulkProvisioner provisioner(lpkcclient, provisioning);
+        BulkProvisioner::Summary summary;
+        auto watcher = watchInterrupt(provisioning.call.cancel);
+        bool complete = provisioner.redrive(roster, summary);
+        std::cout << "Created: " << summary.created << ", already existing: " << summary.existed << ", still failing: " << summary.failed
+                  << std::endl;
+        if (!complete)
         {
-            std::cerr << "Failed to create user" << std::endl;
+            throw std::runtime_error(provisioner.getLastError());
         }
+        return 0;
     }
-    else
+
+    // Authenticate and create the test user; skipped when exporting, where standard
+    // output may carry the export
+    if (exportPath.empty())
     {
-        std::cerr << "Failed to authenticate" << std::endl;
+        if (lpkcclient.authenticate())
+        {
+            // The token grants admin access until it expires, so it is never printed
+            std::cout << "Authenticated with Keycloak" << std::endl;
+            if (lpkcclient.createUser(KeycloakClient::UserInfo("aaaaa", "testuser@test.com", "Test", "User", "testpassword"), realm))
+            {
+                std::cout << "User created successfully" << std::endl;
+            }
+            else
+            {
+                std::cerr << "Failed to create user" << std::endl;
+            }
+        }
+        else
+        {
+            std::cerr << "Failed to authenticate" << std::endl;
+        }
     }
 
     // Create the Logipad client
@@ -95,32 +523,224 @@ int protected_main(int argc, char *argv[])
         "lpclient",
         "sysadm",
         "u2UkY4uBZk5uCscWCBpoh7nK");
+    if (customTransport)
+    {
+        client.setTransportFactory(transportFactory);
+    }
 
     // Authenticate first
-    if (client.authenticate())
+    if (client.authenticate() && !exportPath.empty())
+    {
+        // Export every field of every user; fields are decoded only while formatting
+        LazyUsers users;
+        if (!client.getAllUsers(users, "identity.demo.prod.logipad.net", client.m_port))
+        {
+            std::cerr << "Failed to retrieve users: " << client.getLastError() << std::endl;
+            return 0;
+        }
+
+        UserExporter::Options options;
+        options.format = exportFormat;
+        options.gzip = exportPath.size() > 3 && exportPath.compare(exportPath.size() - 3, 3, ".gz") == 0;
+        options.threads = 0;
+        UserExporter exporter(options);
+        if (!exporter.exportToFile(users, exportPath))
+        {
+            throw std::runtime_error(exporter.getLastError());
+        }
+        std::cerr << "Exported " << users.size() << " users (" << exporter.getBytesWritten() << " bytes)" << std::endl;
+    }
+    else if (client.isAuthenticated() && reconcile)
+    {
+        // reconcile-accounts: join both directories in memory
+        std::vector<KeycloakClient::Account> accounts;
+        if (!lpkcclient.listUsers(accounts, realm))
+        {
+            throw std::runtime_error(lpkcclient.getLastError());
+        }
+        LazyUsers users;
+        if (!client.getAllUsers(users, "identity.demo.prod.logipad.net", client.m_port, AccountMatcher::fields()))
+        {
+            std::cerr << "Failed to retrieve users: " << client.getLastError() << std::endl;
+            return 0;
+        }
+
+        AccountMatcher matcher;
+        AccountMatcher::Result result;
+        matcher.match(users, accounts, result);
+        std::cout << "Matched: " << result.matched.size() << std::endl;
+        std::cout << "Logipad users without Keycloak account: " << result.usersOnly.size() << std::endl;
+        for (std::size_t i : result.usersOnly)
+        {
+            std::cout << "  " << users[i].get(UserField::Name).value_or("") << " <" << users[i].get(UserField::Email).value_or("") << ">" << std::endl;
+        }
+        std::cout << "Keycloak accounts without Logipad user: " << result.accountsOnly.size() << std::endl;
+        for (std::size_t i : result.accountsOnly)
+        {
+            std::cout << "  " << accounts[i].username << " <" << accounts[i].email << ">" << std::endl;
+        }
+    }
+    else if (client.isAuthenticated() && !searchQuery.empty())
+    {
+        // find-users: index the searchable fields and rank the matches
+        const std::string tenant = "identity.demo.prod.logipad.net";
+        LazyUsers users;
+        if (!client.getAllUsers(users, tenant, client.m_port, UserSearchIndex::fields()))
+        {
+            std::cerr << "Failed to retrieve users: " << client.getLastError() << std::endl;
+            return 0;
+        }
+        UserSearchIndex index;
+        index.add(tenant, users);
+        std::vector<UserSearchIndex::Hit> hits;
+        if (!index.search(searchQuery, hits))
+        {
+            throw std::runtime_error(index.getLastError());
+        }
+        for (const auto &hit : hits)
+        {
+            auto &&user = users[hit.row];
+            std::cout << static_cast<int>(hit.similarity * 100 + 0.5) << "%" << (hit.exact ? " " : "~ ")
+                      << user.get(UserField::Name).value_or("") << "  " << user.get(UserField::FullName).value_or("")
+                      << " <" << user.get(UserField::Email).value_or("") << ">" << std::endl;
+        }
+        std::cerr << hits.size() << " of " << index.size() << " users found" << std::endl;
+    }
+    else if (client.isAuthenticated() && !completePrefix.empty())
+    {
+        // complete-users: typeahead over the front-coded prefix index
+        LazyUsers users;
+        if (!client.getAllUsers(users, "identity.demo.prod.logipad.net", client.m_port, PrefixIndex::fields()))
+        {
+            std::cerr << "Failed to retrieve users: " << client.getLastError() << std::endl;
+            return 0;
+        }
+        PrefixIndex index;
+        index.build(users);
+        std::vector<PrefixIndex::Completion> completions;
+        index.complete(completePrefix, completions);
+        for (const auto &completion : completions)
+        {
+            auto &&user = users[completion.user];
+            std::cout << user.get(completion.field).value_or("") << "  (" << logipad::client::userFieldName(completion.field)
+                      << " of " << user.get(UserField::Name).value_or("") << ")" << std::endl;
+        }
+    }
+    else if (client.isAuthenticated() && licenseReport)
+    {
+        // license-report: fetch only the activity columns and analyze them in one pass
+        const std::string tenant = "identity.demo.prod.logipad.net";
+        UserFieldMask fields = UserAnalytics::fields();
+        for (UserField field : ActivitySketches::fields().toFields())
+        {
+            fields.add(field);
+        }
+        for (UserField field : ActivityHistory::fields().toFields())
+        {
+            fields.add(field);
+        }
+        LazyUsers users;
+        if (!client.getAllUsers(users, tenant, client.m_port, fields))
+        {
+            std::cerr << "Failed to retrieve users: " << client.getLastError() << std::endl;
+            return 0;
+        }
+        UserTable columns;
+        columns.build(users, fields);
+        UserAnalytics analytics(UserAnalytics::Options{});
+        UserAnalytics::Report report;
+        if (!analytics.analyze(columns, report))
+        {
+            throw std::runtime_error(analytics.getLastError());
+        }
+        std::cout << UserAnalytics::format(report);
+        std::cerr << report.excluded << " non-reportable users excluded" << std::endl;
+
+        if (!sketchPath.empty())
+        {
+            // Keep a year of daily sketches; a missing file starts a new history
+            ActivitySketches sketches;
+            if (std::filesystem::exists(sketchPath) && !sketches.load(sketchPath))
+            {
+                throw std::runtime_error(sketches.getLastError());
+            }
+            std::int64_t today = ActivitySketches::dayOf(report.now);
+            sketches.prune(today - 365);
+            if (!sketches.record(tenant, columns) || !sketches.save(sketchPath))
+            {
+                throw std::runtime_error(sketches.getLastError());
+            }
+
+            const std::pair<const char *, ActivitySketches::Activity> activities[] = {
+                {"any", ActivitySketches::Activity::Any},
+                {"document", ActivitySketches::Activity::Document},
+                {"eform", ActivitySketches::Activity::Eform},
+                {"briefing", ActivitySketches::Activity::Briefing}};
+            std::cout << "\nactivity  DAU  WAU  MAU" << std::endl;
+            for (const auto &[name, activity] : activities)
+            {
+                std::cout << name << "  " << sketches.estimate(tenant, activity, today, today)
+                          << "  " << sketches.estimate(tenant, activity, today - 6, today)
+                          << "  " << sketches.estimate(tenant, activity, today - 29, today) << std::endl;
+            }
+        }
+
+        if (!historyPath.empty())
+        {
+            ActivityHistory history;
+            if (!history.open(historyPath) || !history.record(columns, report.now))
+            {
+                throw std::runtime_error(history.getLastError());
+            }
+            std::vector<std::string> deactivated;
+            history.transitions(false, report.now - 7 * 86400, report.now, deactivated);
+            std::cerr << history.getLastChangeCount() << " activity changes recorded" << std::endl;
+            std::cout << "\nDeactivated within 7 days: " << deactivated.size() << std::endl;
+            for (const std::string &guid : deactivated)
+            {
+                std::cout << guid << std::endl;
+            }
+        }
+    }
+    else if (client.isAuthenticated())
     {
-        // Get all users
-        LogipadClient::Users users;
-        if (client.getAllUsers(users, "identity.demo.prod.logipad.net", client.m_port))
+        // list-users: fetch only the listed fields and decode them lazily
+        UserListing table(listing);
+        UserFieldMask fields = table.fields();
+        for (UserField field : filter.fields().toFields())
         {
-            std::cout << "Retrieved " << users.users.size() << " users" << std::endl;
-            for (const auto &user : users.users)
+            fields.add(field);
+        }
+        LazyUsers users;
+        if (client.getAllUsers(users, "identity.demo.prod.logipad.net", client.m_port, fields))
+        {
+            std::cerr << "Retrieved " << users.size() << " users" << std::endl;
+            bool written;
+            if (filtered)
             {
-                std::cout << "User: " << user.guid << " ";
-                if (user.name.has_value())
+                // Load the needed fields into columns once and select the matching rows
+                UserTable columns;
+                columns.build(users, fields);
+                std::vector<std::uint32_t> rows;
+                if (!filter.evaluate(columns, rows))
                 {
-                    std::cout << user.name.value() << " ";
-                    if (user.email.has_value())
-                    {
-                        std::cout << " (" << user.email.value() << ")";
-                    }
+                    throw std::runtime_error(filter.getLastError());
                 }
-                std::cout << std::endl;
+                std::cerr << rows.size() << " users match the filter" << std::endl;
+                written = table.write(columns, rows, stdout);
+            }
+            else
+            {
+                written = table.write(users, stdout);
+            }
+            if (!written)
+            {
+                throw std::runtime_error("Failed to write user listing");
             }
         }
         else
         {
-            std::cerr << "Failed to retrieve users" << std::endl;
+            std::cerr << "Failed to retrieve users: " << client.getLastError() << std::endl;
         }
     }
     return 0;
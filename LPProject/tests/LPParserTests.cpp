@@ -0,0 +1,79 @@
+/**
+ * @file LPParserTests.cpp
+ * @brief Regression checks of the user list parsers
+ * @details Malformed /users bodies that were once accepted by one of the parsing
+ *          paths, or that left users behind. Both the lazy and the eager paths are
+ *          checked, the eager one with and without a projection. The program prints
+ *          the failed checks and exits with 1 if there are any.
+ * @author Dirk Leese
+ * @date 2025
+ */
+
+#include <LPJsonBackend.hpp>
+#include <LPLazyUsers.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    // Report a failed check
+    void check(bool condition, const std::string &name)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAILED: " << name << std::endl;
+            ++failures;
+        }
+    }
+
+    // Load a body lazily and expect it to be rejected
+    void expectLazyRejected(const std::string &body, const std::string &name)
+    {
+        logipad::client::LazyUsers users;
+        std::string error;
+        check(!users.load(body, error), name + ": accepted");
+        check(!error.empty(), name + ": no error message");
+        check(users.empty(), name + ": users left behind");
+    }
+
+    // Parse a body eagerly, with and without a projection, and expect it to be rejected
+    void expectEagerRejected(const std::string &body, const std::string &name)
+    {
+        using logipad::client::UserField;
+        using logipad::client::UserFieldMask;
+        for (const UserFieldMask &fields : {UserFieldMask::all(), UserFieldMask{UserField::Guid, UserField::Name}})
+        {
+            std::string variant = name + (fields.isAll() ? " (all fields)" : " (projection)");
+            std::vector<logipad::client::LogipadClient::User> users(1);
+            std::string error;
+            check(!logipad::json::Backend::parseUsers(body, users, error, fields), variant + ": accepted");
+            check(!error.empty(), variant + ": no error message");
+            check(users.size() == 1, variant + ": users left behind");
+        }
+    }
+} // namespace
+
+int main()
+{
+    // LazyUsers: trailing data and invalid escapes
+    expectLazyRejected(R"([{"guid":"a"}] junk)", "lazy array with trailing data");
+    expectLazyRejected(R"({"users":[{"guid":"a"}]} junk)", "lazy object with trailing data");
+    expectLazyRejected(R"([{"guid":"a","name":"bad\q"}])", "lazy invalid escape");
+
+    // Eager backends: trailing data and partially mapped users
+    expectEagerRejected(R"([{"guid":"a"}] junk)", "eager array with trailing data");
+    expectEagerRejected(R"({"users":[{"guid":"a"}]} junk)", "eager object with trailing data");
+    expectEagerRejected(R"([{"guid":"a"},])", "eager trailing comma");
+    expectEagerRejected(R"([{"guid":"a"},3])", "eager non-object element");
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return 0;
+}